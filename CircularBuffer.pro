@@ -12,9 +12,29 @@ SOURCES += \
         main.cpp
 
 HEADERS += \
+    include/circular_buffer/circular_buffer_auto_resize.h \
+    include/circular_buffer/circular_buffer_basic.h \
     include/circular_buffer/circular_buffer_blocked_mrmw.h \
+    include/circular_buffer/circular_buffer_combining_mrmw.h \
+    include/circular_buffer/circular_buffer_coro.h \
+    include/circular_buffer/circular_buffer_executor.h \
+    include/circular_buffer/circular_buffer_fanin_srmw.h \
     include/circular_buffer/circular_buffer_fwd.h \
     include/circular_buffer/circular_buffer_lockfree_mrmw.h \
-    include/circular_buffer/circular_buffer_lockfree_srsw.h
+    include/circular_buffer/circular_buffer_lockfree_srsw.h \
+    include/circular_buffer/circular_buffer_mmap.h \
+    include/circular_buffer/circular_buffer_numa.h \
+    include/circular_buffer/circular_buffer_partitioned_mrmw.h \
+    include/circular_buffer/circular_buffer_pmr.h \
+    include/circular_buffer/circular_buffer_policies.h \
+    include/circular_buffer/circular_buffer_sharded_mrmw.h \
+    include/circular_buffer/circular_buffer_spin.h \
+    include/circular_buffer/circular_buffer_staging.h \
+    include/circular_buffer/circular_buffer_stats.h \
+    include/circular_buffer/circular_buffer_storage.h \
+    include/circular_buffer/circular_buffer_token.h \
+    include/circular_buffer/circular_buffer_twolock_mrmw.h \
+    include/circular_buffer/circular_buffer_wait_status.h \
+    include/circular_buffer/circular_buffer_work_stealing.h
 
 INCLUDEPATH += $$PWD/include
@@ -0,0 +1,98 @@
+// Замер количества переключений контекста на одну операцию
+// для CircularBuffer_mrmw_blocked при смешанных ожидающих потоках
+// (8 писателей / 8 читателей на маленьком буфере)
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#define BENCH_HAS_RUSAGE 1
+#endif
+
+#include <circular_buffer/circular_buffer_blocked_mrmw.h>
+
+#define WRITER_COUNT 8
+#define READER_COUNT 8
+
+namespace {
+
+long contextSwitches()
+{
+#ifdef BENCH_HAS_RUSAGE
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_nvcsw + usage.ru_nivcsw;
+#else
+    return 0;
+#endif
+}
+
+void run(size_t capacity, size_t elementsPerWriter)
+{
+    connest::CircularBuffer_mrmw_blocked<size_t> queue{capacity};
+
+    const size_t total = elementsPerWriter * WRITER_COUNT;
+    const size_t elementsPerReader = total / READER_COUNT;
+
+    std::vector<std::thread> writters;
+    std::vector<std::thread> readers;
+
+    long cswBefore = contextSwitches();
+    auto start = std::chrono::steady_clock::now();
+
+    readers.reserve(READER_COUNT);
+    for(int i = 0; i < READER_COUNT; ++i)
+        readers.emplace_back([&]() {
+            size_t value{};
+            for(size_t n = 0; n < elementsPerReader; ++n)
+                queue.pop_wait(value);
+        });
+
+    writters.reserve(WRITER_COUNT);
+    for(int i = 0; i < WRITER_COUNT; ++i)
+        writters.emplace_back([&]() {
+            for(size_t n = 0; n < elementsPerWriter; ++n)
+                queue.push_back_wait(n);
+        });
+
+    for(auto& w : writters)
+        w.join();
+    for(auto& r : readers)
+        r.join();
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    long csw = contextSwitches() - cswBefore;
+
+    double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+
+    // операция = одна запись + одно чтение
+    std::cout << "capacity " << std::setw(5) << capacity
+              << "  ops " << total
+              << "  ns/op " << std::fixed << std::setprecision(1) << ns / total
+#ifdef BENCH_HAS_RUSAGE
+              << "  csw/op " << std::setprecision(4)
+              << static_cast<double>(csw) / total
+#endif
+              << std::endl;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    size_t elementsPerWriter = argc > 1 ? std::strtoul(argv[1], nullptr, 10)
+                                        : 200000u;
+
+    std::cout << WRITER_COUNT << " writers / " << READER_COUNT << " readers"
+              << std::endl;
+
+    for(size_t capacity : {1u, 8u, 64u, 1024u})
+        run(capacity, elementsPerWriter);
+
+    return 0;
+}
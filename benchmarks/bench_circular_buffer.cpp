@@ -0,0 +1,355 @@
+// Набор бенчмарков Google Benchmark для CircularBuffer_srsw,
+// CircularBuffer_mrmw и CircularBuffer_mrmw_blocked:
+//   - количество пар писатель/читатель (1:1 - 16:16)
+//   - размер элемента (8 Б - 1 КБ), тривиальный / владеющий памятью в куче
+//   - размер буфера
+//   - поэлементные и пакетные операции
+//
+// Каждая итерация передает через новый буфер items элементов; время
+// замеряется от запуска всех потоков до получения последнего элемента.
+// Отчет: ops/s (элементов в секунду) и ns/op, а также аппаратные
+// счетчики на операцию (perf_counters.h): cycles/op, instructions/op,
+// IPC, L1d-misses/op, LLC-misses/op, branch-misses/op - если доступны
+// (Linux, perf_event_paranoid <= 2, PMU в виртуальной машине). Для отслеживания
+// регрессий между версиями:
+//   CircularBuffer_bench --benchmark_format=json --benchmark_out=result.json
+// Подмножество выбирается --benchmark_filter, например 'mrmw/.*/pairs:4/'.
+
+#include <array>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <set>
+#include <iterator>
+#include <cstring>
+#include <cstdio>
+
+#include <benchmark/benchmark.h>
+
+#include <circular_buffer/circular_buffer_lockfree_srsw.h>
+#include <circular_buffer/circular_buffer_lockfree_mrmw.h>
+#include <circular_buffer/circular_buffer_blocked_mrmw.h>
+
+#include "perf_counters.h"
+
+namespace {
+
+const size_t items = 1 << 16;   // элементов за итерацию
+const size_t batch = 32;        // размер пакета
+
+// Элементы
+
+template<size_t N>
+struct trivial_payload
+{
+    std::array<unsigned char, N> bytes;
+
+    static const char* name() { return "trivial"; }
+
+    static trivial_payload make(size_t value)
+    {
+        trivial_payload result;
+        std::memcpy(result.bytes.data(), &value, std::min(N, sizeof(value)));
+        return result;
+    }
+};
+
+// владеет N байтами в куче; только перемещение (noexcept), поэтому
+// подходит и для lockfree буферов
+template<size_t N>
+struct heap_payload
+{
+    std::unique_ptr<unsigned char[]> bytes;
+
+    static const char* name() { return "heap"; }
+
+    static heap_payload make(size_t value)
+    {
+        heap_payload result;
+        result.bytes.reset(new unsigned char[N]);
+        std::memcpy(result.bytes.get(), &value, std::min(N, sizeof(value)));
+        return result;
+    }
+};
+
+
+// Операции: lockfree буферы - повтор попытки с уступкой процессора,
+// блокирующий - ожидание средствами буфера
+
+template<typename Queue>
+struct lockfree_ops
+{
+    template<typename Payload>
+    static void push(Queue& queue, Payload&& value)
+    {
+        while(! queue.try_push_back(std::move(value)))
+            std::this_thread::yield();
+    }
+
+    template<typename Iterator>
+    static void push_batch(Queue& queue, Iterator begin, Iterator end)
+    {
+        while(begin != end) {
+            size_t pushed = queue.push_back_all(std::make_move_iterator(begin),
+                                                std::make_move_iterator(end));
+            begin += pushed;
+            if(pushed == 0)
+                std::this_thread::yield();
+        }
+    }
+
+    template<typename Payload>
+    static bool pop(Queue& queue, Payload& value)
+    {
+        return queue.try_pop(value);
+    }
+
+    template<typename Payload>
+    static size_t pop_batch(Queue& queue, std::vector<Payload>& values)
+    {
+        values.clear();
+        return queue.pop_all(values);
+    }
+
+    static void finish(Queue&) {}
+};
+
+template<typename Queue>
+struct blocked_ops
+{
+    template<typename Payload>
+    static void push(Queue& queue, Payload&& value)
+    {
+        queue.push_back_wait(std::move(value));
+    }
+
+    template<typename Iterator>
+    static void push_batch(Queue& queue, Iterator begin, Iterator end)
+    {
+        queue.push_back_wait_n(std::make_move_iterator(begin),
+                               std::make_move_iterator(end));
+    }
+
+    template<typename Payload>
+    static bool pop(Queue& queue, Payload& value)
+    {
+        return queue.pop_wait(value) == connest::WaitStatus::success;
+    }
+
+    template<typename Payload>
+    static size_t pop_batch(Queue& queue, std::vector<Payload>& values)
+    {
+        values.clear();
+        return queue.pop_wait_n(std::back_inserter(values), batch);
+    }
+
+    // будит читателей, ждущих элементов, которых больше не будет
+    static void finish(Queue& queue) { queue.shutdown(); }
+};
+
+
+/**
+ * @brief Одна итерация: передать items элементов через новый буфер
+ * @return время передачи
+ */
+template<typename Queue, typename Ops, typename Payload>
+double transfer(size_t pairs, size_t capacity, bool batched, bench::perf_counters& counters)
+{
+    Queue queue(capacity);
+
+    std::atomic<bool> start{false};
+    std::atomic<size_t> consumed{0};
+
+    const size_t perProducer = items / pairs;
+    const size_t total = perProducer * pairs;
+
+    std::vector<std::thread> producers;
+    std::vector<std::thread> consumers;
+
+    for(size_t p = 0; p < pairs; ++p) {
+        producers.emplace_back([&, p]() {
+            while(! start.load(std::memory_order_acquire))
+                std::this_thread::yield();
+
+            if(! batched) {
+                for(size_t n = 0; n < perProducer; ++n)
+                    Ops::push(queue, Payload::make(p * perProducer + n));
+                return;
+            }
+
+            std::vector<Payload> values;
+            values.reserve(batch);
+            for(size_t n = 0; n < perProducer; ) {
+                values.clear();
+                for(size_t i = 0; i < batch && n < perProducer; ++i, ++n)
+                    values.push_back(Payload::make(p * perProducer + n));
+
+                Ops::push_batch(queue, values.begin(), values.end());
+            }
+        });
+
+        consumers.emplace_back([&]() {
+            while(! start.load(std::memory_order_acquire))
+                std::this_thread::yield();
+
+            Payload value{};
+            std::vector<Payload> values;
+            values.reserve(batch);
+
+            while(consumed.load(std::memory_order_relaxed) < total) {
+                size_t popped = batched ? Ops::pop_batch(queue, values)
+                                        : (Ops::pop(queue, value) ? 1 : 0);
+
+                if(popped != 0)
+                    consumed.fetch_add(popped, std::memory_order_relaxed);
+                else
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    // счетчики охватывают тот же интервал, что и время
+    counters.start();
+    auto begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+
+    for(auto& producer : producers)
+        producer.join();
+
+    while(consumed.load(std::memory_order_relaxed) < total)
+        std::this_thread::yield();
+
+    auto end = std::chrono::steady_clock::now();
+
+    Ops::finish(queue);
+    for(auto& consumer : consumers)
+        consumer.join();
+
+    // значения потоков учитываются при их завершении
+    counters.stop();
+
+    return std::chrono::duration<double>(end - begin).count();
+}
+
+template<typename Queue, typename Ops, typename Payload>
+void run(benchmark::State& state, size_t pairs, size_t capacity, bool batched)
+{
+    double seconds = 0;
+    size_t operations = 0;
+
+    // открываются до создания потоков итераций, которые их наследуют
+    bench::perf_counters counters;
+
+    for(auto _ : state) {
+        double elapsed = transfer<Queue, Ops, Payload>(pairs, capacity, batched, counters);
+        state.SetIterationTime(elapsed);
+
+        seconds += elapsed;
+        operations += items / pairs * pairs;
+    }
+
+    state.counters["ops/s"] = benchmark::Counter(static_cast<double>(operations),
+                                                 benchmark::Counter::kIsRate);
+    state.counters["ns/op"] = operations == 0 ? 0 : seconds * 1e9 / operations;
+
+    // потоков больше, чем ядер: результат определяют переключения контекста
+    state.counters["oversubscribed"] = pairs * 2 > std::thread::hardware_concurrency() ? 1 : 0;
+
+    if(operations == 0)
+        return;
+
+    using event = bench::perf_counters::event;
+    for(int e = 0; e < bench::perf_counters::event_count; ++e)
+        if(counters.valid(static_cast<event>(e)))
+            state.counters[std::string(bench::perf_counters::name(static_cast<event>(e))) + "/op"]
+                    = counters.total(static_cast<event>(e)) / operations;
+
+    if(counters.valid(bench::perf_counters::cycles) && counters.valid(bench::perf_counters::instructions)
+       && counters.total(bench::perf_counters::cycles) > 0)
+        state.counters["IPC"] = counters.total(bench::perf_counters::instructions)
+                              / counters.total(bench::perf_counters::cycles);
+}
+
+
+// Регистрация
+
+std::set<std::string> registered;
+
+template<template<typename> class Queue, template<typename> class Ops, typename Payload>
+void add(const char* queueName, size_t payloadSize,
+         size_t pairs, size_t capacity, bool batched)
+{
+    std::string name = std::string(queueName)
+                     + "/" + Payload::name() + ":" + std::to_string(payloadSize)
+                     + "/cap:" + std::to_string(capacity)
+                     + "/pairs:" + std::to_string(pairs)
+                     + (batched ? "/batch" : "/single");
+
+    // наборы ниже пересекаются
+    if(! registered.insert(name).second)
+        return;
+
+    benchmark::RegisterBenchmark(name.c_str(), [=](benchmark::State& state) {
+        run<Queue<Payload>, Ops<Queue<Payload>>, Payload>(
+                    state, pairs, capacity, batched);
+    })->UseManualTime()->Unit(benchmark::kMillisecond);
+}
+
+template<typename T> using srsw    = connest::CircularBuffer_srsw<T>;
+template<typename T> using mrmw    = connest::CircularBuffer_mrmw<T>;
+template<typename T> using blocked = connest::CircularBuffer_mrmw_blocked<T>;
+
+template<typename Payload, size_t Size>
+void add_all(size_t pairs, size_t capacity, bool batched)
+{
+    if(pairs == 1)
+        add<srsw, lockfree_ops, Payload>("srsw", Size, pairs, capacity, batched);
+
+    add<mrmw, lockfree_ops, Payload>("mrmw", Size, pairs, capacity, batched);
+    add<blocked, blocked_ops, Payload>("blocked", Size, pairs, capacity, batched);
+}
+
+void register_benchmarks()
+{
+    // количество потоков
+    for(size_t pairs : {1, 2, 4, 8, 16})
+        for(bool batched : {false, true})
+            add_all<trivial_payload<8>, 8>(pairs, 1024, batched);
+
+    // размер и вид элемента
+    for(size_t pairs : {1, 4}) {
+        add_all<trivial_payload<8>,    8   >(pairs, 1024, false);
+        add_all<trivial_payload<64>,   64  >(pairs, 1024, false);
+        add_all<trivial_payload<1024>, 1024>(pairs, 1024, false);
+        add_all<heap_payload<8>,       8   >(pairs, 1024, false);
+        add_all<heap_payload<64>,      64  >(pairs, 1024, false);
+        add_all<heap_payload<1024>,    1024>(pairs, 1024, false);
+    }
+
+    // размер буфера
+    for(size_t pairs : {1, 4})
+        for(size_t capacity : {16, 64, 1024, 16384})
+            add_all<trivial_payload<8>, 8>(pairs, capacity, false);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    register_benchmarks();
+
+    if(! bench::perf_counters().available())
+        std::fprintf(stderr, "perf counters unavailable, reporting time only\n");
+
+    benchmark::Initialize(&argc, argv);
+    if(benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
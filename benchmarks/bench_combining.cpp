@@ -0,0 +1,120 @@
+// Сравнение пропускной способности CircularBuffer_mrmw_combining
+// с CircularBuffer_mrmw_blocked и lockfree CircularBuffer_mrmw
+// при 4 - 64 потоках (половина писателей, половина читателей)
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+
+#include <circular_buffer/circular_buffer_blocked_mrmw.h>
+#include <circular_buffer/circular_buffer_combining_mrmw.h>
+#include <circular_buffer/circular_buffer_lockfree_mrmw.h>
+
+namespace {
+
+// блокирующие буферы: ожидание средствами самого буфера
+template<typename Queue>
+void produce(Queue& queue, size_t count)
+{
+    for(size_t n = 0; n < count; ++n)
+        queue.push_back_wait(n);
+}
+
+template<typename Queue>
+void consume(Queue& queue, size_t count)
+{
+    size_t value{};
+    for(size_t n = 0; n < count; ++n)
+        queue.pop_wait(value);
+}
+
+// lockfree буфер: повтор попытки с уступкой процессора
+void produce(connest::CircularBuffer_mrmw<size_t>& queue, size_t count)
+{
+    for(size_t n = 0; n < count;) {
+        if(queue.try_push_back(n))
+            ++n;
+        else
+            std::this_thread::yield();
+    }
+}
+
+void consume(connest::CircularBuffer_mrmw<size_t>& queue, size_t count)
+{
+    size_t value{};
+    for(size_t n = 0; n < count;) {
+        if(queue.try_pop(value))
+            ++n;
+        else
+            std::this_thread::yield();
+    }
+}
+
+template<typename Queue>
+double run(size_t threads, size_t capacity, size_t elementsPerWriter)
+{
+    Queue queue{capacity};
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+
+    auto start = std::chrono::steady_clock::now();
+
+    for(size_t i = 0; i < threads / 2; ++i) {
+        workers.emplace_back([&]() { consume(queue, elementsPerWriter); });
+        workers.emplace_back([&]() { produce(queue, elementsPerWriter); });
+    }
+
+    for(auto& w : workers)
+        w.join();
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    return threads / 2 * elementsPerWriter
+         / std::chrono::duration<double>(elapsed).count();
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    size_t elementsPerWriter = argc > 1 ? std::strtoul(argv[1], nullptr, 10)
+                                        : 100000u;
+    const size_t capacity = 1024;
+
+    std::cout << "threads   blocked Mops/s  combining Mops/s  lockfree Mops/s"
+              << std::endl;
+
+    const size_t cores = std::thread::hardware_concurrency();
+
+    for(size_t threads : {4u, 8u, 16u, 32u, 64u}) {
+        double blocked = run<connest::CircularBuffer_mrmw_blocked<size_t>>(
+                    threads, capacity, elementsPerWriter);
+        double combining = run<connest::CircularBuffer_mrmw_combining<size_t>>(
+                    threads, capacity, elementsPerWriter);
+
+        double lockfree = run<connest::CircularBuffer_mrmw<size_t>>(
+                    threads, capacity, elementsPerWriter);
+
+        std::cout << std::setw(7) << threads
+                  << std::fixed << std::setprecision(2)
+                  << std::setw(17) << blocked / 1e6
+                  << std::setw(18) << combining / 1e6
+                  << std::setw(17) << lockfree / 1e6;
+
+        // Поток, вытесненный между захватом W и продвижением W',
+        // останавливает всех остальных писателей: при потоках больше,
+        // чем ядер, замер lockfree буфера определяют переключения контекста
+        if(threads > cores)
+            std::cout << " *";
+
+        std::cout << std::endl;
+    }
+
+    std::cout << "* oversubscribed: threads > cores (" << cores << ")" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,201 @@
+// Накладные расходы на передачу задачи в пул потоков (нс на задачу):
+// thread_pool_executor (small_task в ячейках lockfree буфера, сон
+// простаивающих потоков) против пула на std::mutex + std::queue
+// <std::function<void()>> + std::condition_variable.
+//
+// Задача захватывает 32 байта (std::function в libstdc++ при этом уже
+// выделяет память) и почти ничего не делает, поэтому время на задачу -
+// это стоимость отправки, передачи и запуска. Отправитель один;
+// "bulk" - задачи отправляются пакетами по BATCH штук.
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <queue>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+
+#include <circular_buffer/circular_buffer_executor.h>
+
+#define BATCH 64
+#define QUEUE_CAPACITY 4096
+
+namespace {
+
+/**
+ * @brief Эталонный пул: одна очередь под мьютексом
+ */
+class mutex_pool final
+{
+    std::mutex m_mutex;
+    std::condition_variable m_not_empty;
+    std::queue<std::function<void()>> m_tasks;
+    std::vector<std::thread> m_workers;
+    bool m_stopped;
+
+public:
+    // очередь не ограничена, capacity только для общего интерфейса
+    mutex_pool(size_t threads, size_t /*capacity*/)
+        : m_mutex{}
+        , m_not_empty{}
+        , m_tasks{}
+        , m_workers{}
+        , m_stopped{false}
+    {
+        for(size_t i = 0; i < threads; ++i)
+            m_workers.emplace_back([this]() { work(); });
+    }
+
+    ~mutex_pool()
+    {
+        {
+            std::lock_guard<std::mutex> locker(m_mutex);
+            m_stopped = true;
+        }
+        m_not_empty.notify_all();
+
+        for(auto& worker : m_workers)
+            worker.join();
+    }
+
+    template<typename F>
+    void submit(F&& function)
+    {
+        {
+            std::lock_guard<std::mutex> locker(m_mutex);
+            m_tasks.emplace(std::forward<F>(function));
+        }
+        m_not_empty.notify_one();
+    }
+
+    template<typename Iterator>
+    void submit_bulk(Iterator begin, Iterator end)
+    {
+        {
+            std::lock_guard<std::mutex> locker(m_mutex);
+            for(; begin != end; ++begin)
+                m_tasks.emplace(std::move(*begin));
+        }
+        m_not_empty.notify_all();
+    }
+
+private:
+    void work()
+    {
+        std::unique_lock<std::mutex> locker(m_mutex);
+
+        while(true) {
+            m_not_empty.wait(locker, [this]() { return m_stopped || ! m_tasks.empty(); });
+            if(m_tasks.empty())
+                return;
+
+            std::function<void()> task = std::move(m_tasks.front());
+            m_tasks.pop();
+
+            locker.unlock();
+            task();
+            locker.lock();
+        }
+    }
+};
+
+struct counters
+{
+    std::atomic<size_t> executed{0};
+    std::atomic<size_t> checksum{0};
+};
+
+/**
+ * @brief Задача с 32 байтами захваченных данных
+ */
+struct job
+{
+    counters* target;
+    size_t a, b, c;
+
+    void operator()() const
+    {
+        target->checksum.fetch_add(a + b + c, std::memory_order_relaxed);
+        target->executed.fetch_add(1, std::memory_order_release);
+    }
+};
+
+void wait_all(const counters& state, size_t total)
+{
+    while(state.executed.load(std::memory_order_acquire) < total)
+        std::this_thread::yield();
+}
+
+template<typename Pool, typename Task>
+double single(size_t workers, size_t tasks)
+{
+    counters state;
+    Pool pool(workers, QUEUE_CAPACITY);
+
+    auto start = std::chrono::steady_clock::now();
+
+    for(size_t i = 0; i < tasks; ++i)
+        pool.submit(Task(job{&state, i, 1, 2}));
+
+    wait_all(state, tasks);
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / tasks;
+}
+
+template<typename Pool, typename Task>
+double bulk(size_t workers, size_t tasks)
+{
+    counters state;
+    Pool pool(workers, QUEUE_CAPACITY);
+
+    std::vector<Task> batch;
+    batch.reserve(BATCH);
+
+    auto start = std::chrono::steady_clock::now();
+
+    for(size_t i = 0; i < tasks; ) {
+        batch.clear();
+        for(size_t n = 0; n < BATCH && i < tasks; ++n, ++i)
+            batch.emplace_back(job{&state, i, 1, 2});
+
+        pool.submit_bulk(batch.begin(), batch.end());
+    }
+
+    wait_all(state, tasks);
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / tasks;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    size_t tasks = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000u;
+
+    std::cout << "workers   mutex ns/task   executor ns/task"
+                 "   mutex bulk   executor bulk" << std::endl;
+
+    for(size_t workers : {1u, 2u, 4u, 8u}) {
+        double mutexSingle    = single<mutex_pool, std::function<void()>>(workers, tasks);
+        double executorSingle = single<connest::thread_pool_executor<>, connest::small_task<>>(workers, tasks);
+        double mutexBulk      = bulk<mutex_pool, std::function<void()>>(workers, tasks);
+        double executorBulk   = bulk<connest::thread_pool_executor<>, connest::small_task<>>(workers, tasks);
+
+        std::cout << std::setw(7) << workers
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(16) << mutexSingle
+                  << std::setw(19) << executorSingle
+                  << std::setw(13) << mutexBulk
+                  << std::setw(16) << executorBulk
+                  << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,90 @@
+// Пропускная способность при N писателях и одном читателе (нс на
+// элемент): общий lockfree CircularBuffer_mrmw против
+// CircularBuffer_srmw_fanin (по полосе CircularBuffer_srsw на
+// писателя). Читатель в обоих случаях забирает элементы сериями
+// (pop_all), поэтому разница определяется стороной записи: CAS по
+// общему индексу против записи в собственную полосу.
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+
+#include <circular_buffer/circular_buffer_lockfree_mrmw.h>
+#include <circular_buffer/circular_buffer_fanin_srmw.h>
+
+#define CAPACITY 4096
+
+namespace {
+
+template<typename Queue>
+double run(Queue& queue, size_t writers, size_t perWriter)
+{
+    std::atomic_bool go{false};
+    std::vector<std::thread> threads;
+
+    for(size_t w = 0; w < writers; ++w)
+        threads.emplace_back([&]() {
+            while(! go.load(std::memory_order_acquire))
+                std::this_thread::yield();
+
+            for(size_t n = 0; n < perWriter;) {
+                if(queue.try_push_back(n))
+                    ++n;
+                else
+                    std::this_thread::yield();
+            }
+        });
+
+    size_t total = writers * perWriter;
+    size_t received = 0;
+    std::vector<size_t> batch;
+    batch.reserve(CAPACITY);
+
+    auto start = std::chrono::steady_clock::now();
+    go = true;
+
+    while(received < total) {
+        batch.clear();
+        if(queue.pop_all(batch) == 0)
+            std::this_thread::yield();
+
+        received += batch.size();
+    }
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    for(auto& thread : threads)
+        thread.join();
+
+    return std::chrono::duration<double, std::nano>(elapsed).count() / total;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    size_t perWriter = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000u;
+
+    std::cout << "writers   mrmw ns/item   fanin ns/item" << std::endl;
+
+    for(size_t writers : {1u, 2u, 4u, 8u}) {
+        connest::CircularBuffer_mrmw<size_t> shared(CAPACITY);
+        // полоса на писателя - та же суммарная вместимость
+        connest::CircularBuffer_srmw_fanin<size_t> fanin(CAPACITY / writers, writers);
+
+        double mrmw  = run(shared, writers, perWriter);
+        double lanes = run(fanin, writers, perWriter);
+
+        std::cout << std::setw(7) << writers
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(15) << mrmw
+                  << std::setw(16) << lanes
+                  << std::endl;
+    }
+
+    return 0;
+}
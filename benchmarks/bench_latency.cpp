@@ -0,0 +1,257 @@
+// Задержка передачи одного сообщения (ping-pong):
+// поток A кладет сообщение в первый буфер, поток B забирает его и
+// возвращает через второй буфер. Половина времени оборота - задержка
+// в одну сторону; время - tsc_clock (rdtsc).
+//
+// Потоки закрепляются за процессорами. Без аргументов размещения
+// выбираются по топологии (/sys/devices/system/cpu):
+//   smt          - два аппаратных потока одного ядра
+//   same-socket  - разные ядра одного процессора
+//   cross-socket - разные процессоры
+// (если есть). Явно: bench_latency [samples] [cpuA cpuB]
+// Размещение, потоки которого не удалось закрепить (процессор вне
+// cpuset контейнера, отключен), пропускается с предупреждением.
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <circular_buffer/circular_buffer_lockfree_srsw.h>
+#include <circular_buffer/circular_buffer_lockfree_mrmw.h>
+#include <circular_buffer/circular_buffer_blocked_mrmw.h>
+#include <circular_buffer/circular_buffer_stats.h>
+#include <circular_buffer/circular_buffer_spin.h>
+
+namespace {
+
+struct placement
+{
+    std::string name;
+    int first;
+    int second;
+};
+
+// Топология
+
+int read_number(const std::string& path)
+{
+    std::ifstream file(path);
+    int value = -1;
+    file >> value;
+    return value;
+}
+
+struct cpu_info
+{
+    int cpu;
+    int core;
+    int package;
+};
+
+std::vector<cpu_info> topology()
+{
+    std::vector<cpu_info> result;
+    unsigned count = std::max(1u, std::thread::hardware_concurrency());
+
+    for(unsigned cpu = 0; cpu < count; ++cpu) {
+        std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+        result.push_back({static_cast<int>(cpu),
+                          read_number(base + "core_id"),
+                          read_number(base + "physical_package_id")});
+    }
+
+    return result;
+}
+
+std::vector<placement> default_placements()
+{
+    std::vector<cpu_info> cpus = topology();
+    std::vector<placement> result;
+
+    auto find = [&](const char* name, bool sameCore, bool samePackage) {
+        for(size_t a = 0; a < cpus.size(); ++a)
+            for(size_t b = a + 1; b < cpus.size(); ++b) {
+                bool core    = cpus[a].core == cpus[b].core;
+                bool package = cpus[a].package == cpus[b].package;
+                if(package == samePackage && (core && package) == sameCore) {
+                    result.push_back({name, cpus[a].cpu, cpus[b].cpu});
+                    return;
+                }
+            }
+    };
+
+    find("smt",          true,  true);
+    find("same-socket",  false, true);
+    find("cross-socket", false, false);
+
+    // один процессор: оба потока на нем, задержка определяется планировщиком
+    if(result.empty())
+        result.push_back({"single-cpu", 0, 0});
+
+    return result;
+}
+
+bool pin(int cpu)
+{
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+
+// Ожидание: lockfree буферы - активное, блокирующий - средствами буфера
+
+template<typename Queue>
+void send(Queue& queue, size_t value, bool spin)
+{
+    while(! queue.try_push_back(value))
+        if(! spin)
+            std::this_thread::yield();
+}
+
+template<typename Queue>
+size_t receive(Queue& queue, bool spin)
+{
+    size_t value{};
+    while(! queue.try_pop(value))
+        if(spin)
+            connest::detail::cpu_relax();
+        else
+            std::this_thread::yield();
+    return value;
+}
+
+template<typename T>
+void send(connest::CircularBuffer_mrmw_blocked<T>& queue, size_t value, bool)
+{
+    queue.push_back_wait(value);
+}
+
+template<typename T>
+size_t receive(connest::CircularBuffer_mrmw_blocked<T>& queue, bool)
+{
+    size_t value{};
+    queue.pop_wait(value);
+    return value;
+}
+
+
+// Пусто, если потоки не удалось закрепить за процессорами размещения
+template<typename Queue>
+std::vector<int64_t> ping_pong(const placement& where, size_t samples)
+{
+    Queue ping(16);
+    Queue pong(16);
+
+    // на одном процессоре активное ожидание не дает второму потоку работать
+    const bool spin = where.first != where.second;
+    const size_t warmup = samples / 10;
+
+    bool echoPinned = false;
+    std::thread echo([&]() {
+        echoPinned = pin(where.second);
+        for(size_t n = 0; n < warmup + samples; ++n)
+            send(pong, receive(ping, spin), spin);
+    });
+
+    bool pinned = pin(where.first);
+
+    std::vector<int64_t> result;
+    result.reserve(samples);
+
+    for(size_t n = 0; n < warmup + samples; ++n) {
+        auto start = connest::tsc_clock::now();
+        send(ping, n, spin);
+        receive(pong, spin);
+        auto stop = connest::tsc_clock::now();
+
+        if(n >= warmup)
+            result.push_back((stop - start).count() / 2);
+    }
+
+    echo.join();
+
+    if(! pinned || ! echoPinned)
+        result.clear();
+
+    return result;
+}
+
+void report(const char* queue, const placement& where, std::vector<int64_t> samples)
+{
+    if(samples.empty()) {
+        std::cerr << where.name << " " << where.first << "," << where.second << " " << queue
+                  << ": cannot pin threads, skipped" << std::endl;
+        return;
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    auto at = [&](double percent) {
+        size_t index = static_cast<size_t>(percent / 100.0 * (samples.size() - 1));
+        return samples[index];
+    };
+
+    std::cout << std::left  << std::setw(14) << where.name
+              << std::setw(8)  << (std::to_string(where.first) + "," + std::to_string(where.second))
+              << std::setw(10) << queue
+              << std::right
+              << std::setw(9)  << samples.front()
+              << std::setw(9)  << at(50)
+              << std::setw(9)  << at(99)
+              << std::setw(9)  << at(99.9)
+              << std::setw(11) << samples.back()
+              << std::endl;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    size_t samples = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000u;
+    if(samples == 0) {
+        std::cerr << "usage: bench_latency [samples > 0] [cpuA cpuB]" << std::endl;
+        return 1;
+    }
+
+    std::vector<placement> placements;
+    if(argc > 3)
+        placements.push_back({"manual", std::atoi(argv[2]), std::atoi(argv[3])});
+    else
+        placements = default_placements();
+
+    std::cout << "one-way latency, ns (tsc)" << std::endl;
+    std::cout << "placement     cpus    queue          min      p50      p99    p99.9        max"
+              << std::endl;
+
+    for(const placement& where : placements) {
+        // закрепление проверяется заранее, чтобы не измерять впустую
+        if(! pin(where.first) || ! pin(where.second)) {
+            std::cerr << where.name << " " << where.first << "," << where.second
+                      << ": cannot pin threads (pthread_setaffinity_np), skipped" << std::endl;
+            continue;
+        }
+
+        report("srsw",    where, ping_pong<connest::CircularBuffer_srsw<size_t>>(where, samples));
+        report("mrmw",    where, ping_pong<connest::CircularBuffer_mrmw<size_t>>(where, samples));
+        report("blocked", where, ping_pong<connest::CircularBuffer_mrmw_blocked<size_t>>(where, samples));
+    }
+
+    return 0;
+}
@@ -0,0 +1,106 @@
+// Сравнение пропускной способности lockfree CircularBuffer_mrmw
+// с CircularBuffer_mrmw_sharded (шард на узел NUMA).
+// Узлы имитируются: каждому потоку назначается узел
+// numa::set_current_node, поэтому бенчмарк работает и на
+// одноузловой машине (шарды снижают конкуренцию за индексы,
+// но не показывают выигрыш от локальности памяти)
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+
+#include <circular_buffer/circular_buffer_lockfree_mrmw.h>
+#include <circular_buffer/circular_buffer_sharded_mrmw.h>
+#include <circular_buffer/circular_buffer_numa.h>
+
+namespace {
+
+template<typename Queue>
+void produce(Queue& queue, size_t count)
+{
+    for(size_t n = 0; n < count;) {
+        if(queue.try_push_back(n))
+            ++n;
+        else
+            std::this_thread::yield();
+    }
+}
+
+template<typename Queue>
+void consume(Queue& queue, size_t count)
+{
+    size_t value{};
+    for(size_t n = 0; n < count;) {
+        if(queue.try_pop(value))
+            ++n;
+        else
+            std::this_thread::yield();
+    }
+}
+
+template<typename Queue>
+double run(Queue& queue, size_t nodes, size_t elementsPerWriter)
+{
+    std::vector<std::thread> workers;
+    workers.reserve(nodes * 2);
+
+    auto start = std::chrono::steady_clock::now();
+
+    // на каждом узле один писатель и один читатель
+    for(size_t node = 0; node < nodes; ++node) {
+        workers.emplace_back([&, node]() {
+            connest::numa::set_current_node(static_cast<int>(node));
+            consume(queue, elementsPerWriter);
+        });
+        workers.emplace_back([&, node]() {
+            connest::numa::set_current_node(static_cast<int>(node));
+            produce(queue, elementsPerWriter);
+        });
+    }
+
+    for(auto& w : workers)
+        w.join();
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    return nodes * elementsPerWriter
+         / std::chrono::duration<double>(elapsed).count();
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    size_t elementsPerWriter = argc > 1 ? std::strtoul(argv[1], nullptr, 10)
+                                        : 100000u;
+    const size_t capacity = 1024;
+
+    std::cout << "system nodes: " << connest::numa::node_count() << std::endl;
+    std::cout << "nodes   mrmw Mops/s  sharded Mops/s" << std::endl;
+
+    const size_t cores = std::thread::hardware_concurrency();
+
+    for(size_t nodes : {1u, 2u, 4u}) {
+        std::cout << std::setw(5) << nodes << std::fixed << std::setprecision(2);
+
+        connest::CircularBuffer_mrmw<size_t> plain{capacity};
+        std::cout << std::setw(13) << run(plain, nodes, elementsPerWriter) / 1e6;
+
+        connest::CircularBuffer_mrmw_sharded<size_t> sharded{capacity / nodes, nodes};
+        std::cout << std::setw(16) << run(sharded, nodes, elementsPerWriter) / 1e6;
+
+        // см. bench_combining: при потоках больше, чем ядер, замер
+        // lockfree буфера определяют переключения контекста
+        if(nodes * 2 > cores)
+            std::cout << " *";
+
+        std::cout << std::endl;
+    }
+
+    std::cout << "* oversubscribed: threads > cores (" << cores << ")" << std::endl;
+
+    return 0;
+}
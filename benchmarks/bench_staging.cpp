@@ -0,0 +1,138 @@
+// Накопление записей в потоке перед CircularBuffer_mrmw_blocked: N писателей
+// и один читатель, запись по одному (захват мьютекса на элемент) против
+// staging_buffer (серия за один захват, сброс по заполнению и таймеру).
+// Выводятся нс на элемент и задержка от try_push_back до извлечения.
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+
+#include <circular_buffer/circular_buffer_blocked_mrmw.h>
+#include <circular_buffer/circular_buffer_staging.h>
+
+#define CAPACITY 4096
+
+namespace {
+
+using buffer_type = connest::CircularBuffer_mrmw_blocked<int64_t>;
+using staging_type = connest::staging_buffer<buffer_type>;
+
+struct result
+{
+    double ns;
+    double mean_us;
+    double max_us;
+};
+
+int64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// элементы по одному
+struct single
+{
+    buffer_type& buffer;
+    single(buffer_type& b, size_t, std::chrono::microseconds) : buffer(b) {}
+    bool push(int64_t value) { return buffer.try_push_back(value); }
+    void flush() {}
+};
+
+// накопитель потока
+struct staged
+{
+    staging_type staging;
+    staged(buffer_type& b, size_t block, std::chrono::microseconds latency)
+        : staging(b, block, latency) {}
+    bool push(int64_t value) { return staging.try_push_back(value); }
+    void flush() { staging.flush(); }
+};
+
+template<typename Mode>
+result run(size_t writers, size_t perWriter, size_t block, std::chrono::microseconds latency)
+{
+    buffer_type buffer(CAPACITY);
+    Mode mode(buffer, block, latency);
+
+    size_t total = writers * perWriter;
+    std::atomic_bool go{false};
+
+    std::vector<std::thread> threads;
+
+    for(size_t w = 0; w < writers; ++w)
+        threads.emplace_back([&]() {
+            while(! go.load(std::memory_order_acquire))
+                std::this_thread::yield();
+
+            // значение - момент записи
+            for(size_t n = 0; n < perWriter;) {
+                if(mode.push(now_ns()))
+                    ++n;
+                else
+                    std::this_thread::yield();
+            }
+
+            mode.flush();
+        });
+
+    double sum{0};
+    int64_t worst{0};
+
+    auto start = std::chrono::steady_clock::now();
+    go = true;
+
+    for(size_t received = 0; received < total;) {
+        int64_t stamp;
+        if(buffer.pop_wait_for(stamp, std::chrono::milliseconds(10)) != connest::WaitStatus::success)
+            continue;
+
+        int64_t delay = now_ns() - stamp;
+        sum += static_cast<double>(delay);
+        worst = delay > worst ? delay : worst;
+        ++received;
+    }
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    for(auto& thread : threads)
+        thread.join();
+
+    return result{std::chrono::duration<double, std::nano>(elapsed).count() / total,
+                  sum / total / 1000.0,
+                  static_cast<double>(worst) / 1000.0};
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    size_t perWriter = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000u;
+    size_t block     = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 64u;
+    std::chrono::microseconds latency(argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 100u);
+
+    std::cout << "block " << block << ", max_latency " << latency.count() << " us" << std::endl;
+    std::cout << "writers   single ns/item  mean us  max us   staged ns/item  mean us  max us" << std::endl;
+
+    for(size_t writers : {1u, 2u, 4u, 8u}) {
+        result one   = run<single>(writers, perWriter, block, latency);
+        result batch = run<staged>(writers, perWriter, block, latency);
+
+        std::cout << std::setw(7) << writers
+                  << std::fixed << std::setprecision(2)
+                  << std::setw(17) << one.ns
+                  << std::setw(9) << one.mean_us
+                  << std::setw(8) << one.max_us
+                  << std::setw(17) << batch.ns
+                  << std::setw(9) << batch.mean_us
+                  << std::setw(8) << batch.max_us
+                  << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,146 @@
+// Маркеры писателя и читателя для lockfree буфера: N писателей и два
+// читателя, элементы по одному (try_push_back / try_pop) против
+// producer_token / consumer_token (один CAS по W / R на серию).
+// Выводятся нс на элемент и повторы CAS на элемент (count_stats).
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+
+#include <circular_buffer/circular_buffer_token.h>
+
+#define CAPACITY 4096
+#define READERS 2
+
+namespace {
+
+using buffer_type = connest::basic_circular_buffer<size_t,
+                                                   connest::multi_producer,
+                                                   connest::multi_consumer,
+                                                   connest::spin_wait,
+                                                   connest::vector_storage<size_t>,
+                                                   connest::count_stats>;
+
+struct result
+{
+    double ns;
+    double retries;
+};
+
+// элементы по одному
+struct single
+{
+    struct writer
+    {
+        buffer_type& buffer;
+        writer(buffer_type& b, size_t) : buffer(b) {}
+        bool push(size_t value) { return buffer.try_push_back(value); }
+    };
+
+    struct reader
+    {
+        buffer_type& buffer;
+        reader(buffer_type& b, size_t) : buffer(b) {}
+        bool pop(size_t& value) { return buffer.try_pop(value); }
+    };
+};
+
+// маркеры: серии по block элементов
+struct tokens
+{
+    struct writer
+    {
+        connest::producer_token<buffer_type> token;
+        writer(buffer_type& b, size_t block) : token(b, block) {}
+        bool push(size_t value) { return token.try_push_back(value); }
+    };
+
+    struct reader
+    {
+        connest::consumer_token<buffer_type> token;
+        reader(buffer_type& b, size_t block) : token(b, block) {}
+        bool pop(size_t& value) { return token.try_pop(value); }
+    };
+};
+
+template<typename Mode>
+result run(size_t writers, size_t perWriter, size_t block)
+{
+    buffer_type buffer(CAPACITY);
+
+    size_t total = writers * perWriter;
+    std::atomic<size_t> received{0};
+    std::atomic_bool go{false};
+
+    std::vector<std::thread> threads;
+
+    for(size_t w = 0; w < writers; ++w)
+        threads.emplace_back([&]() {
+            while(! go.load(std::memory_order_acquire))
+                std::this_thread::yield();
+
+            // деструктор маркера добавляет неполную последнюю серию
+            typename Mode::writer writer(buffer, block);
+            for(size_t n = 0; n < perWriter;) {
+                if(writer.push(n))
+                    ++n;
+                else
+                    std::this_thread::yield();
+            }
+        });
+
+    for(size_t r = 0; r < READERS; ++r)
+        threads.emplace_back([&]() {
+            typename Mode::reader reader(buffer, block);
+            size_t value;
+
+            while(received.load(std::memory_order_relaxed) < total) {
+                if(reader.pop(value))
+                    received.fetch_add(1, std::memory_order_relaxed);
+                else
+                    std::this_thread::yield();
+            }
+        });
+
+    auto start = std::chrono::steady_clock::now();
+    go = true;
+
+    for(auto& thread : threads)
+        thread.join();
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    connest::buffer_stats stats = buffer.stats();
+    return result{std::chrono::duration<double, std::nano>(elapsed).count() / total,
+                  static_cast<double>(stats.cas_retries) / total};
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    size_t perWriter = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000u;
+    size_t block     = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 64u;
+
+    std::cout << "block " << block << ", readers " << READERS << std::endl;
+    std::cout << "writers   single ns/item  retries/item   tokens ns/item  retries/item" << std::endl;
+
+    for(size_t writers : {1u, 2u, 4u, 8u}) {
+        result one   = run<single>(writers, perWriter, block);
+        result batch = run<tokens>(writers, perWriter, block);
+
+        std::cout << std::setw(7) << writers
+                  << std::fixed << std::setprecision(2)
+                  << std::setw(17) << one.ns
+                  << std::setw(14) << one.retries
+                  << std::setw(17) << batch.ns
+                  << std::setw(14) << batch.retries
+                  << std::endl;
+    }
+
+    return 0;
+}
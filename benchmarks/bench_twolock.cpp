@@ -0,0 +1,76 @@
+// Сравнение пропускной способности CircularBuffer_mrmw_blocked (один мьютекс)
+// и CircularBuffer_mrmw_twolock (раздельные мьютексы писателей и читателей)
+// при сбалансированной нагрузке N писателей / N читателей
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+
+#include <circular_buffer/circular_buffer_blocked_mrmw.h>
+#include <circular_buffer/circular_buffer_twolock_mrmw.h>
+
+namespace {
+
+template<typename Queue>
+double run(size_t threads, size_t capacity, size_t elementsPerWriter)
+{
+    Queue queue{capacity};
+
+    std::vector<std::thread> writters;
+    std::vector<std::thread> readers;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for(size_t i = 0; i < threads; ++i)
+        readers.emplace_back([&]() {
+            size_t value{};
+            for(size_t n = 0; n < elementsPerWriter; ++n)
+                queue.pop_wait(value);
+        });
+
+    for(size_t i = 0; i < threads; ++i)
+        writters.emplace_back([&]() {
+            for(size_t n = 0; n < elementsPerWriter; ++n)
+                queue.push_back_wait(n);
+        });
+
+    for(auto& w : writters)
+        w.join();
+    for(auto& r : readers)
+        r.join();
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    // элементов в секунду (запись + чтение = одна операция)
+    return threads * elementsPerWriter
+         / std::chrono::duration<double>(elapsed).count();
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    size_t elementsPerWriter = argc > 1 ? std::strtoul(argv[1], nullptr, 10)
+                                        : 500000u;
+    const size_t capacity = 1024;
+
+    std::cout << "threads      blocked Mops/s    twolock Mops/s" << std::endl;
+
+    for(size_t threads : {1u, 2u, 4u, 8u}) {
+        double blocked = run<connest::CircularBuffer_mrmw_blocked<size_t>>(
+                    threads, capacity, elementsPerWriter);
+        double twolock = run<connest::CircularBuffer_mrmw_twolock<size_t>>(
+                    threads, capacity, elementsPerWriter);
+
+        std::cout << std::setw(2) << threads << ":" << std::setw(2) << threads
+                  << std::fixed << std::setprecision(2)
+                  << std::setw(19) << blocked / 1e6
+                  << std::setw(18) << twolock / 1e6
+                  << std::endl;
+    }
+
+    return 0;
+}
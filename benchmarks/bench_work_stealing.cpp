@@ -0,0 +1,246 @@
+// Планировщик рекурсивных задач fork-join (fib(n) с порогом
+// последовательного вычисления): общая очередь задач
+// CircularBuffer_mrmw<task*> против WorkStealingDeque<task*> на
+// каждый рабочий поток со случайным выбором жертвы перехвата.
+//
+// Задача порождает дочернюю fib(n - 2), сама вычисляет fib(n - 1) и
+// ждет дочернюю, выполняя в это время другие задачи (из своей деки или
+// очереди, затем перехватом). С общей очередью каждое порождение и
+// каждое получение задачи - операция над одними и теми же индексами;
+// с деками владелец работает со своим нижним концом, а общие данные
+// затрагиваются только при перехвате.
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+
+#include <circular_buffer/circular_buffer_lockfree_mrmw.h>
+#include <circular_buffer/circular_buffer_work_stealing.h>
+
+#define QUEUE_CAPACITY 4096
+
+namespace {
+
+struct task
+{
+    int n;
+    uint64_t result;
+    std::atomic_bool done;
+
+    explicit task(int value)
+        : n{value}
+        , result{0}
+        , done{false}
+    {}
+};
+
+uint64_t serial_fib(int n)
+{
+    return n < 2 ? static_cast<uint64_t>(n) : serial_fib(n - 1) + serial_fib(n - 2);
+}
+
+/**
+ * @brief Одна очередь задач на все рабочие потоки
+ */
+class global_scheduler final
+{
+    connest::CircularBuffer_mrmw<task*> m_queue;
+
+public:
+    explicit global_scheduler(size_t /*workers*/)
+        : m_queue(QUEUE_CAPACITY)
+    {}
+
+    bool spawn(size_t /*self*/, task* value)
+    {
+        return m_queue.try_push_back(value);
+    }
+
+    bool next(size_t /*self*/, task*& result)
+    {
+        return m_queue.try_pop(result);
+    }
+
+    size_t steals() const
+    {
+        return 0;
+    }
+};
+
+/**
+ * @brief Дека на каждый рабочий поток, перехват у случайной жертвы
+ */
+class stealing_scheduler final
+{
+    struct worker
+    {
+        connest::WorkStealingDeque<task*> deque;
+        uint64_t seed;
+        size_t steals;
+
+        explicit worker(uint64_t value)
+            : deque(256)
+            , seed{value}
+            , steals{0}
+        {}
+    };
+
+    std::vector<std::unique_ptr<worker>> m_workers;
+
+public:
+    explicit stealing_scheduler(size_t workers)
+        : m_workers{}
+    {
+        for(size_t i = 0; i < workers; ++i)
+            m_workers.emplace_back(new worker(0x9E3779B97F4A7C15ull * (i + 1)));
+    }
+
+    bool spawn(size_t self, task* value)
+    {
+        m_workers[self]->deque.push(value);
+        return true;
+    }
+
+    bool next(size_t self, task*& result)
+    {
+        worker& own = *m_workers[self];
+        if(own.deque.try_pop(result))
+            return true;
+
+        if(m_workers.size() < 2)
+            return false;
+
+        // xorshift64
+        own.seed ^= own.seed << 13;
+        own.seed ^= own.seed >> 7;
+        own.seed ^= own.seed << 17;
+
+        size_t victim = static_cast<size_t>(own.seed % (m_workers.size() - 1));
+        if(victim >= self)
+            ++victim;
+
+        if(! m_workers[victim]->deque.try_steal(result))
+            return false;
+
+        ++own.steals;
+        return true;
+    }
+
+    // вызывается после остановки рабочих потоков
+    size_t steals() const
+    {
+        size_t total = 0;
+        for(const auto& w : m_workers)
+            total += w->steals;
+
+        return total;
+    }
+};
+
+template<typename Scheduler>
+void compute(Scheduler& scheduler, size_t self, int cutoff, task* current)
+{
+    if(current->n < cutoff) {
+        current->result = serial_fib(current->n);
+        current->done.store(true, std::memory_order_release);
+        return;
+    }
+
+    task child(current->n - 2);
+    if(! scheduler.spawn(self, &child))
+        compute(scheduler, self, cutoff, &child);
+
+    task own(current->n - 1);
+    compute(scheduler, self, cutoff, &own);
+
+    // ожидание дочерней задачи с выполнением других
+    task* other{nullptr};
+    while(! child.done.load(std::memory_order_acquire)) {
+        if(scheduler.next(self, other))
+            compute(scheduler, self, cutoff, other);
+        else
+            std::this_thread::yield();
+    }
+
+    current->result = own.result + child.result;
+    current->done.store(true, std::memory_order_release);
+}
+
+struct outcome
+{
+    double ms;
+    size_t steals;
+    bool correct;
+};
+
+template<typename Scheduler>
+outcome run(size_t workers, int n, int cutoff)
+{
+    Scheduler scheduler(workers);
+    std::atomic_bool stopped{false};
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for(size_t self = 1; self < workers; ++self)
+        threads.emplace_back([&, self]() {
+            task* other{nullptr};
+            while(! stopped.load(std::memory_order_acquire)) {
+                if(scheduler.next(self, other))
+                    compute(scheduler, self, cutoff, other);
+                else
+                    std::this_thread::yield();
+            }
+        });
+
+    // корневую задачу выполняет рабочий поток 0 (текущий)
+    task root(n);
+    compute(scheduler, 0, cutoff, &root);
+
+    stopped = true;
+    for(auto& thread : threads)
+        thread.join();
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    return outcome{std::chrono::duration<double, std::milli>(elapsed).count(),
+                   scheduler.steals(),
+                   root.result == serial_fib(n)};
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    int n      = argc > 1 ? std::atoi(argv[1]) : 36;
+    int cutoff = argc > 2 ? std::atoi(argv[2]) : 12;
+    if(cutoff < 2)
+        cutoff = 2;
+
+    std::cout << "fib(" << n << "), cutoff " << cutoff << std::endl;
+    std::cout << "workers   global queue ms   work stealing ms       steals" << std::endl;
+
+    for(size_t workers : {1u, 2u, 4u, 8u}) {
+        outcome global   = run<global_scheduler>(workers, n, cutoff);
+        outcome stealing = run<stealing_scheduler>(workers, n, cutoff);
+
+        std::cout << std::setw(7) << workers
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(18) << global.ms
+                  << std::setw(19) << stealing.ms
+                  << std::setw(13) << stealing.steals;
+
+        if(! global.correct || ! stealing.correct)
+            std::cout << "   WRONG RESULT";
+
+        std::cout << std::endl;
+    }
+
+    return 0;
+}
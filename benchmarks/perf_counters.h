@@ -0,0 +1,209 @@
+#ifndef BENCH_PERF_COUNTERS_H
+#define BENCH_PERF_COUNTERS_H
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+namespace bench {
+
+/**
+  @brief    Аппаратные счетчики процессора (perf_event_open)
+  @details
+        Счетчики открываются для текущего процесса с наследованием:
+        потоки, созданные после конструктора, учитываются в них, а
+        значения читаются через исходные дескрипторы. Считается только
+        пространство пользователя (достаточно perf_event_paranoid <= 2).
+
+        Значения завершившихся потоков попадают в счетчик при их
+        завершении, и PERF_EVENT_IOC_RESET их не обнуляет, поэтому
+        start() запоминает текущие показания, а stop() добавляет только
+        разницу. Потоки интервала нужно дождаться (join) до stop(),
+        иначе их значения не войдут в этот интервал.
+
+        Каждый счетчик открывается отдельно; недоступные (нет PMU в
+        виртуальной машине, запрет ядра, другая ОС) пропускаются -
+        valid() возвращает false. При мультиплексировании значения
+        масштабируются по времени работы счетчика.
+ */
+class perf_counters final
+{
+public:
+    enum event {
+        cycles,
+        instructions,
+        l1d_misses,
+        llc_misses,
+        branch_misses,
+        event_count
+    };
+
+private:
+    int m_fd[event_count];
+    double m_total[event_count];
+
+    // показания при start(): значение, время включения, время работы
+    uint64_t m_base[event_count][3];
+
+public:
+    perf_counters()
+    {
+        for(int e = 0; e < event_count; ++e) {
+            m_fd[e] = open(static_cast<event>(e));
+            m_total[e] = 0;
+            std::memset(m_base[e], 0, sizeof(m_base[e]));
+        }
+    }
+
+    ~perf_counters()
+    {
+#if defined(__linux__)
+        for(int fd : m_fd)
+            if(fd >= 0)
+                close(fd);
+#endif
+    }
+
+    perf_counters(const perf_counters&) = delete;
+    perf_counters& operator=(const perf_counters&) = delete;
+
+    static const char* name(event e)
+    {
+        static const char* names[event_count] = {
+            "cycles", "instructions", "L1d-misses", "LLC-misses", "branch-misses"
+        };
+        return names[e];
+    }
+
+    bool valid(event e) const { return m_fd[e] >= 0; }
+
+    bool available() const
+    {
+        for(int fd : m_fd)
+            if(fd >= 0)
+                return true;
+        return false;
+    }
+
+    /**
+     * @brief Запомнить показания и запустить счетчики
+     */
+    void start()
+    {
+#if defined(__linux__)
+        for(int e = 0; e < event_count; ++e)
+            if(m_fd[e] >= 0) {
+                if(! read_values(m_fd[e], m_base[e]))
+                    std::memset(m_base[e], 0, sizeof(m_base[e]));
+                ioctl(m_fd[e], PERF_EVENT_IOC_ENABLE, 0);
+            }
+#endif
+    }
+
+    /**
+     * @brief   Остановить счетчики и добавить к накопленным разницу
+     *          с показаниями start()
+     */
+    void stop()
+    {
+#if defined(__linux__)
+        for(int e = 0; e < event_count; ++e) {
+            if(m_fd[e] < 0)
+                continue;
+
+            ioctl(m_fd[e], PERF_EVENT_IOC_DISABLE, 0);
+
+            uint64_t values[3] = {0, 0, 0};
+            if(! read_values(m_fd[e], values))
+                continue;
+
+            double value   = static_cast<double>(values[0] - m_base[e][0]);
+            double enabled = static_cast<double>(values[1] - m_base[e][1]);
+            double running = static_cast<double>(values[2] - m_base[e][2]);
+
+            // при мультиплексировании - масштабирование по времени работы
+            if(running > 0)
+                m_total[e] += value * enabled / running;
+        }
+#endif
+    }
+
+    /**
+     * @brief Накопленное значение с последнего clear()
+     */
+    double total(event e) const { return m_total[e]; }
+
+    void clear()
+    {
+        for(double& total : m_total)
+            total = 0;
+    }
+
+private:
+#if defined(__linux__)
+    /**
+     * @brief Прочитать значение, время включения и время работы
+     */
+    static bool read_values(int fd, uint64_t (&values)[3])
+    {
+        return read(fd, values, sizeof(values)) == static_cast<ssize_t>(sizeof(values));
+    }
+#endif
+
+    static int open(event e)
+    {
+#if defined(__linux__)
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+
+        switch(e) {
+        case cycles:
+            attr.type   = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case instructions:
+            attr.type   = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case l1d_misses:
+            attr.type   = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1D
+                        | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                        | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        case llc_misses:
+            attr.type   = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case branch_misses:
+            attr.type   = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        default:
+            return -1;
+        }
+
+        attr.disabled       = 1;
+        attr.inherit        = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+        (void)e;
+        return -1;
+#endif
+    }
+};
+
+}
+
+#endif // BENCH_PERF_COUNTERS_H
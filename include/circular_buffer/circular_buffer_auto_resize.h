@@ -0,0 +1,50 @@
+#ifndef CIRCULAR_BUFFER_AUTO_RESIZE_H
+#define CIRCULAR_BUFFER_AUTO_RESIZE_H
+
+#include <cstddef>
+#include <stdexcept>
+
+namespace connest {
+
+/**
+  @brief    Параметры автоматического изменения размера буфера
+  @details
+        Если заполненность буфера после операций держится не ниже
+        high_watermark процентов window операций подряд, размер удваивается
+        (но не больше max_size). Если заполненность держится не выше
+        low_watermark процентов window операций подряд, размер уменьшается
+        вдвое (но не меньше min_size и не меньше текущего количества
+        элементов).
+ */
+struct AutoResizePolicy
+{
+    size_t min_size;
+    size_t max_size;
+    size_t high_watermark = 90; // в процентах
+    size_t low_watermark  = 25; // в процентах
+    size_t window         = 1024;
+};
+
+namespace detail {
+
+/**
+ * @brief   Проверить параметры AutoResizePolicy
+ * @param policy параметры
+ * @throw std::invalid_argument некорректная политика
+ */
+inline void validate(const AutoResizePolicy& policy)
+{
+    if(policy.min_size > policy.max_size)
+        throw std::invalid_argument("AutoResizePolicy: min_size > max_size");
+
+    if(policy.low_watermark >= policy.high_watermark)
+        throw std::invalid_argument("AutoResizePolicy: low_watermark >= high_watermark");
+
+    if(policy.window == 0)
+        throw std::invalid_argument("AutoResizePolicy: window == 0");
+}
+
+}
+
+}
+#endif // CIRCULAR_BUFFER_AUTO_RESIZE_H
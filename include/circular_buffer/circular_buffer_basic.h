@@ -0,0 +1,1229 @@
+#ifndef CIRCULAR_BUFFER_BASIC_H
+#define CIRCULAR_BUFFER_BASIC_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+
+#include "circular_buffer_fwd.h"
+#include "circular_buffer_coro.h"
+#include "circular_buffer_policies.h"
+#include "circular_buffer_stats.h"
+#include "circular_buffer_storage.h"
+#include "circular_buffer_wait_status.h"
+
+namespace connest {
+
+using std::size_t;
+
+/**
+  @brief    Кольцевой lockfree буфер, собираемый из политик
+  @details
+        ProducerPolicy - single_producer / multi_producer
+        ConsumerPolicy - single_consumer / multi_consumer
+        WaitPolicy     - spin_wait / park_wait / coro_wait (co_await push / pop)
+                         (block_wait - см. circular_buffer_blocked_mrmw.h)
+        StoragePolicy  - vector_storage / inline_storage / mmap_storage
+        StatsPolicy    - no_stats / count_stats (см. stats())
+
+        R'          R
+        |           |
+        V           V
+  -----------------------------------------------------
+  |   |RRR|RRR|RRR|RRR|   |   |WWW|WWW|WWW|WWW|   |RES|
+  -----------------------------------------------------
+  |                             ^           ^     |
+  0                             |           |     Size
+                                W'          W
+
+  R' - R  => ждет прочтения (RRR)
+  W' - W  => ждет записи    (WWW)
+  W  - R' => свободное место
+
+  RES - зарезервированный элемент, чтобы отличать
+        состояния "пуст" и "заполнен"
+
+  Для стороны с единственным потоком R == R' (W == W'): хранится один
+  индекс, захват выполняется без CAS (см. detail::ring_side).
+
+  Тождества (кольцевой отсчет):
+    R' <= R
+    W' <= W
+    R  <= W
+    W  <= R'
+ */
+template<typename T,
+         typename ProducerPolicy,
+         typename ConsumerPolicy,
+         typename WaitPolicy,
+         typename StoragePolicy,
+         typename StatsPolicy>
+class basic_circular_buffer final
+{
+    static_assert ( std::is_default_constructible<T>::value,
+                    "Type T must be default constructible: empty buffer should "
+                    "have initialized elements");
+
+    // исключение между захватом и завершением остановило бы
+    // всех последующих писателей / читателей
+    static_assert(      !(ProducerPolicy::multi || ConsumerPolicy::multi)
+                    ||  std::is_nothrow_move_assignable<T>::value
+                    ||  !std::is_move_assignable<T>::value,
+                    "Type T must not throw in move assign operator");
+
+    static_assert(      !(ProducerPolicy::multi || ConsumerPolicy::multi)
+                    ||  std::is_nothrow_copy_assignable<T>::value
+                    ||  !std::is_copy_assignable<T>::value,
+                    "Type T must not throw in copy assign operator");
+
+    using multi_consumer_tag = std::integral_constant<bool, ConsumerPolicy::multi>;
+
+    StoragePolicy m_data;
+
+    alignas(64) detail::ring_side<ConsumerPolicy::multi> m_read;   // R, R'
+    alignas(64) detail::ring_side<ProducerPolicy::multi> m_write;  // W, W'
+
+    detail::wait_state<WaitPolicy> m_wait;
+    std::atomic_bool m_delete;
+
+    detail::stats_state<StatsPolicy> m_stats;
+
+    friend struct detail::coro_access;
+
+public:
+    using value_type     = T;
+    using allocator_type = typename StoragePolicy::allocator_type;
+
+    struct const_iterator;
+
+    struct iterator final
+    {
+        using iterator_category = std::random_access_iterator_tag;
+        using difference_type   = size_t;
+        using value_type        = T;
+        using pointer           = value_type*;
+        using reference         = value_type&;
+
+        iterator(size_t index, basic_circular_buffer& container)
+            : m_index{index}
+            , m_container{container}
+        {}
+        iterator(const iterator&) = default;
+        iterator(iterator&&) = default;
+        ~iterator() = default;
+
+        iterator& operator++() { ++m_index; return *this; }
+        iterator& operator--() { --m_index; return *this; }
+        reference operator*() { return m_container.at(m_index); }
+
+        difference_type operator-(const iterator& other) const
+        { return m_index - other.m_index; }
+        iterator operator-(size_t value) const
+        { return iterator(m_index - value, m_container); }
+        iterator operator+(size_t value) const
+        { return iterator(m_index + value, m_container); }
+        iterator& operator=(const iterator& other)
+        { m_index = other.m_index; return *this; }
+
+        bool operator==(const iterator& other) const { return m_index == other.m_index; }
+        bool operator!=(const iterator& other) const { return m_index != other.m_index; }
+        bool operator<(const iterator& other)  const { return m_index <  other.m_index; }
+        bool operator<=(const iterator& other) const { return m_index <= other.m_index; }
+        bool operator>(const iterator& other)  const { return m_index >  other.m_index; }
+        bool operator>=(const iterator& other) const { return m_index >= other.m_index; }
+
+        bool operator==(const const_iterator& other) const { return m_index == other.m_index; }
+        bool operator!=(const const_iterator& other) const { return m_index != other.m_index; }
+        bool operator<(const const_iterator& other)  const { return m_index <  other.m_index; }
+        bool operator<=(const const_iterator& other) const { return m_index <= other.m_index; }
+        bool operator>(const const_iterator& other)  const { return m_index >  other.m_index; }
+        bool operator>=(const const_iterator& other) const { return m_index >= other.m_index; }
+
+        friend struct const_iterator;
+    private:
+        size_t m_index;
+        basic_circular_buffer& m_container;
+    };
+
+    struct const_iterator final
+    {
+        using iterator_category = std::random_access_iterator_tag;
+        using difference_type   = size_t;
+        using value_type        = const T;
+        using pointer           = const value_type*;
+        using reference         = const value_type&;
+
+        const_iterator(size_t index, const basic_circular_buffer& container)
+            : m_index{index}
+            , m_container{container}
+        {}
+        const_iterator(const const_iterator&) = default;
+        const_iterator(const_iterator&&) = default;
+        ~const_iterator() = default;
+
+        const_iterator& operator++() { ++m_index; return *this; }
+        const_iterator& operator--() { --m_index; return *this; }
+        reference operator*() const { return m_container.at(m_index); }
+
+        difference_type operator-(const const_iterator& other) const
+        { return m_index - other.m_index; }
+        const_iterator operator-(size_t value) const
+        { return const_iterator(m_index - value, m_container); }
+        const_iterator operator+(size_t value) const
+        { return const_iterator(m_index + value, m_container); }
+        const_iterator& operator=(const const_iterator& other)
+        { m_index = other.m_index; return *this; }
+
+        bool operator==(const const_iterator& other) const { return m_index == other.m_index; }
+        bool operator!=(const const_iterator& other) const { return m_index != other.m_index; }
+        bool operator<(const const_iterator& other)  const { return m_index <  other.m_index; }
+        bool operator<=(const const_iterator& other) const { return m_index <= other.m_index; }
+        bool operator>(const const_iterator& other)  const { return m_index >  other.m_index; }
+        bool operator>=(const const_iterator& other) const { return m_index >= other.m_index; }
+
+        bool operator==(const iterator& other) const { return m_index == other.m_index; }
+        bool operator!=(const iterator& other) const { return m_index != other.m_index; }
+        bool operator<(const iterator& other)  const { return m_index <  other.m_index; }
+        bool operator<=(const iterator& other) const { return m_index <= other.m_index; }
+        bool operator>(const iterator& other)  const { return m_index >  other.m_index; }
+        bool operator>=(const iterator& other) const { return m_index >= other.m_index; }
+
+        friend struct iterator;
+    private:
+        size_t m_index;
+        const basic_circular_buffer& m_container;
+    };
+
+
+    /**
+     * @param size      максимальное количество элементов
+     * @param allocator аллокатор хранилища ячеек
+     */
+    basic_circular_buffer(size_t size,
+                          const allocator_type& allocator = allocator_type());
+
+    template<typename ForwardInputIterator>
+    basic_circular_buffer(ForwardInputIterator begin,
+                          ForwardInputIterator end,
+                          const allocator_type& allocator = allocator_type());
+
+    basic_circular_buffer(const basic_circular_buffer& other) = delete;
+    basic_circular_buffer(basic_circular_buffer&& other) = delete;
+    basic_circular_buffer& operator=(const basic_circular_buffer&) = delete;
+    basic_circular_buffer& operator=(basic_circular_buffer&&) = delete;
+
+    ~basic_circular_buffer();
+
+    /**
+     * @brief Определить пуст ли буфер
+     * @return флаг пустоты буфера
+     */
+    bool empty() const noexcept;
+
+    /**
+     * @brief   Очистить буфер.
+     *          Для единственного читателя - перенос R на W',
+     *          для нескольких - извлечение всех элементов
+     */
+    void clear() noexcept;
+
+    /**
+     * @brief Определить полон ли буфер
+     * @return флаг полноты буфера
+     */
+    bool full() const noexcept;
+
+    /**
+     * @brief Получить количество элементов в буфере
+     * @return количество элементов
+     */
+    size_t size() const noexcept;
+
+    /**
+     * @brief Получить размер буфера
+     * @return максимальное количество элементов в буфере
+     */
+    size_t max_size() const noexcept;
+
+    /**
+     * @brief Получить аллокатор хранилища
+     * @return копия аллокатора
+     */
+    allocator_type get_allocator() const;
+
+    /**
+     * @brief   Получить хранилище ячеек (например, mmap_storage::mapping()
+     *          сообщает, чем обеспечена память)
+     * @return ссылка на хранилище
+     */
+    const StoragePolicy& storage() const noexcept;
+
+    /**
+     * @brief   Получить снимок статистики (суммируется по шардам счетчиков).
+     *          При StatsPolicy = no_stats все значения нулевые
+     * @return статистика буфера
+     */
+    buffer_stats stats() const noexcept;
+
+    /**
+     * @brief   Получить гистограмму времени пребывания элементов в буфере
+     *          (от захвата ячейки писателем до захвата читателем).
+     *          Только для StatsPolicy = dwell_stats
+     * @param reset обнулить гистограмму после чтения
+     * @return снимок гистограммы
+     */
+    latency_snapshot dwell_times(bool reset = false);
+
+    /**
+     * @brief   Получить доступ к элементу буфера без изменения его состояния.
+     *          Только для единственного читателя
+     * @param pos индекс элемента
+     * @return ссылка на элемент
+     */
+    T& at(size_t pos);
+
+    /**
+     * @brief   Получить доступ к элементу буфера без изменения его состояния.
+     *          Только для единственного читателя
+     * @param pos индекс элемента
+     * @return ссылка на элемент
+     */
+    const T& at(size_t pos) const;
+
+    /**
+     * @brief Добавить элемент в конец буфера
+     * @param value значение элемента
+     * @return флаг успешности добавления (буфер может быть заполнен)
+     */
+    template<typename Type>
+    bool try_push_back(Type&& value);
+
+    /**
+     * @brief Создать и добавить элемент в конец буфера
+     * @param args параметры конструктора типа T
+     * @return флаг успешности добавления (буфер может быть заполнен)
+     */
+    template<typename ... Args>
+    bool try_emplace_back(Args&& ... args);
+
+    /**
+     * @brief Получить очередной элемент буфера
+     * @param result ссылка, куда должно быть положено значение
+     * @return флаг успешности операции (буфер может быть пуст)
+     */
+    bool try_pop(T& result);
+
+    /**
+     * @brief   Добавить элемент в конец буфера.
+     *          Если буфер заполнен, ждать согласно WaitPolicy
+     * @param value значение элемента
+     * @return WaitStatus::success или WaitStatus::shutdown
+     */
+    template<typename Type>
+    WaitStatus push_back_wait(Type&& value);
+
+    /**
+     * @brief   Добавить элемент, ожидая свободного места не дольше timeout
+     * @param value   значение элемента
+     * @param timeout максимальное время ожидания
+     * @return результат операции
+     */
+    template<typename Type, typename Rep, typename Period>
+    WaitStatus push_back_wait_for(Type&& value,
+                                  const std::chrono::duration<Rep, Period>& timeout);
+
+    /**
+     * @brief   Добавить элемент, ожидая свободного места не позже deadline
+     * @param value    значение элемента
+     * @param deadline момент окончания ожидания
+     * @return результат операции
+     */
+    template<typename Type, typename Clock, typename Duration>
+    WaitStatus push_back_wait_until(Type&& value,
+                                    const std::chrono::time_point<Clock, Duration>& deadline);
+
+    /**
+     * @brief   Получить очередной элемент.
+     *          Если буфер пуст, ждать согласно WaitPolicy
+     * @param result ссылка, куда должно быть положено значение
+     * @return WaitStatus::success или WaitStatus::shutdown
+     */
+    WaitStatus pop_wait(T& result);
+
+    /**
+     * @brief   Получить очередной элемент, ожидая данных не дольше timeout
+     * @param result  ссылка, куда должно быть положено значение
+     * @param timeout максимальное время ожидания
+     * @return результат операции (при неудаче result не изменяется)
+     */
+    template<typename Rep, typename Period>
+    WaitStatus pop_wait_for(T& result,
+                            const std::chrono::duration<Rep, Period>& timeout);
+
+    /**
+     * @brief   Получить очередной элемент, ожидая данных не позже deadline
+     * @param result   ссылка, куда должно быть положено значение
+     * @param deadline момент окончания ожидания
+     * @return результат операции (при неудаче result не изменяется)
+     */
+    template<typename Clock, typename Duration>
+    WaitStatus pop_wait_until(T& result,
+                              const std::chrono::time_point<Clock, Duration>& deadline);
+
+#ifdef CIRCULAR_BUFFER_HAS_COROUTINES
+    /**
+     * @brief   co_await pop(): получить очередной элемент. Если буфер
+     *          пуст, сопрограмма приостанавливается и возобновляется
+     *          в потоке писателя. Только для WaitPolicy = coro_wait
+     * @return объект ожидания; co_await возвращает std::optional<T>
+     *         (пусто после shutdown())
+     */
+    detail::pop_awaiter<basic_circular_buffer, T> pop();
+
+    /**
+     * @brief   co_await push(value): добавить элемент. Если буфер
+     *          заполнен, сопрограмма приостанавливается и возобновляется
+     *          в потоке читателя. Только для WaitPolicy = coro_wait
+     * @param value значение элемента (должно жить до завершения co_await)
+     * @return объект ожидания; co_await возвращает WaitStatus
+     */
+    template<typename Type>
+    detail::push_awaiter<basic_circular_buffer, Type> push(Type&& value);
+#endif
+
+    /**
+     * @brief   Завершить работу буфера: все ожидающие и последующие
+     *          ожидающие операции возвращают WaitStatus::shutdown.
+     *          Вызывается деструктором
+     */
+    void shutdown();
+
+    /**
+     * @brief   Добавить элементы из диапазона контейнера в буфер
+     *          (пока есть место). Читатели пробуждаются один раз на
+     *          весь диапазон
+     * @param begin итератор начала диапазона контейнера
+     * @param end   итератор конца диапазона контейнера
+     * @return количество записанных элементов
+     */
+    template<typename ForwardInputIterator>
+    size_t push_back_all(ForwardInputIterator begin, ForwardInputIterator end);
+
+    /**
+     * @brief Получить все доступные элементы в контейнер
+     * @param container контейнер назначения
+     * @return количество полученных элементов
+     */
+    template<typename ContainerType>
+    size_t pop_all(ContainerType& container);
+
+    /**
+     * @brief   Добавить до count элементов одним захватом позиций (один
+     *          CAS по W и одно продвижение W' на всю серию вместо
+     *          операции на элемент). Итератор не должен бросать
+     *          исключений: захваченные позиции должны быть заполнены
+     * @param begin итератор первого элемента (std::move_iterator - перемещение)
+     * @param count количество элементов
+     * @return количество записанных элементов (сколько было места)
+     */
+    template<typename InputIterator>
+    size_t try_push_back_n(InputIterator begin, size_t count);
+
+    /**
+     * @brief   Получить до count элементов одним захватом позиций
+     *          (один CAS по R и одно продвижение R' на всю серию)
+     * @param out   итератор вывода
+     * @param count максимальное количество элементов
+     * @return количество полученных элементов
+     */
+    template<typename OutputIterator>
+    size_t try_pop_n(OutputIterator out, size_t count);
+
+    /**
+     * @brief Получить итератор на начало контейнера
+     * @return итератор на первый элемент
+     */
+    iterator begin();
+
+    /**
+     * @brief Получить итератор на конец контейнера
+     * @return итератор за последним элементом
+     */
+    iterator end();
+
+    /**
+     * @brief Получить константный итератор на начало контейнера
+     * @return итератор на первый элемент
+     */
+    const_iterator cbegin() const;
+
+    /**
+     * @brief Получить константный итератор на конец контейнера
+     * @return итератор за последним элементом
+     */
+    const_iterator cend() const;
+
+private:
+    /**
+     * @brief Получить позицию в кольцевом буфере
+     * @param position текущая позиция
+     * @param n        количество сдвигов
+     * @return новая позиция
+     */
+    size_t next(size_t position, size_t n = 1) const noexcept;
+
+    /**
+     * @brief Захватить позицию записи (W)
+     * @param position захваченная позиция
+     * @return флаг успешности (буфер может быть заполнен)
+     */
+    bool claim_write(size_t& position) noexcept;
+
+    /**
+     * @brief Количество свободных позиций после W
+     */
+    size_t writable(size_t W) const noexcept;
+
+    /**
+     * @brief Количество заполненных позиций после R
+     */
+    size_t readable(size_t R) const noexcept;
+
+    /**
+     * @brief Завершить запись в позицию (W')
+     */
+    void publish_write(size_t position);
+
+    /**
+     * @brief   Добавить элемент без пробуждения читателей
+     *          (try_push_back и ожидающие сопрограммы)
+     * @return флаг успешности добавления
+     */
+    template<typename Type>
+    bool put(Type&& value);
+
+    /**
+     * @brief   Извлечь элемент без пробуждения писателей
+     *          (try_pop и ожидающие сопрограммы)
+     * @return флаг успешности извлечения
+     */
+    bool take(T& result);
+
+    /**
+     * @brief Ожидающие сопрограммы (WaitPolicy = coro_wait)
+     */
+    detail::coro_waiters& coro_waiters() noexcept;
+
+    void clear(std::false_type) noexcept;
+    void clear(std::true_type) noexcept;
+
+    /**
+     * @brief   Добавить элемент, ожидая свободного места
+     * @param value    значение элемента
+     * @param deadline момент окончания ожидания (nullptr - без ограничения)
+     * @return результат операции
+     */
+    template<typename Type, typename Clock, typename Duration>
+    WaitStatus push_wait_impl(Type&& value,
+                              const std::chrono::time_point<Clock, Duration>* deadline);
+
+    /**
+     * @brief   Получить элемент, ожидая данных
+     * @param result   ссылка, куда должно быть положено значение
+     * @param deadline момент окончания ожидания (nullptr - без ограничения)
+     * @return результат операции
+     */
+    template<typename Clock, typename Duration>
+    WaitStatus pop_wait_impl(T& result,
+                             const std::chrono::time_point<Clock, Duration>* deadline);
+};
+
+
+// Implementation
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+basic_circular_buffer(size_t size, const allocator_type& allocator)
+    : m_data(size + 1, allocator)   // +1 - резервный элемент, чтобы отличать
+                                    // состояния "пуст" и "полон"
+    , m_read{}
+    , m_write{}
+    , m_wait{}
+    , m_delete{false}
+    , m_stats{m_data.size()}
+{}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+template<typename ForwardInputIterator>
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+basic_circular_buffer(ForwardInputIterator begin,
+                      ForwardInputIterator end,
+                      const allocator_type& allocator)
+    : m_data(std::distance(begin, end) + 1, allocator)
+    , m_read{}
+    , m_write{}
+    , m_wait{}
+    , m_delete{false}
+    , m_stats{m_data.size()}
+{
+    push_back_all(begin, end);
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+~basic_circular_buffer()
+{
+    shutdown();
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+void
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+shutdown()
+{
+    m_delete = true;
+    m_wait.shutdown();
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+bool
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+empty() const noexcept
+{
+    size_t R = m_read .claimed (std::memory_order_relaxed);
+    size_t W = m_write.complete(std::memory_order_acquire);
+
+    return R == W;
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+bool
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+full() const noexcept
+{
+    size_t W = m_write.claimed (std::memory_order_relaxed);
+    size_t R = m_read .complete(std::memory_order_acquire);
+
+    return next(W) == R;
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+size_t
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+size() const noexcept
+{
+    size_t writePos = m_write.complete(std::memory_order_acquire);
+    size_t readPos  = m_read .claimed (std::memory_order_relaxed);
+
+    if(writePos < readPos)
+        return m_data.size() + writePos - readPos;
+
+    return writePos - readPos;
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+size_t
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+max_size() const noexcept
+{
+    // -1 так как не считается резервный элемент
+    return m_data.size() - 1;
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+const StoragePolicy&
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+storage() const noexcept
+{
+    return m_data;
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+buffer_stats
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+stats() const noexcept
+{
+    return m_stats.snapshot();
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+latency_snapshot
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+dwell_times(bool reset)
+{
+    static_assert(StatsPolicy::dwell, "dwell_times() requires dwell_stats StatsPolicy");
+
+    return m_stats.dwell(reset);
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+typename StoragePolicy::allocator_type
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+get_allocator() const
+{
+    return m_data.get_allocator();
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+void
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+clear() noexcept
+{
+    clear(multi_consumer_tag{});
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+void
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+clear(std::false_type) noexcept
+{
+    // acquire: отбрасываемые ячейки перезапишут писатели следующего
+    // круга, их записи должны следовать за записями, опубликованными в W'
+    m_read.reset(m_write.complete(std::memory_order_acquire));
+    m_wait.notify_writable();
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+void
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+clear(std::true_type) noexcept
+{
+    // R нельзя просто перенести: другие читатели могут находиться
+    // между захватом и завершением
+    T value{};
+    while(try_pop(value)) {}
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+T&
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+at(size_t pos)
+{
+    static_assert(! ConsumerPolicy::multi,
+                  "at() requires single_consumer: other readers may take the element");
+
+    if(pos >= size())
+        throw std::out_of_range("CircularBuffer::at: no such index");
+
+    return m_data[next(m_read.complete(std::memory_order_relaxed), pos)];
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+const T&
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+at(size_t pos) const
+{
+    static_assert(! ConsumerPolicy::multi,
+                  "at() requires single_consumer: other readers may take the element");
+
+    if(pos >= size())
+        throw std::out_of_range("CircularBuffer::at: no such index");
+
+    return m_data[next(m_read.complete(std::memory_order_relaxed), pos)];
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+bool
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+claim_write(size_t& position) noexcept
+{
+    bool claimed = m_write.claim(
+                position,
+                [this](size_t W) {
+                    return next(W) == m_read.complete(std::memory_order_acquire);
+                },
+                [this](size_t W) { return next(W); },
+                [this]() { m_stats.cas_retry(); });
+
+    if(claimed)
+        m_stats.enqueued(position);
+    else
+        m_stats.push_failed();
+
+    return claimed;
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+void
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+publish_write(size_t position)
+{
+    m_write.publish(position, next(position));
+
+    m_stats.pushed();
+    m_stats.occupancy([this]() { return size(); });
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+template<typename Type>
+bool
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+put(Type&& value)
+{
+    size_t position;
+    if(! claim_write(position))
+        return false;
+
+    m_data[position] = std::forward<Type>(value);
+
+    publish_write(position);
+    return true;
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+template<typename Type>
+bool
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+try_push_back(Type&& value)
+{
+    if(! put(std::forward<Type>(value)))
+        return false;
+
+    m_wait.notify_readable();
+    return true;
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+template<typename ... Args>
+bool
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+try_emplace_back(Args&& ... args)
+{
+    size_t position;
+    if(! claim_write(position))
+        return false;
+
+    m_data[position] = T{std::forward<Args>(args) ... };
+
+    publish_write(position);
+    m_wait.notify_readable();
+    return true;
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+bool
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+take(T& result)
+{
+    size_t position;
+    bool claimed = m_read.claim(
+                position,
+                [this](size_t R) {
+                    return R == m_write.complete(std::memory_order_acquire);
+                },
+                [this](size_t R) { return next(R); },
+                [this]() { m_stats.cas_retry(); });
+
+    if(! claimed) {
+        m_stats.pop_failed();
+        return false;
+    }
+
+    m_stats.dequeued(position);
+    result = std::move_if_noexcept(m_data[position]);
+
+    m_read.publish(position, next(position));
+    m_stats.popped();
+    return true;
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+bool
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+try_pop(T& result)
+{
+    if(! take(result))
+        return false;
+
+    m_wait.notify_writable();
+    return true;
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+detail::coro_waiters&
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+coro_waiters() noexcept
+{
+    return m_wait.waiters();
+}
+
+#ifdef CIRCULAR_BUFFER_HAS_COROUTINES
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+detail::pop_awaiter<basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>, T>
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+pop()
+{
+    static_assert(std::is_same<WaitPolicy, coro_wait>::value,
+                  "co_await pop() requires WaitPolicy = coro_wait");
+
+    return detail::pop_awaiter<basic_circular_buffer, T>(*this);
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+template<typename Type>
+detail::push_awaiter<basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>, Type>
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+push(Type&& value)
+{
+    static_assert(std::is_same<WaitPolicy, coro_wait>::value,
+                  "co_await push() requires WaitPolicy = coro_wait");
+
+    return detail::push_awaiter<basic_circular_buffer, Type>(*this, std::forward<Type>(value));
+}
+#endif
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+template<typename Type>
+WaitStatus
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+push_back_wait(Type&& value)
+{
+    return push_wait_impl(
+                std::forward<Type>(value),
+                static_cast<const std::chrono::steady_clock::time_point*>(nullptr));
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+template<typename Type, typename Rep, typename Period>
+WaitStatus
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+push_back_wait_for(Type&& value, const std::chrono::duration<Rep, Period>& timeout)
+{
+    return push_back_wait_until(std::forward<Type>(value),
+                                std::chrono::steady_clock::now() + timeout);
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+template<typename Type, typename Clock, typename Duration>
+WaitStatus
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+push_back_wait_until(Type&& value,
+                     const std::chrono::time_point<Clock, Duration>& deadline)
+{
+    return push_wait_impl(std::forward<Type>(value), &deadline);
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+template<typename Type, typename Clock, typename Duration>
+WaitStatus
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+push_wait_impl(Type&& value,
+               const std::chrono::time_point<Clock, Duration>* deadline)
+{
+    while(true) {
+        if(m_delete)
+            return WaitStatus::shutdown;
+
+        // value перемещается только при успешном захвате позиции
+        if(try_push_back(std::forward<Type>(value)))
+            return WaitStatus::success;
+
+        WaitStatus status = m_stats.timed_wait([&]() {
+            return m_wait.wait_writable(
+                        [this]() { return ! full(); }, m_delete, deadline);
+        });
+
+        if(status != WaitStatus::success)
+            return status;
+    }
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+WaitStatus
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+pop_wait(T& result)
+{
+    return pop_wait_impl(
+                result,
+                static_cast<const std::chrono::steady_clock::time_point*>(nullptr));
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+template<typename Rep, typename Period>
+WaitStatus
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+pop_wait_for(T& result, const std::chrono::duration<Rep, Period>& timeout)
+{
+    return pop_wait_until(result, std::chrono::steady_clock::now() + timeout);
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+template<typename Clock, typename Duration>
+WaitStatus
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+pop_wait_until(T& result, const std::chrono::time_point<Clock, Duration>& deadline)
+{
+    return pop_wait_impl(result, &deadline);
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+template<typename Clock, typename Duration>
+WaitStatus
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+pop_wait_impl(T& result, const std::chrono::time_point<Clock, Duration>* deadline)
+{
+    while(true) {
+        if(m_delete)
+            return WaitStatus::shutdown;
+
+        if(try_pop(result))
+            return WaitStatus::success;
+
+        WaitStatus status = m_stats.timed_wait([&]() {
+            return m_wait.wait_readable(
+                        [this]() { return ! empty(); }, m_delete, deadline);
+        });
+
+        if(status != WaitStatus::success)
+            return status;
+    }
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+typename basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::iterator
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+begin()
+{
+    return iterator(0, *this);
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+typename basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::iterator
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+end()
+{
+    return iterator(size(), *this);
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+typename basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::const_iterator
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+cbegin() const
+{
+    return const_iterator(0, *this);
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+typename basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::const_iterator
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+cend() const
+{
+    return const_iterator(size(), *this);
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+size_t
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+next(size_t position, size_t n) const noexcept
+{
+    return (position + n) % m_data.size();
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+template<typename ForwardInputIterator>
+size_t
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+push_back_all(ForwardInputIterator begin, ForwardInputIterator end)
+{
+    size_t counter{0};
+
+    while(begin != end) {
+        if(! put(*begin))
+            break;
+
+        ++counter;
+
+        begin = std::next(begin);
+    }
+
+    if(counter != 0)
+        m_wait.notify_readable(counter);
+
+    return counter;
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+template<typename ContainerType>
+size_t
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+pop_all(ContainerType& container)
+{
+    container.reserve(container.size() + size());
+
+    size_t counter{0};
+
+    T value{};
+
+    while(take(value)) {
+        container.push_back(std::move(value));
+        ++counter;
+    }
+
+    if(counter != 0)
+        m_wait.notify_writable(counter);
+
+    return counter;
+}
+
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+size_t
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+writable(size_t W) const noexcept
+{
+    size_t R = m_read.complete(std::memory_order_acquire);
+
+    // -1 - резервный элемент
+    return (R + m_data.size() - W - 1) % m_data.size();
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+size_t
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+readable(size_t R) const noexcept
+{
+    size_t W = m_write.complete(std::memory_order_acquire);
+
+    return (W + m_data.size() - R) % m_data.size();
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+template<typename InputIterator>
+size_t
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+try_push_back_n(InputIterator begin, size_t count)
+{
+    if(count == 0)
+        return 0;
+
+    // размер серии вычисляется при каждой попытке CAS
+    size_t position;
+    size_t claimed{0};
+
+    bool success = m_write.claim(
+                position,
+                [this](size_t W) { return writable(W) == 0; },
+                [this, count, &claimed](size_t W) {
+                    claimed = std::min(count, writable(W));
+                    return next(W, claimed);
+                },
+                [this]() { m_stats.cas_retry(); });
+
+    if(! success) {
+        m_stats.push_failed();
+        return 0;
+    }
+
+    // единственный писатель захватывает без вызова next
+    if(! ProducerPolicy::multi)
+        claimed = std::min(count, writable(position));
+
+    for(size_t i = 0; i < claimed; ++i, ++begin) {
+        size_t slot = next(position, i);
+        m_stats.enqueued(slot);
+        m_data[slot] = *begin;
+    }
+
+    m_write.publish(position, next(position, claimed));
+
+    m_stats.pushed(claimed);
+    m_stats.occupancy([this]() { return size(); });
+
+    m_wait.notify_readable(claimed);
+    return claimed;
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename WaitPolicy, typename StoragePolicy, typename StatsPolicy>
+template<typename OutputIterator>
+size_t
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, WaitPolicy, StoragePolicy, StatsPolicy>::
+try_pop_n(OutputIterator out, size_t count)
+{
+    if(count == 0)
+        return 0;
+
+    size_t position;
+    size_t claimed{0};
+
+    bool success = m_read.claim(
+                position,
+                [this](size_t R) { return readable(R) == 0; },
+                [this, count, &claimed](size_t R) {
+                    claimed = std::min(count, readable(R));
+                    return next(R, claimed);
+                },
+                [this]() { m_stats.cas_retry(); });
+
+    if(! success) {
+        m_stats.pop_failed();
+        return 0;
+    }
+
+    // единственный читатель захватывает без вызова next
+    if(! ConsumerPolicy::multi)
+        claimed = std::min(count, readable(position));
+
+    for(size_t i = 0; i < claimed; ++i, ++out) {
+        size_t slot = next(position, i);
+        m_stats.dequeued(slot);
+        *out = std::move_if_noexcept(m_data[slot]);
+    }
+
+    m_read.publish(position, next(position, claimed));
+    m_stats.popped(claimed);
+
+    m_wait.notify_writable(claimed);
+    return claimed;
+}
+
+}
+#endif // CIRCULAR_BUFFER_BASIC_H
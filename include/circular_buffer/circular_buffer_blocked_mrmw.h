@@ -1,54 +1,142 @@
 #ifndef CIRCULAR_BUFFER_BLOCKED_MRMW_H
 #define CIRCULAR_BUFFER_BLOCKED_MRMW_H
 
-#include <vector>
+#include <memory>
 #include <mutex>
 #include <atomic>
 #include <condition_variable>
 #include <stdexcept>
+#include <iterator>
+#include <algorithm>
+#include <chrono>
+
+#include "circular_buffer_fwd.h"
+#include "circular_buffer_auto_resize.h"
+#include "circular_buffer_basic.h"
+#include "circular_buffer_coro.h"
+#include "circular_buffer_spin.h"
+#include "circular_buffer_stats.h"
+#include "circular_buffer_wait_status.h"
 
 namespace connest {
+
 /**
   @brief    Циклический буфер multiple reader - multiple writter
             основанный на блокировании мьютекса
+  @details
+        Специализация basic_circular_buffer для block_wait
+        (CircularBuffer_mrmw_blocked). Все операции сериализуются
+        мьютексом, поэтому ProducerPolicy / ConsumerPolicy на алгоритм
+        не влияют. resize и автоматическое изменение размера требуют
+        StoragePolicy::resizable. При StatsPolicy = count_stats
+        stats() дополнительно сообщает время сна на условных переменных
  */
-template <typename T>
-class CircularBuffer_mrmw_blocked final
+template <typename T,
+          typename ProducerPolicy,
+          typename ConsumerPolicy,
+          typename StoragePolicy,
+          typename StatsPolicy>
+class basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy> final
 {
     static_assert ( std::is_default_constructible<T>::value,
                     "Type T must be default constructible: empty buffer should "
                     "have initialized elements");
 
-    std::vector<T> m_data;
+    StoragePolicy m_data;
 
     mutable std::mutex m_mutex;
-    std::condition_variable m_cv;
+    std::condition_variable m_not_empty;    // ждут читатели
+    std::condition_variable m_not_full;     // ждут писатели
 
     size_t m_head;
     size_t m_tail;
 
+    // количество потоков, ожидающих на m_not_empty / m_not_full
+    // (защищены m_mutex)
+    size_t m_waiting_readers;
+    size_t m_waiting_writers;
+
+    // автоматическое изменение размера (защищено m_mutex)
+    bool m_auto_resize;
+    AutoResizePolicy m_auto_resize_policy;
+    size_t m_high_streak;
+    size_t m_low_streak;
+
+    // размер, выбранный AutoResizePolicy: память выделяется и элементы
+    // переносятся вне операции, которая его выбрала (apply_auto_resize).
+    // m_resize_from / m_resize_to защищены m_mutex
+    std::atomic_bool m_resize_requested;
+    size_t m_resize_from;
+    size_t m_resize_to;
+
+    // копии заполненности и размера для проверок без мьютекса
+    // (изменяются под m_mutex)
+    std::atomic<size_t> m_size;
+    std::atomic<size_t> m_max_size;
+
+    // активное ожидание перед сном на условной переменной: у читателей
+    // и писателей свой бюджет - время ожидания данных и места различно
+    detail::AdaptiveSpin m_read_spin;
+    detail::AdaptiveSpin m_write_spin;
+
     std::atomic_bool m_delete;
 
+    detail::stats_state<StatsPolicy> m_stats;
+
+    // сопрограммы в co_await push / pop
+    detail::coro_waiters m_coro;
+
+    friend struct detail::coro_access;
+
 public:
-    CircularBuffer_mrmw_blocked(size_t size);
+    using value_type     = T;
+    using allocator_type = typename StoragePolicy::allocator_type;
 
-    CircularBuffer_mrmw_blocked(const CircularBuffer_mrmw_blocked& other) = delete;
-    CircularBuffer_mrmw_blocked(CircularBuffer_mrmw_blocked&& other) = delete;
+    /**
+     * @param size      максимальное количество элементов
+     * @param allocator аллокатор хранилища ячеек (используется и при resize)
+     */
+    basic_circular_buffer(size_t size,
+                          const allocator_type& allocator = allocator_type());
 
+    basic_circular_buffer(const basic_circular_buffer& other) = delete;
+    basic_circular_buffer(basic_circular_buffer&& other) = delete;
 
-    ~CircularBuffer_mrmw_blocked();
+
+    ~basic_circular_buffer();
 
     /**
-     * @brief Получить размер данных в буфере
+     * @brief   Получить размер данных в буфере.
+     *          Без блокировки мьютекса (значение может сразу устареть)
      * @return количество элементов в буфере
      */
     size_t size() const noexcept;
 
     /**
-     * @brief Изменить размер буфера
+     * @brief   Изменить размер буфера с сохранением содержимого.
+     *          Элементы перемещаются в новое хранилище по порядку,
+     *          ожидающие писатели пробуждаются
      * @param newSize Новый размер
+     * @return false, если newSize меньше количества элементов в буфере
+     *         (буфер не изменяется)
+     */
+    bool resize(size_t newSize);
+
+    /**
+     * @brief   Включить автоматическое изменение размера буфера.
+     *          Новое хранилище выделяется вне мьютекса после операции,
+     *          которая выбрала размер; при нехватке памяти размер не
+     *          меняется
+     * @param policy границы размера и пороги заполненности
+     * @throw std::invalid_argument, если min_size > max_size,
+     *        low_watermark >= high_watermark или window == 0
+     */
+    void set_auto_resize(const AutoResizePolicy& policy);
+
+    /**
+     * @brief Отключить автоматическое изменение размера буфера
      */
-    void resize(size_t newSize) noexcept;
+    void disable_auto_resize();
 
     /**
      * @brief Получить размер буфера
@@ -57,13 +145,45 @@ public:
     size_t max_size() const noexcept;
 
     /**
-     * @brief Проверить буфер на пустоту
+     * @brief Получить аллокатор хранилища
+     * @return копия аллокатора
+     */
+    allocator_type get_allocator() const;
+
+    /**
+     * @brief   Получить хранилище ячеек (например, mmap_storage::mapping()
+     *          сообщает, чем обеспечена память).
+     *          Хранилище заменяется при resize
+     * @return ссылка на хранилище
+     */
+    const StoragePolicy& storage() const noexcept;
+
+    /**
+     * @brief   Получить снимок статистики (суммируется по шардам счетчиков).
+     *          При StatsPolicy = no_stats все значения нулевые
+     * @return статистика буфера
+     */
+    buffer_stats stats() const noexcept;
+
+    /**
+     * @brief   Получить гистограмму времени пребывания элементов в буфере
+     *          (от захвата ячейки писателем до захвата читателем).
+     *          Только для StatsPolicy = dwell_stats
+     * @param reset обнулить гистограмму после чтения
+     * @return снимок гистограммы
+     */
+    latency_snapshot dwell_times(bool reset = false);
+
+    /**
+     * @brief   Проверить буфер на пустоту.
+     *          Без блокировки мьютекса (значение может сразу устареть)
      * @return флаг пустоты
      */
     bool empty() const noexcept;
 
     /**
-     * @brief Проверить буфер на заполненность
+     * @brief   Проверить буфер на заполненность.
+     *          Без блокировки мьютекса (значение может сразу устареть)
      * @return флаг полноты
      */
     bool full() const noexcept;
@@ -80,9 +200,32 @@ public:
      * @brief   Добавить элемент в буфер.
      *          Если буфер заполнен, приостановить выполнения потока
      * @param value значение элемента
+     * @return WaitStatus::success или WaitStatus::shutdown
      */
     template<typename Type>
-    void push_back_wait(Type&& value);
+    WaitStatus push_back_wait(Type&& value);
+
+    /**
+     * @brief   Добавить элемент в буфер, ожидая свободного места
+     *          не дольше timeout
+     * @param value   значение элемента
+     * @param timeout максимальное время ожидания
+     * @return результат операции
+     */
+    template<typename Type, typename Rep, typename Period>
+    WaitStatus push_back_wait_for(Type&& value,
+                                  const std::chrono::duration<Rep, Period>& timeout);
+
+    /**
+     * @brief   Добавить элемент в буфер, ожидая свободного места
+     *          не позже deadline
+     * @param value    значение элемента
+     * @param deadline момент окончания ожидания
+     * @return результат операции
+     */
+    template<typename Type, typename Clock, typename Duration>
+    WaitStatus push_back_wait_until(Type&& value,
+                                    const std::chrono::time_point<Clock, Duration>& deadline);
 
     /**
      * @brief Попытаться получить очередной элемент.
@@ -95,8 +238,136 @@ public:
      * @brief   Получить очередной элемент.
      *          Если буфер пуст, приостановить выполнения потока
      * @param result Ссылка на место помещения результата
+     * @return  WaitStatus::success или WaitStatus::shutdown
+     *          (result не изменяется)
+     */
+    WaitStatus pop_wait(T& result);
+
+    /**
+     * @brief   Получить очередной элемент, ожидая данных не дольше timeout
+     * @param result  Ссылка на место помещения результата
+     * @param timeout максимальное время ожидания
+     * @return результат операции (при неудаче result не изменяется)
+     */
+    template<typename Rep, typename Period>
+    WaitStatus pop_wait_for(T& result,
+                            const std::chrono::duration<Rep, Period>& timeout);
+
+    /**
+     * @brief   Получить очередной элемент, ожидая данных не позже deadline
+     * @param result   Ссылка на место помещения результата
+     * @param deadline момент окончания ожидания
+     * @return результат операции (при неудаче result не изменяется)
+     */
+    template<typename Clock, typename Duration>
+    WaitStatus pop_wait_until(T& result,
+                              const std::chrono::time_point<Clock, Duration>& deadline);
+
+    /**
+     * @brief   Добавить элементы из диапазона контейнера в буфер.
+     *          За один захват мьютекса записывается столько элементов,
+     *          сколько помещается; поток приостанавливается, только
+     *          если буфер заполнен
+     * @param begin итератор начала диапазона контейнера
+     * @param end   итератор конца диапазона контейнера
+     * @return количество записанных элементов (меньше размера диапазона
+     *         только при завершении работы буфера)
+     */
+    template<typename ForwardInputIterator>
+    size_t push_back_wait_n(ForwardInputIterator begin, ForwardInputIterator end);
+
+    /**
+     * @brief   Получить до max элементов за один захват мьютекса.
+     *          Если буфер пуст, приостановить выполнения потока
+     * @param out итератор, куда помещаются результаты
+     * @param max максимальное количество получаемых элементов
+     * @return количество полученных элементов
+     */
+    template<typename OutputIterator>
+    size_t pop_wait_n(OutputIterator out, size_t max);
+
+    /**
+     * @brief   Получить все доступные элементы в контейнер.
+     *          Если буфер пуст, приостановить выполнения потока
+     * @param container контейнер назначения
+     * @return количество полученных элементов
+     */
+    template<typename ContainerType>
+    size_t pop_wait_all(ContainerType& container);
+
+    /**
+     * @brief   Добавить до count элементов за один захват мьютекса
+     *          без ожидания (сколько помещается)
+     * @param begin итератор первого элемента (std::move_iterator - перемещение)
+     * @param count количество элементов
+     * @return количество записанных элементов
+     */
+    template<typename InputIterator>
+    size_t try_push_back_n(InputIterator begin, size_t count);
+
+    /**
+     * @brief   Получить до count элементов за один захват мьютекса
+     *          без ожидания
+     * @param out   итератор, куда помещаются результаты
+     * @param count максимальное количество элементов
+     * @return количество полученных элементов
+     */
+    template<typename OutputIterator>
+    size_t try_pop_n(OutputIterator out, size_t count);
+
+    /**
+     * @brief   Накопить count элементов, ожидая не дольше timeout.
+     *          Поток спит, пока данных нет, и забирает все доступные
+     *          элементы (но не больше count) за каждый захват мьютекса
+     * @param out     итератор, куда помещаются результаты
+     * @param count   требуемое количество элементов
+     * @param timeout максимальное время накопления
+     * @return  количество полученных элементов (меньше count, если истекло
+     *          время или буфер завершает работу)
+     */
+    template<typename OutputIterator, typename Rep, typename Period>
+    size_t pop_collect_for(OutputIterator out, size_t count,
+                           const std::chrono::duration<Rep, Period>& timeout);
+
+    /**
+     * @brief   Накопить count элементов, ожидая не позже deadline
+     * @param out      итератор, куда помещаются результаты
+     * @param count    требуемое количество элементов
+     * @param deadline момент окончания накопления
+     * @return  количество полученных элементов (меньше count, если истекло
+     *          время или буфер завершает работу)
      */
-    void pop_wait(T& result);
+    template<typename OutputIterator, typename Clock, typename Duration>
+    size_t pop_collect_until(OutputIterator out, size_t count,
+                             const std::chrono::time_point<Clock, Duration>& deadline);
+
+#ifdef CIRCULAR_BUFFER_HAS_COROUTINES
+    /**
+     * @brief   co_await pop(): получить очередной элемент. Если буфер
+     *          пуст, сопрограмма приостанавливается (поток не блокируется)
+     *          и возобновляется в потоке писателя
+     * @return объект ожидания; co_await возвращает std::optional<T>
+     *         (пусто после shutdown())
+     */
+    detail::pop_awaiter<basic_circular_buffer, T> pop();
+
+    /**
+     * @brief   co_await push(value): добавить элемент. Если буфер
+     *          заполнен, сопрограмма приостанавливается и возобновляется
+     *          в потоке читателя
+     * @param value значение элемента (должно жить до завершения co_await)
+     * @return объект ожидания; co_await возвращает WaitStatus
+     */
+    template<typename Type>
+    detail::push_awaiter<basic_circular_buffer, Type> push(Type&& value);
+#endif
+
+    /**
+     * @brief   Завершить работу буфера: все ожидающие и последующие
+     *          блокирующие операции возвращают WaitStatus::shutdown.
+     *          Вызывается деструктором
+     */
+    void shutdown();
 
     /**
      * @brief Очистить буфер
@@ -112,6 +383,26 @@ private:
      */
     size_t next(size_t position, size_t n = 1) const noexcept;
 
+    /**
+     * @brief   Добавить элемент без пробуждения сопрограмм-читателей
+     *          (try_push_back и ожидающие сопрограммы)
+     * @return флаг успешности добавления
+     */
+    template<typename Type>
+    bool put(Type&& value);
+
+    /**
+     * @brief   Извлечь элемент без пробуждения сопрограмм-писателей
+     *          (try_pop и ожидающие сопрограммы)
+     * @return флаг успешности извлечения
+     */
+    bool take(T& result);
+
+    /**
+     * @brief Ожидающие сопрограммы
+     */
+    detail::coro_waiters& coro_waiters() noexcept;
+
     /**
      * @brief   Получить размер данных в буфере.
      *          Без блокировки мьютекса
@@ -132,6 +423,99 @@ private:
      * @return флаг пустоты
      */
     bool empty_unsafe() const noexcept;
+
+    /**
+     * @brief   Переложить содержимое в новое хранилище.
+     *          Без блокировки мьютекса
+     * @param data новое хранилище (размер + 1 резервный элемент),
+     *             вмещающее все текущие элементы
+     */
+    void relocate_unsafe(StoragePolicy& data);
+
+    /**
+     * @brief   Учесть текущую заполненность и при необходимости
+     *          запросить изменение размера согласно AutoResizePolicy.
+     *          Без блокировки мьютекса
+     */
+    void adapt_unsafe();
+
+    /**
+     * @brief   Выполнить запрошенное adapt_unsafe изменение размера:
+     *          выделить хранилище без мьютекса, затем перенести элементы.
+     *          Вызывается после освобождения мьютекса
+     */
+    void apply_auto_resize();
+
+    /**
+     * @brief   Запросить изменение размера для apply_auto_resize.
+     *          Без блокировки мьютекса
+     * @param newSize новый размер
+     */
+    void request_resize_unsafe(size_t newSize);
+
+    /**
+     * @brief   Применить AutoResizePolicy и опубликовать заполненность
+     *          для проверок без мьютекса. Вызывается после каждого
+     *          изменения буфера. Без блокировки мьютекса
+     */
+    void commit_unsafe();
+
+    /**
+     * @brief   Активно подождать появления данных перед захватом мьютекса
+     */
+    void spin_not_empty();
+
+    /**
+     * @brief   Активно подождать появления места перед захватом мьютекса
+     */
+    void spin_not_full();
+
+    /**
+     * @brief   Разбудить ожидающие потоки после добавления/извлечения
+     *          нескольких элементов. Вызывается без блокировки мьютекса
+     * @param cv        условная переменная ожидающей стороны
+     * @param waiters   количество ожидающих (прочитанное под мьютексом)
+     * @param count     количество добавленных/освобожденных ячеек
+     */
+    static void wake(std::condition_variable& cv, size_t waiters, size_t count);
+
+    /**
+     * @brief   Дождаться, пока в буфере появятся данные.
+     *          Вызывается с захваченным мьютексом
+     * @param locker захваченный мьютекс
+     * @return false, если буфер удаляется
+     */
+    bool wait_not_empty(std::unique_lock<std::mutex>& locker);
+
+    /**
+     * @brief   Дождаться, пока в буфере появится свободное место.
+     *          Вызывается с захваченным мьютексом
+     * @param locker захваченный мьютекс
+     * @return false, если буфер удаляется
+     */
+    bool wait_not_full(std::unique_lock<std::mutex>& locker);
+
+    /**
+     * @brief   Дождаться, пока в буфере появятся данные, не позже deadline.
+     *          Вызывается с захваченным мьютексом
+     * @param locker   захваченный мьютекс
+     * @param deadline момент окончания ожидания
+     * @return результат ожидания
+     */
+    template<typename Clock, typename Duration>
+    WaitStatus wait_not_empty_until(std::unique_lock<std::mutex>& locker,
+                                    const std::chrono::time_point<Clock, Duration>& deadline);
+
+    /**
+     * @brief   Дождаться, пока в буфере появится место, не позже deadline.
+     *          Вызывается с захваченным мьютексом
+     * @param locker   захваченный мьютекс
+     * @param deadline момент окончания ожидания
+     * @return результат ожидания
+     */
+    template<typename Clock, typename Duration>
+    WaitStatus wait_not_full_until(std::unique_lock<std::mutex>& locker,
+                                   const std::chrono::time_point<Clock, Duration>& deadline);
 };
 
 
@@ -140,111 +524,481 @@ private:
 
 
 
-template<typename T>
-CircularBuffer_mrmw_blocked<T>::CircularBuffer_mrmw_blocked(size_t size)
-    : m_data(size + 1) // +1 для определения "полон" / "пуст"
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+basic_circular_buffer(size_t size, const allocator_type& allocator)
+    : m_data(size + 1, allocator) // +1 для определения "полон" / "пуст"
     , m_mutex{}
-    , m_cv{}
+    , m_not_empty{}
+    , m_not_full{}
     , m_head{}
     , m_tail{}
+    , m_waiting_readers{}
+    , m_waiting_writers{}
+    , m_auto_resize{false}
+    , m_auto_resize_policy{}
+    , m_high_streak{}
+    , m_low_streak{}
+    , m_resize_requested{false}
+    , m_resize_from{}
+    , m_resize_to{}
+    , m_size{0}
+    , m_max_size{size}
+    , m_read_spin{}
+    , m_write_spin{}
     , m_delete{false}
+    , m_stats{size + 1}
+    , m_coro{}
 {}
 
-template<typename T>
-CircularBuffer_mrmw_blocked<T>::~CircularBuffer_mrmw_blocked()
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+~basic_circular_buffer()
 {
-    m_delete = true;
-    m_cv.notify_all();
+    shutdown();
 }
 
-template<typename T>
-size_t CircularBuffer_mrmw_blocked<T>::size() const noexcept
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+void basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+shutdown()
 {
-    std::lock_guard<std::mutex> locker(m_mutex);
+    {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        m_delete = true;
+    }
 
-    return size_unsafe();
+    m_not_empty.notify_all();
+    m_not_full.notify_all();
+
+    m_coro.shutdown();
 }
 
-template<typename T>
-void CircularBuffer_mrmw_blocked<T>::resize(size_t newSize) noexcept
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+size_t basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+size() const noexcept
 {
-    std::lock_guard<std::mutex> locker(m_mutex);
-    m_data.resize(newSize + 1); // + 1 так как резерв
+    return m_size.load(std::memory_order_relaxed);
 }
 
-template<typename T>
-size_t CircularBuffer_mrmw_blocked<T>::max_size() const noexcept
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+bool basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+resize(size_t newSize)
 {
+    static_assert(StoragePolicy::resizable,
+                  "resize() requires resizable StoragePolicy");
+
+    // память выделяется до захвата мьютекса
+    StoragePolicy data(newSize + 1, m_data.get_allocator()); // + 1 так как резерв
+
+    size_t waiters;
+    {
+        std::lock_guard<std::mutex> locker(m_mutex);
+
+        if(newSize < size_unsafe())
+            return false;
+
+        relocate_unsafe(data);
+
+        waiters = m_waiting_writers;
+    }
+
+    if(waiters != 0)
+        m_not_full.notify_all();
+
+    m_coro.notify_writable();
+    return true;
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+void basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+set_auto_resize(const AutoResizePolicy &policy)
+{
+    static_assert(StoragePolicy::resizable,
+                  "set_auto_resize() requires resizable StoragePolicy");
+
+    detail::validate(policy);
+
     std::lock_guard<std::mutex> locker(m_mutex);
-    return m_data.size() - 1;
+
+    m_auto_resize = true;
+    m_auto_resize_policy = policy;
+    m_high_streak = 0;
+    m_low_streak = 0;
 }
 
-template<typename T>
-bool CircularBuffer_mrmw_blocked<T>::empty() const noexcept
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+void basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+disable_auto_resize()
 {
     std::lock_guard<std::mutex> locker(m_mutex);
-    return m_head == m_tail;
+    m_auto_resize = false;
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+size_t basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+max_size() const noexcept
+{
+    return m_max_size.load(std::memory_order_relaxed);
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+const StoragePolicy&
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+storage() const noexcept
+{
+    return m_data;
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+buffer_stats
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+stats() const noexcept
+{
+    return m_stats.snapshot();
 }
 
-template<typename T>
-bool CircularBuffer_mrmw_blocked<T>::full() const noexcept
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+latency_snapshot
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+dwell_times(bool reset)
 {
+    static_assert(StatsPolicy::dwell, "dwell_times() requires dwell_stats StatsPolicy");
+
     std::lock_guard<std::mutex> locker(m_mutex);
-    return full_unsafe();
+    return m_stats.dwell(reset);
 }
 
-template<typename T>
-bool CircularBuffer_mrmw_blocked<T>::try_pop(T &result)
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+typename StoragePolicy::allocator_type
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+get_allocator() const
 {
+    // m_data заменяется при resize
     std::lock_guard<std::mutex> locker(m_mutex);
+    return m_data.get_allocator();
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+bool basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+empty() const noexcept
+{
+    return m_size.load(std::memory_order_relaxed) == 0;
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+bool basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+full() const noexcept
+{
+    return m_size.load(std::memory_order_relaxed)
+        >= m_max_size.load(std::memory_order_relaxed);
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+bool basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+take(T &result)
+{
+    bool notify;
+    {
+        std::lock_guard<std::mutex> locker(m_mutex);
+
+        if(empty_unsafe()) {
+            m_stats.pop_failed();
+            return false;
+        }
+
+        m_stats.dequeued(m_head);
+        result = std::move_if_noexcept(m_data[m_head]);
+        m_head = next(m_head);
+        m_stats.popped();
+
+        commit_unsafe();
+
+        notify = m_waiting_writers != 0;
+    }
+
+    // будим писателя уже без мьютекса, чтобы он не уснул на нем снова
+    if(notify)
+        m_not_full.notify_one();
 
-    if(empty_unsafe())
+    apply_auto_resize();
+    return true;
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+bool basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+try_pop(T &result)
+{
+    if(! take(result))
         return false;
 
+    m_coro.notify_writable();
+    return true;
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+WaitStatus basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+pop_wait(T &result)
+{
+    spin_not_empty();
+
+    std::unique_lock<std::mutex> locker(m_mutex);
+
+    if(! wait_not_empty(locker))
+        return WaitStatus::shutdown;
 
-    result = std::move_if_noexcept(m_data.at(m_head));
+    m_stats.dequeued(m_head);
+    result = std::move_if_noexcept(m_data[m_head]);
     m_head = next(m_head);
+    m_stats.popped();
 
-    m_cv.notify_one();
+    commit_unsafe();
 
-    return true;
+    bool notify = m_waiting_writers != 0;
+    locker.unlock();
+
+    if(notify)
+        m_not_full.notify_one();
+
+    m_coro.notify_writable();
+    apply_auto_resize();
+    return WaitStatus::success;
 }
 
-template<typename T>
-void CircularBuffer_mrmw_blocked<T>::pop_wait(T &result)
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+template<typename Rep, typename Period>
+WaitStatus basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+pop_wait_for(
+            T &result,
+            const std::chrono::duration<Rep, Period> &timeout
+        )
 {
+    return pop_wait_until(result, std::chrono::steady_clock::now() + timeout);
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+template<typename Clock, typename Duration>
+WaitStatus basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+pop_wait_until(
+            T &result,
+            const std::chrono::time_point<Clock, Duration> &deadline
+        )
+{
+    spin_not_empty();
+
     std::unique_lock<std::mutex> locker(m_mutex);
 
-    if(empty_unsafe()) {
-        m_cv.wait(locker, [&]() {
-            return !empty_unsafe() || m_delete;
-        });
+    WaitStatus status = wait_not_empty_until(locker, deadline);
+    if(status != WaitStatus::success)
+        return status;
+
+    m_stats.dequeued(m_head);
+    result = std::move_if_noexcept(m_data[m_head]);
+    m_head = next(m_head);
+    m_stats.popped();
+
+    commit_unsafe();
+
+    bool notify = m_waiting_writers != 0;
+    locker.unlock();
+
+    if(notify)
+        m_not_full.notify_one();
+
+    m_coro.notify_writable();
+    apply_auto_resize();
+    return WaitStatus::success;
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+template<typename OutputIterator>
+size_t basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+pop_wait_n(OutputIterator out, size_t max)
+{
+    if(max == 0)
+        return 0;
+
+    spin_not_empty();
+
+    size_t counter{0};
+    size_t waiters;
+    {
+        std::unique_lock<std::mutex> locker(m_mutex);
+
+        if(! wait_not_empty(locker))
+            return 0;
+
+        while(counter < max && !empty_unsafe()) {
+            m_stats.dequeued(m_head);
+            *out = std::move_if_noexcept(m_data[m_head]);
+            ++out;
+            m_head = next(m_head);
+            ++counter;
+        }
+
+        m_stats.popped(counter);
+        commit_unsafe();
+
+        waiters = m_waiting_writers;
     }
 
-    if(m_delete)
-        return;
+    wake(m_not_full, waiters, counter);
+    m_coro.notify_writable();
+    apply_auto_resize();
 
-    result = std::move_if_noexcept(m_data.at(m_head));
-    m_head = next(m_head);
+    return counter;
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+template<typename ContainerType>
+size_t basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+pop_wait_all(ContainerType &container)
+{
+    spin_not_empty();
+
+    size_t counter{0};
+    size_t waiters;
+    {
+        std::unique_lock<std::mutex> locker(m_mutex);
+
+        if(! wait_not_empty(locker))
+            return 0;
+
+        container.reserve(container.size() + size_unsafe());
+
+        while(!empty_unsafe()) {
+            m_stats.dequeued(m_head);
+            container.push_back(std::move_if_noexcept(m_data[m_head]));
+            m_head = next(m_head);
+            ++counter;
+        }
+
+        m_stats.popped(counter);
+        commit_unsafe();
+
+        waiters = m_waiting_writers;
+    }
+
+    wake(m_not_full, waiters, counter);
+    m_coro.notify_writable();
+    apply_auto_resize();
 
-    m_cv.notify_one();
+    return counter;
 }
 
-template<typename T>
-void CircularBuffer_mrmw_blocked<T>::clear()
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+template<typename OutputIterator, typename Rep, typename Period>
+size_t basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+pop_collect_for(
+            OutputIterator out,
+            size_t count,
+            const std::chrono::duration<Rep, Period> &timeout
+        )
 {
-    std::lock_guard<std::mutex> locker(m_mutex);
-    m_head = m_tail;
+    return pop_collect_until(out, count,
+                             std::chrono::steady_clock::now() + timeout);
 }
 
-template<typename T>
-size_t CircularBuffer_mrmw_blocked<T>::next(size_t position, size_t n) const noexcept
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+template<typename OutputIterator, typename Clock, typename Duration>
+size_t basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+pop_collect_until(
+            OutputIterator out,
+            size_t count,
+            const std::chrono::time_point<Clock, Duration> &deadline
+        )
+{
+    size_t counter{0};
+
+    while(counter < count) {
+        size_t popped{0};
+        size_t waiters;
+        {
+            std::unique_lock<std::mutex> locker(m_mutex);
+
+            if(wait_not_empty_until(locker, deadline) != WaitStatus::success)
+                break;
+
+            while(counter < count && !empty_unsafe()) {
+                m_stats.dequeued(m_head);
+                *out = std::move_if_noexcept(m_data[m_head]);
+                ++out;
+                m_head = next(m_head);
+                ++counter;
+                ++popped;
+            }
+
+            m_stats.popped(popped);
+            commit_unsafe();
+
+            waiters = m_waiting_writers;
+        }
+
+        wake(m_not_full, waiters, popped);
+        m_coro.notify_writable();
+        apply_auto_resize();
+    }
+
+    return counter;
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+void basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+clear()
+{
+    bool notify;
+    {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        m_head = m_tail;
+
+        commit_unsafe();
+
+        notify = m_waiting_writers != 0;
+    }
+
+    // освободилось все место - будим всех писателей
+    if(notify)
+        m_not_full.notify_all();
+
+    m_coro.notify_writable();
+    apply_auto_resize();
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+size_t basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+next(size_t position, size_t n) const noexcept
 {
     return (position + n) % m_data.size();
 }
 
-template<typename T>
-size_t CircularBuffer_mrmw_blocked<T>::size_unsafe() const noexcept
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+size_t basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+size_unsafe() const noexcept
 {
     if(m_tail < m_head)
         return m_data.size() + m_tail - m_head;
@@ -252,56 +1006,582 @@ size_t CircularBuffer_mrmw_blocked<T>::size_unsafe() const noexcept
     return m_tail - m_head;
 }
 
-template<typename T>
-bool CircularBuffer_mrmw_blocked<T>::full_unsafe() const noexcept
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+void basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+relocate_unsafe(StoragePolicy& data)
+{
+    size_t count = size_unsafe();
+
+    for(size_t i = 0; i < count; ++i)
+        data[i] = std::move_if_noexcept(m_data[next(m_head, i)]);
+
+    m_stats.relocate(data.size(), count,
+                     [this](size_t i) { return next(m_head, i); });
+
+    m_data.swap(data);
+    m_head = 0;
+    m_tail = count;
+
+    m_max_size.store(m_data.size() - 1, std::memory_order_relaxed);
+
+    m_high_streak = 0;
+    m_low_streak = 0;
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+void basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+adapt_unsafe()
+{
+    if(! m_auto_resize)
+        return;
+
+    const AutoResizePolicy& policy = m_auto_resize_policy;
+
+    size_t capacity = m_data.size() - 1;
+    size_t count    = size_unsafe();
+
+    if(count * 100 >= capacity * policy.high_watermark) {
+        m_low_streak = 0;
+        if(++m_high_streak < policy.window || capacity >= policy.max_size)
+            return;
+
+        request_resize_unsafe(std::min(std::max<size_t>(capacity * 2, 1),
+                                       policy.max_size));
+        return;
+    }
+
+    m_high_streak = 0;
+
+    if(count * 100 > capacity * policy.low_watermark) {
+        m_low_streak = 0;
+        return;
+    }
+
+    if(++m_low_streak < policy.window || capacity <= policy.min_size)
+        return;
+
+    size_t newSize = std::max(std::max(capacity / 2, policy.min_size), count);
+    if(newSize == capacity) {
+        m_low_streak = 0;
+        return;
+    }
+
+    request_resize_unsafe(newSize);
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+void basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+request_resize_unsafe(size_t newSize)
+{
+    // серия начинается заново: если размер не изменится (нет памяти,
+    // вмешался resize), запрос повторится через window операций
+    m_high_streak = 0;
+    m_low_streak = 0;
+
+    m_resize_from = m_data.size() - 1;
+    m_resize_to = newSize;
+    m_resize_requested.store(true, std::memory_order_relaxed);
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+void basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+apply_auto_resize()
+{
+    if(! m_resize_requested.load(std::memory_order_relaxed)
+       || ! m_resize_requested.exchange(false, std::memory_order_relaxed))
+        return;
+
+    size_t from;
+    size_t newSize;
+    {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        from = m_resize_from;
+        newSize = m_resize_to;
+    }
+
+    // память выделяется до захвата мьютекса; без памяти размер не меняется
+    std::unique_ptr<StoragePolicy> data;
+    try {
+        data.reset(new StoragePolicy(newSize + 1, get_allocator()));
+    } catch(const std::bad_alloc&) {
+        return;
+    }
+
+    size_t waiters;
+    {
+        std::lock_guard<std::mutex> locker(m_mutex);
+
+        // политика отключена, размер уже изменен или элементы не помещаются
+        if(! m_auto_resize || m_data.size() - 1 != from || newSize < size_unsafe())
+            return;
+
+        relocate_unsafe(*data);
+
+        waiters = newSize > from ? m_waiting_writers : 0;
+    }
+
+    // место освободилось, писатели могут продолжать
+    if(waiters != 0)
+        m_not_full.notify_all();
+
+    if(newSize > from)
+        m_coro.notify_writable();
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+void basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+commit_unsafe()
+{
+    m_stats.occupancy([this]() { return size_unsafe(); });
+
+    adapt_unsafe();
+    m_size.store(size_unsafe(), std::memory_order_relaxed);
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+void basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+spin_not_empty()
+{
+    if(! empty())
+        return;
+
+    m_read_spin.wait([this]() {
+        return !empty() || m_delete;
+    });
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+void basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+spin_not_full()
+{
+    if(! full())
+        return;
+
+    m_write_spin.wait([this]() {
+        return !full() || m_delete;
+    });
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+bool basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+full_unsafe() const noexcept
 {
     return m_head == next(m_tail);
 }
 
-template<typename T>
-bool CircularBuffer_mrmw_blocked<T>::empty_unsafe() const noexcept
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+bool basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+empty_unsafe() const noexcept
 {
     return m_head == m_tail;
 }
 
-template<typename T>
-template<typename Type>
-bool CircularBuffer_mrmw_blocked<T>::try_push_back(Type&& value)
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+void basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+wake(std::condition_variable &cv,
+                                          size_t waiters,
+                                          size_t count)
 {
-    std::lock_guard<std::mutex> locker(m_mutex);
+    if(waiters == 0 || count == 0)
+        return;
 
-    if(full_unsafe())
-        return false;
+    if(count >= waiters) {
+        cv.notify_all();
+        return;
+    }
 
+    for(size_t i = 0; i < count; ++i)
+        cv.notify_one();
+}
 
-    m_data.at(m_tail) = std::forward<Type>(value);
-    m_tail = next(m_tail);
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+bool basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+wait_not_empty(
+            std::unique_lock<std::mutex> &locker
+        )
+{
+    if(empty_unsafe()) {
+        ++m_waiting_readers;
+        m_stats.timed_wait([&]() {
+            m_not_empty.wait(locker, [&]() {
+                return !empty_unsafe() || m_delete;
+            });
+        });
+        --m_waiting_readers;
+    }
 
-    m_cv.notify_one();
+    return !m_delete;
+}
 
-    return true;
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+bool basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+wait_not_full(
+            std::unique_lock<std::mutex> &locker
+        )
+{
+    if(full_unsafe()) {
+        ++m_waiting_writers;
+        m_stats.timed_wait([&]() {
+            m_not_full.wait(locker, [&]() {
+                return !full_unsafe() || m_delete;
+            });
+        });
+        --m_waiting_writers;
+    }
+
+    return !m_delete;
 }
 
-template<typename T>
-template<typename Type>
-void CircularBuffer_mrmw_blocked<T>::push_back_wait(Type&& value)
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+template<typename Clock, typename Duration>
+WaitStatus basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+wait_not_empty_until(
+            std::unique_lock<std::mutex> &locker,
+            const std::chrono::time_point<Clock, Duration> &deadline
+        )
 {
-    std::unique_lock<std::mutex> locker(m_mutex);
+    bool ready = true;
+
+    if(empty_unsafe()) {
+        ++m_waiting_readers;
+        ready = m_stats.timed_wait([&]() {
+            return m_not_empty.wait_until(locker, deadline, [&]() {
+                return !empty_unsafe() || m_delete;
+            });
+        });
+        --m_waiting_readers;
+    }
+
+    if(m_delete)
+        return WaitStatus::shutdown;
+
+    return ready ? WaitStatus::success : WaitStatus::timeout;
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+template<typename Clock, typename Duration>
+WaitStatus basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+wait_not_full_until(
+            std::unique_lock<std::mutex> &locker,
+            const std::chrono::time_point<Clock, Duration> &deadline
+        )
+{
+    bool ready = true;
 
     if(full_unsafe()) {
-        m_cv.wait(locker, [&]() {
-            return !full_unsafe() || m_delete;
+        ++m_waiting_writers;
+        ready = m_stats.timed_wait([&]() {
+            return m_not_full.wait_until(locker, deadline, [&]() {
+                return !full_unsafe() || m_delete;
+            });
         });
+        --m_waiting_writers;
     }
 
     if(m_delete)
-        return;
+        return WaitStatus::shutdown;
+
+    return ready ? WaitStatus::success : WaitStatus::timeout;
+}
 
-    m_data.at(m_tail) = std::forward<Type>(value);
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+template<typename Type>
+bool basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+put(Type&& value)
+{
+    bool pushed;
+    bool notify{false};
+    {
+        std::lock_guard<std::mutex> locker(m_mutex);
+
+        pushed = ! full_unsafe();
+        if(pushed) {
+            m_stats.enqueued(m_tail);
+            m_data[m_tail] = std::forward<Type>(value);
+            m_tail = next(m_tail);
+            m_stats.pushed();
+
+            notify = m_waiting_readers != 0;
+        } else {
+            m_stats.push_failed();
+        }
+
+        commit_unsafe();
+    }
+
+    if(notify)
+        m_not_empty.notify_one();
+
+    // заполненный буфер может вырасти по AutoResizePolicy
+    apply_auto_resize();
+    return pushed;
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+template<typename Type>
+bool basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+try_push_back(Type&& value)
+{
+    if(! put(std::forward<Type>(value)))
+        return false;
+
+    m_coro.notify_readable();
+    return true;
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+template<typename Type>
+WaitStatus basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+push_back_wait(Type&& value)
+{
+    spin_not_full();
+
+    std::unique_lock<std::mutex> locker(m_mutex);
+
+    if(! wait_not_full(locker))
+        return WaitStatus::shutdown;
+
+    m_stats.enqueued(m_tail);
+    m_data[m_tail] = std::forward<Type>(value);
     m_tail = next(m_tail);
+    m_stats.pushed();
+
+    commit_unsafe();
+
+    bool notify = m_waiting_readers != 0;
+    locker.unlock();
+
+    if(notify)
+        m_not_empty.notify_one();
+
+    m_coro.notify_readable();
+    apply_auto_resize();
+    return WaitStatus::success;
+}
 
-    m_cv.notify_one();
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+template<typename Type, typename Rep, typename Period>
+WaitStatus basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+push_back_wait_for(
+            Type&& value,
+            const std::chrono::duration<Rep, Period> &timeout
+        )
+{
+    return push_back_wait_until(std::forward<Type>(value),
+                                std::chrono::steady_clock::now() + timeout);
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+template<typename Type, typename Clock, typename Duration>
+WaitStatus basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+push_back_wait_until(
+            Type&& value,
+            const std::chrono::time_point<Clock, Duration> &deadline
+        )
+{
+    spin_not_full();
+
+    std::unique_lock<std::mutex> locker(m_mutex);
+
+    WaitStatus status = wait_not_full_until(locker, deadline);
+    if(status != WaitStatus::success)
+        return status;
+
+    m_stats.enqueued(m_tail);
+    m_data[m_tail] = std::forward<Type>(value);
+    m_tail = next(m_tail);
+    m_stats.pushed();
+
+    commit_unsafe();
+
+    bool notify = m_waiting_readers != 0;
+    locker.unlock();
+
+    if(notify)
+        m_not_empty.notify_one();
+
+    m_coro.notify_readable();
+    apply_auto_resize();
+    return WaitStatus::success;
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+template<typename ForwardInputIterator>
+size_t basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+push_back_wait_n(
+            ForwardInputIterator begin,
+            ForwardInputIterator end
+        )
+{
+    size_t counter{0};
+
+    while(begin != end) {
+        spin_not_full();
+
+        size_t pushed{0};
+        size_t waiters;
+        {
+            std::unique_lock<std::mutex> locker(m_mutex);
+
+            if(! wait_not_full(locker))
+                return counter;
+
+            while(begin != end && !full_unsafe()) {
+                m_stats.enqueued(m_tail);
+                m_data[m_tail] = *begin;
+                m_tail = next(m_tail);
+
+                begin = std::next(begin);
+                ++pushed;
+            }
+
+            m_stats.pushed(pushed);
+            commit_unsafe();
+
+            waiters = m_waiting_readers;
+        }
+
+        wake(m_not_empty, waiters, pushed);
+        m_coro.notify_readable();
+        apply_auto_resize();
+        counter += pushed;
+    }
+
+    return counter;
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+template<typename InputIterator>
+size_t basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+try_push_back_n(InputIterator begin, size_t count)
+{
+    if(count == 0)
+        return 0;
+
+    size_t pushed{0};
+    size_t waiters;
+    {
+        std::lock_guard<std::mutex> locker(m_mutex);
+
+        while(pushed < count && !full_unsafe()) {
+            m_stats.enqueued(m_tail);
+            m_data[m_tail] = *begin;
+            m_tail = next(m_tail);
+
+            ++begin;
+            ++pushed;
+        }
+
+        if(pushed == 0)
+            m_stats.push_failed();
+        else
+            m_stats.pushed(pushed);
+
+        commit_unsafe();
+
+        waiters = m_waiting_readers;
+    }
+
+    if(pushed != 0) {
+        wake(m_not_empty, waiters, pushed);
+        m_coro.notify_readable();
+    }
+
+    apply_auto_resize();
+    return pushed;
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+template<typename OutputIterator>
+size_t basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+try_pop_n(OutputIterator out, size_t count)
+{
+    if(count == 0)
+        return 0;
+
+    size_t counter{0};
+    size_t waiters;
+    {
+        std::lock_guard<std::mutex> locker(m_mutex);
+
+        while(counter < count && !empty_unsafe()) {
+            m_stats.dequeued(m_head);
+            *out = std::move_if_noexcept(m_data[m_head]);
+            ++out;
+            m_head = next(m_head);
+            ++counter;
+        }
+
+        if(counter == 0)
+            m_stats.pop_failed();
+        else
+            m_stats.popped(counter);
+
+        commit_unsafe();
+
+        waiters = m_waiting_writers;
+    }
+
+    if(counter != 0) {
+        wake(m_not_full, waiters, counter);
+        m_coro.notify_writable();
+    }
+
+    apply_auto_resize();
+    return counter;
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+detail::coro_waiters&
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+coro_waiters() noexcept
+{
+    return m_coro;
+}
+
+#ifdef CIRCULAR_BUFFER_HAS_COROUTINES
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+detail::pop_awaiter<basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>, T>
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+pop()
+{
+    return detail::pop_awaiter<basic_circular_buffer, T>(*this);
+}
+
+template<typename T, typename ProducerPolicy, typename ConsumerPolicy,
+         typename StoragePolicy, typename StatsPolicy>
+template<typename Type>
+detail::push_awaiter<basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>, Type>
+basic_circular_buffer<T, ProducerPolicy, ConsumerPolicy, block_wait, StoragePolicy, StatsPolicy>::
+push(Type&& value)
+{
+    return detail::push_awaiter<basic_circular_buffer, Type>(*this, std::forward<Type>(value));
 }
+#endif
 
 }
 #endif // CIRCULAR_BUFFER_BLOCKED_MRMW_H
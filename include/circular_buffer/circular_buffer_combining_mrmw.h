@@ -0,0 +1,1340 @@
+#ifndef CIRCULAR_BUFFER_COMBINING_MRMW_H
+#define CIRCULAR_BUFFER_COMBINING_MRMW_H
+
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <type_traits>
+#include <thread>
+#include <chrono>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <algorithm>
+
+#include "circular_buffer_spin.h"
+#include "circular_buffer_fwd.h"
+#include "circular_buffer_auto_resize.h"
+#include "circular_buffer_storage.h"
+#include "circular_buffer_wait_status.h"
+
+namespace connest {
+
+/**
+  @brief    Циклический буфер multiple reader - multiple writter
+            на основе flat combining
+  @details
+        Поток не захватывает общий мьютекс, а публикует запрос
+        (запись / чтение) в записи на своем стеке и добавляет её
+        в lock-free список запросов:
+
+        m_requests --> [pop T3] --> [push T1] --> [push T2] --> nullptr
+
+        Поток, которому удалось установить флаг m_combining (комбайнер),
+        забирает весь список и выполняет все запросы за один проход,
+        пока кольцо "горячее" в его кеше. Остальные потоки ждут отметки
+        о выполнении своего запроса, не передавая мьютекс между ядрами.
+
+        Индексы m_head и m_tail изменяет только комбайнер. Для сна при
+        пустом / заполненном буфере используется отдельный мьютекс,
+        который захватывается только при наличии спящих потоков.
+
+        Пакетные операции (try_push_back_n, pop_wait_n и т.д.) публикуют
+        один запрос с итератором и количеством: комбайнер переносит
+        серию элементов за один проход. Итераторы и контейнеры вызываются
+        в потоке комбайнера и не должны бросать исключений.
+        resize и автоматическое изменение размера также выполняются
+        запросом: хранилище выделяется и освобождается вызывающим
+        потоком, комбайнер только переносит элементы.
+ */
+template <typename T, typename Allocator>
+class CircularBuffer_mrmw_combining final
+{
+    static_assert (     std::is_default_constructible<T>::value,
+                    "Type T must be default constructible: empty buffer should "
+                    "have initialized elements");
+
+    static_assert(      std::is_nothrow_move_assignable<T>::value
+                    || !std::is_move_assignable<T>::value,
+                    "Type T must not throw in move assign operator");
+
+    static_assert(      std::is_nothrow_copy_assignable<T>::value
+                    ||  !std::is_copy_assignable<T>::value,
+                    "Type T must not throw in copy assign operator");
+
+    /**
+     * @brief Запрос потока к комбайнеру (живет на стеке потока)
+     */
+    struct Request
+    {
+        enum class Kind { push, pop, push_n, pop_n, resize, auto_resize, configure, clear };
+
+        Kind kind;
+        // источник (push) / приемник (pop) / итератор (push_n, pop_n) /
+        // новое хранилище (resize) / политика (configure, nullptr - отключить)
+        void* value;
+        void (*assign)(T& slot, void* src);  // запись источника в ячейку
+        void (*extract)(T& slot, void* dst); // перенос ячейки в приемник (pop_n)
+        size_t count;   // push_n / pop_n: максимум, после выполнения -
+                        // выполнено; resize: новый размер
+        bool success;
+        Request* next;
+        std::atomic_bool done;
+    };
+
+    using storage_type = vector_storage<T, Allocator>;
+
+    storage_type m_data;
+    size_t m_head;  // изменяет только комбайнер
+    size_t m_tail;  // изменяет только комбайнер
+
+    // автоматическое изменение размера (изменяет только комбайнер)
+    bool m_auto_resize;
+    AutoResizePolicy m_auto_resize_policy;
+    size_t m_high_streak;
+    size_t m_low_streak;
+    size_t m_resize_from;
+
+    // размер, выбранный AutoResizePolicy (0 - нет запроса): хранилище
+    // выделяется после прохода комбайнера (apply_auto_resize)
+    std::atomic<size_t> m_resize_to;
+
+    // копия размера для проверок вне комбайнера
+    std::atomic<size_t> m_max_size;
+
+    // копия аллокатора: m_data заменяется комбайнером при resize
+    typename storage_type::allocator_type m_allocator;
+
+    alignas(64) std::atomic<Request*> m_requests;
+    alignas(64) std::atomic_bool m_combining;
+    alignas(64) std::atomic<size_t> m_size;
+
+    // сон при пустом / заполненном буфере
+    std::mutex m_sleep_mutex;
+    std::condition_variable m_not_empty;
+    std::condition_variable m_not_full;
+    std::atomic<size_t> m_waiting_readers;
+    std::atomic<size_t> m_waiting_writers;
+
+    // активное ожидание перед сном, отдельно для читателей и писателей
+    detail::AdaptiveSpin m_read_spin;
+    detail::AdaptiveSpin m_write_spin;
+
+    std::atomic_bool m_delete;
+
+public:
+    using value_type     = T;
+    using allocator_type = typename storage_type::allocator_type;
+
+    /**
+     * @param size      максимальное количество элементов
+     * @param allocator аллокатор хранилища ячеек
+     */
+    CircularBuffer_mrmw_combining(size_t size,
+                                  const allocator_type& allocator = allocator_type());
+
+    CircularBuffer_mrmw_combining(const CircularBuffer_mrmw_combining& other) = delete;
+    CircularBuffer_mrmw_combining(CircularBuffer_mrmw_combining&& other) = delete;
+    CircularBuffer_mrmw_combining& operator=(const CircularBuffer_mrmw_combining&) = delete;
+    CircularBuffer_mrmw_combining& operator=(CircularBuffer_mrmw_combining&&) = delete;
+
+    ~CircularBuffer_mrmw_combining();
+
+    /**
+     * @brief   Получить размер данных в буфере.
+     *          Без блокировок (значение может сразу устареть)
+     * @return количество элементов в буфере
+     */
+    size_t size() const noexcept;
+
+    /**
+     * @brief Получить размер буфера
+     * @return максимальное количество элементов в буфере
+     */
+    size_t max_size() const noexcept;
+
+    /**
+     * @brief Получить аллокатор хранилища
+     * @return копия аллокатора
+     */
+    allocator_type get_allocator() const;
+
+    /**
+     * @brief   Изменить размер буфера с сохранением содержимого.
+     *          Хранилище выделяется вызывающим потоком, перенос элементов
+     *          выполняет комбайнер; ожидающие писатели пробуждаются
+     * @param newSize Новый размер
+     * @return false, если newSize меньше количества элементов в буфере
+     *         (буфер не изменяется)
+     */
+    bool resize(size_t newSize);
+
+    /**
+     * @brief   Включить автоматическое изменение размера
+     * @param policy параметры изменения размера
+     * @throw std::invalid_argument, если min_size > max_size,
+     *        low_watermark >= high_watermark или window == 0
+     */
+    void set_auto_resize(const AutoResizePolicy& policy);
+
+    /**
+     * @brief Отключить автоматическое изменение размера
+     */
+    void disable_auto_resize();
+
+    /**
+     * @brief   Проверить буфер на пустоту.
+     *          Без блокировок (значение может сразу устареть)
+     * @return флаг пустоты
+     */
+    bool empty() const noexcept;
+
+    /**
+     * @brief   Проверить буфер на заполненность.
+     *          Без блокировок (значение может сразу устареть)
+     * @return флаг полноты
+     */
+    bool full() const noexcept;
+
+    /**
+     * @brief Попытаться добавить элемент в буфер
+     * @param value значение элемента
+     * @return флаг успешности операции
+     */
+    template<typename Type>
+    bool try_push_back(Type&& value);
+
+    /**
+     * @brief   Добавить элемент в буфер.
+     *          Если буфер заполнен, приостановить выполнения потока
+     * @param value значение элемента
+     * @return WaitStatus::success или WaitStatus::shutdown
+     */
+    template<typename Type>
+    WaitStatus push_back_wait(Type&& value);
+
+    /**
+     * @brief   Добавить элемент в буфер, ожидая свободного места
+     *          не дольше timeout
+     * @param value   значение элемента
+     * @param timeout максимальное время ожидания
+     * @return результат операции
+     */
+    template<typename Type, typename Rep, typename Period>
+    WaitStatus push_back_wait_for(Type&& value,
+                                  const std::chrono::duration<Rep, Period>& timeout);
+
+    /**
+     * @brief   Добавить элемент в буфер, ожидая свободного места
+     *          не позже deadline
+     * @param value    значение элемента
+     * @param deadline момент окончания ожидания
+     * @return результат операции
+     */
+    template<typename Type, typename Clock, typename Duration>
+    WaitStatus push_back_wait_until(Type&& value,
+                                    const std::chrono::time_point<Clock, Duration>& deadline);
+
+    /**
+     * @brief Попытаться получить очередной элемент.
+     * @param result Ссылка на место помещения результата
+     * @return успешность операции
+     */
+    bool try_pop(T& result);
+
+    /**
+     * @brief   Получить очередной элемент.
+     *          Если буфер пуст, приостановить выполнения потока
+     * @param result Ссылка на место помещения результата
+     * @return  WaitStatus::success или WaitStatus::shutdown
+     *          (result не изменяется)
+     */
+    WaitStatus pop_wait(T& result);
+
+    /**
+     * @brief   Получить очередной элемент, ожидая данных не дольше timeout
+     * @param result  Ссылка на место помещения результата
+     * @param timeout максимальное время ожидания
+     * @return результат операции (при неудаче result не изменяется)
+     */
+    template<typename Rep, typename Period>
+    WaitStatus pop_wait_for(T& result,
+                            const std::chrono::duration<Rep, Period>& timeout);
+
+    /**
+     * @brief   Получить очередной элемент, ожидая данных не позже deadline
+     * @param result   Ссылка на место помещения результата
+     * @param deadline момент окончания ожидания
+     * @return результат операции (при неудаче result не изменяется)
+     */
+    template<typename Clock, typename Duration>
+    WaitStatus pop_wait_until(T& result,
+                              const std::chrono::time_point<Clock, Duration>& deadline);
+
+    /**
+     * @brief   Добавить элементы из диапазона. Каждая серия - один запрос
+     *          к комбайнеру; поток приостанавливается, только если
+     *          буфер заполнен
+     * @param begin итератор начала диапазона контейнера
+     * @param end   итератор конца диапазона контейнера
+     * @return количество записанных элементов (меньше размера диапазона
+     *         только при завершении работы буфера)
+     */
+    template<typename ForwardInputIterator>
+    size_t push_back_wait_n(ForwardInputIterator begin, ForwardInputIterator end);
+
+    /**
+     * @brief   Получить до max элементов одним запросом к комбайнеру.
+     *          Если буфер пуст, приостановить выполнения потока
+     * @param out итератор, куда помещаются результаты
+     * @param max максимальное количество получаемых элементов
+     * @return количество полученных элементов
+     */
+    template<typename OutputIterator>
+    size_t pop_wait_n(OutputIterator out, size_t max);
+
+    /**
+     * @brief   Получить в контейнер все элементы, доступные на момент
+     *          запроса (место резервируется до запроса).
+     *          Если буфер пуст, приостановить выполнения потока
+     * @param container контейнер назначения
+     * @return количество полученных элементов
+     */
+    template<typename ContainerType>
+    size_t pop_wait_all(ContainerType& container);
+
+    /**
+     * @brief   Добавить до count элементов одним запросом к комбайнеру
+     *          без ожидания (сколько помещается)
+     * @param begin итератор первого элемента (std::move_iterator - перемещение)
+     * @param count количество элементов
+     * @return количество записанных элементов
+     */
+    template<typename InputIterator>
+    size_t try_push_back_n(InputIterator begin, size_t count);
+
+    /**
+     * @brief   Получить до count элементов одним запросом к комбайнеру
+     *          без ожидания
+     * @param out   итератор, куда помещаются результаты
+     * @param count максимальное количество элементов
+     * @return количество полученных элементов
+     */
+    template<typename OutputIterator>
+    size_t try_pop_n(OutputIterator out, size_t count);
+
+    /**
+     * @brief   Накопить count элементов, ожидая не дольше timeout.
+     *          Поток спит, пока данных нет, и забирает все доступные
+     *          элементы (но не больше count) одним запросом
+     * @param out     итератор, куда помещаются результаты
+     * @param count   требуемое количество элементов
+     * @param timeout максимальное время накопления
+     * @return  количество полученных элементов (меньше count, если истекло
+     *          время или буфер завершает работу)
+     */
+    template<typename OutputIterator, typename Rep, typename Period>
+    size_t pop_collect_for(OutputIterator out, size_t count,
+                           const std::chrono::duration<Rep, Period>& timeout);
+
+    /**
+     * @brief   Накопить count элементов, ожидая не позже deadline
+     * @param out      итератор, куда помещаются результаты
+     * @param count    требуемое количество элементов
+     * @param deadline момент окончания накопления
+     * @return  количество полученных элементов (меньше count, если истекло
+     *          время или буфер завершает работу)
+     */
+    template<typename OutputIterator, typename Clock, typename Duration>
+    size_t pop_collect_until(OutputIterator out, size_t count,
+                             const std::chrono::time_point<Clock, Duration>& deadline);
+
+    /**
+     * @brief Очистить буфер
+     */
+    void clear();
+
+    /**
+     * @brief   Завершить работу буфера: все ожидающие и последующие
+     *          блокирующие операции возвращают WaitStatus::shutdown.
+     *          Вызывается деструктором
+     */
+    void shutdown();
+
+private:
+    /**
+     * @brief Получить очередную позицию в кольцевом буфере
+     * @param position  Текущая позиция
+     * @param n         Количество пропускаемых элементов
+     * @return новая позиция
+     */
+    size_t next(size_t position, size_t n = 1) const noexcept;
+
+    /**
+     * @brief   Опубликовать запрос и дождаться его выполнения
+     *          (самостоятельно или другим комбайнером)
+     * @param request запрос на стеке вызывающего потока
+     * @return флаг успешности запроса
+     */
+    bool execute(Request& request);
+
+    /**
+     * @brief   Выполнить один запрос. Вызывается комбайнером
+     * @param request запрос
+     * @param pushed  счетчик добавленных элементов
+     * @param popped  счетчик освободившихся ячеек
+     */
+    void process(Request& request, size_t& pushed, size_t& popped);
+
+    /**
+     * @brief   Выполнить запрос resize / auto_resize, если элементы
+     *          помещаются. Вызывается комбайнером
+     * @param request запрос с новым хранилищем
+     * @param popped  счетчик освободившихся ячеек
+     */
+    void relocate(Request& request, size_t& popped);
+
+    /**
+     * @brief   Количество элементов в кольце. Вызывается комбайнером
+     * @return количество элементов
+     */
+    size_t size_unsafe() const noexcept;
+
+    /**
+     * @brief   Переложить содержимое в новое хранилище.
+     *          Вызывается комбайнером
+     * @param data новое хранилище (размер + 1 резервный элемент),
+     *             вмещающее все текущие элементы; получает старое
+     */
+    void relocate_unsafe(storage_type& data);
+
+    /**
+     * @brief   Учесть текущую заполненность и при необходимости
+     *          запросить изменение размера согласно AutoResizePolicy.
+     *          Вызывается комбайнером
+     */
+    void adapt_unsafe();
+
+    /**
+     * @brief   Выполнить запрошенное adapt_unsafe изменение размера:
+     *          выделить хранилище вне прохода комбайнера и передать
+     *          его запросом auto_resize
+     */
+    void apply_auto_resize();
+
+    /**
+     * @brief   Добавить до count элементов одним запросом
+     * @param begin итератор первого элемента (сдвигается на записанные)
+     * @param count количество элементов
+     * @return количество записанных элементов
+     */
+    template<typename InputIterator>
+    size_t push_n(InputIterator& begin, size_t count);
+
+    /**
+     * @brief   Получить до count элементов одним запросом
+     * @param out   итератор результатов (сдвигается на полученные)
+     * @param count максимальное количество элементов
+     * @return количество полученных элементов
+     */
+    template<typename OutputIterator>
+    size_t pop_n(OutputIterator& out, size_t count);
+
+    /**
+     * @brief   Выполнить все опубликованные запросы.
+     *          Вызывается потоком, установившим m_combining
+     */
+    void combine();
+
+    /**
+     * @brief   Разбудить спящих потоков после прохода комбайнера
+     * @param pushed количество добавленных элементов
+     * @param popped количество освободившихся ячеек
+     */
+    void wake(size_t pushed, size_t popped);
+
+    /**
+     * @brief   Записать значение в ячейку (для Request::assign)
+     * @param slot ячейка буфера
+     * @param src  указатель на значение типа Type
+     */
+    template<typename Type>
+    static void assign(T& slot, void* src);
+
+    /**
+     * @brief   Записать очередной элемент итератора в ячейку и сдвинуть
+     *          итератор (для Request::assign в push_n)
+     * @param slot ячейка буфера
+     * @param src  указатель на итератор типа InputIterator
+     */
+    template<typename InputIterator>
+    static void assign_next(T& slot, void* src);
+
+    /**
+     * @brief   Перенести ячейку в итератор и сдвинуть его
+     *          (для Request::extract)
+     * @param slot ячейка буфера
+     * @param dst  указатель на итератор типа OutputIterator
+     */
+    template<typename OutputIterator>
+    static void extract_next(T& slot, void* dst);
+
+    /**
+     * @brief   Дождаться данных (активно, затем сном)
+     * @param deadline момент окончания ожидания (nullptr - без ограничения)
+     * @return результат ожидания
+     */
+    template<typename Clock, typename Duration>
+    WaitStatus wait_not_empty(const std::chrono::time_point<Clock, Duration>* deadline);
+
+    /**
+     * @brief   Дождаться свободного места (активно, затем сном)
+     * @param deadline момент окончания ожидания (nullptr - без ограничения)
+     * @return результат ожидания
+     */
+    template<typename Clock, typename Duration>
+    WaitStatus wait_not_full(const std::chrono::time_point<Clock, Duration>* deadline);
+
+    /**
+     * @brief   Добавить элемент, ожидая свободного места
+     * @param value    значение элемента
+     * @param deadline момент окончания ожидания (nullptr - без ограничения)
+     * @return результат операции
+     */
+    template<typename Type, typename Clock, typename Duration>
+    WaitStatus push_wait_impl(Type&& value,
+                              const std::chrono::time_point<Clock, Duration>* deadline);
+
+    /**
+     * @brief   Получить элемент, ожидая данных
+     * @param result   Ссылка на место помещения результата
+     * @param deadline момент окончания ожидания (nullptr - без ограничения)
+     * @return результат операции
+     */
+    template<typename Clock, typename Duration>
+    WaitStatus pop_wait_impl(T& result,
+                             const std::chrono::time_point<Clock, Duration>* deadline);
+
+    /**
+     * @brief   Уснуть, пока не выполнится условие
+     * @param cv       условная переменная
+     * @param waiters  счетчик ожидающих этой стороны
+     * @param ready    условие пробуждения
+     * @param deadline момент окончания ожидания (nullptr - без ограничения)
+     * @return результат ожидания
+     */
+    template<typename Predicate, typename Clock, typename Duration>
+    WaitStatus sleep(std::condition_variable& cv,
+                     std::atomic<size_t>& waiters,
+                     Predicate ready,
+                     const std::chrono::time_point<Clock, Duration>* deadline);
+};
+
+
+
+// Implementation
+
+
+
+template<typename T, typename Allocator>
+CircularBuffer_mrmw_combining<T, Allocator>::CircularBuffer_mrmw_combining(
+            size_t size,
+            const allocator_type& allocator
+        )
+    : m_data(size + 1, allocator) // +1 для определения "полон" / "пуст"
+    , m_head{0}
+    , m_tail{0}
+    , m_auto_resize{false}
+    , m_auto_resize_policy{}
+    , m_high_streak{0}
+    , m_low_streak{0}
+    , m_resize_from{0}
+    , m_resize_to{0}
+    , m_max_size{size}
+    , m_allocator(allocator)
+    , m_requests{nullptr}
+    , m_combining{false}
+    , m_size{0}
+    , m_sleep_mutex{}
+    , m_not_empty{}
+    , m_not_full{}
+    , m_waiting_readers{0}
+    , m_waiting_writers{0}
+    , m_read_spin{}
+    , m_write_spin{}
+    , m_delete{false}
+{}
+
+template<typename T, typename Allocator>
+CircularBuffer_mrmw_combining<T, Allocator>::~CircularBuffer_mrmw_combining()
+{
+    shutdown();
+}
+
+template<typename T, typename Allocator>
+void CircularBuffer_mrmw_combining<T, Allocator>::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> locker(m_sleep_mutex);
+        m_delete = true;
+    }
+
+    m_not_empty.notify_all();
+    m_not_full.notify_all();
+}
+
+template<typename T, typename Allocator>
+size_t CircularBuffer_mrmw_combining<T, Allocator>::size() const noexcept
+{
+    return m_size.load(std::memory_order_relaxed);
+}
+
+template<typename T, typename Allocator>
+size_t CircularBuffer_mrmw_combining<T, Allocator>::max_size() const noexcept
+{
+    return m_max_size.load(std::memory_order_relaxed);
+}
+
+template<typename T, typename Allocator>
+typename CircularBuffer_mrmw_combining<T, Allocator>::allocator_type
+CircularBuffer_mrmw_combining<T, Allocator>::get_allocator() const
+{
+    return m_allocator;
+}
+
+template<typename T, typename Allocator>
+bool CircularBuffer_mrmw_combining<T, Allocator>::resize(size_t newSize)
+{
+    // память выделяется до публикации запроса; после выполнения
+    // data содержит старое хранилище и освобождается здесь же
+    storage_type data(newSize + 1, m_allocator); // + 1 так как резерв
+
+    Request request;
+    request.kind   = Request::Kind::resize;
+    request.value  = &data;
+    request.count  = newSize;
+
+    return execute(request);
+}
+
+template<typename T, typename Allocator>
+void CircularBuffer_mrmw_combining<T, Allocator>::set_auto_resize(const AutoResizePolicy &policy)
+{
+    detail::validate(policy);
+
+    AutoResizePolicy copy = policy;
+
+    Request request;
+    request.kind   = Request::Kind::configure;
+    request.value  = &copy;
+
+    execute(request);
+}
+
+template<typename T, typename Allocator>
+void CircularBuffer_mrmw_combining<T, Allocator>::disable_auto_resize()
+{
+    Request request;
+    request.kind   = Request::Kind::configure;
+    request.value  = nullptr;
+
+    execute(request);
+}
+
+template<typename T, typename Allocator>
+bool CircularBuffer_mrmw_combining<T, Allocator>::empty() const noexcept
+{
+    return m_size.load(std::memory_order_relaxed) == 0;
+}
+
+template<typename T, typename Allocator>
+bool CircularBuffer_mrmw_combining<T, Allocator>::full() const noexcept
+{
+    return m_size.load(std::memory_order_relaxed) >= max_size();
+}
+
+template<typename T, typename Allocator>
+template<typename InputIterator>
+size_t CircularBuffer_mrmw_combining<T, Allocator>::push_n(InputIterator &begin, size_t count)
+{
+    if(count == 0)
+        return 0;
+
+    Request request;
+    request.kind   = Request::Kind::push_n;
+    request.value  = &begin;
+    request.assign = &CircularBuffer_mrmw_combining<T, Allocator>::template assign_next<InputIterator>;
+    request.count  = count;
+
+    execute(request);
+    return request.count;
+}
+
+template<typename T, typename Allocator>
+template<typename OutputIterator>
+size_t CircularBuffer_mrmw_combining<T, Allocator>::pop_n(OutputIterator &out, size_t count)
+{
+    if(count == 0)
+        return 0;
+
+    Request request;
+    request.kind    = Request::Kind::pop_n;
+    request.value   = &out;
+    request.extract = &CircularBuffer_mrmw_combining<T, Allocator>::template extract_next<OutputIterator>;
+    request.count   = count;
+
+    execute(request);
+    return request.count;
+}
+
+template<typename T, typename Allocator>
+template<typename InputIterator>
+size_t CircularBuffer_mrmw_combining<T, Allocator>::try_push_back_n(InputIterator begin, size_t count)
+{
+    return push_n(begin, count);
+}
+
+template<typename T, typename Allocator>
+template<typename OutputIterator>
+size_t CircularBuffer_mrmw_combining<T, Allocator>::try_pop_n(OutputIterator out, size_t count)
+{
+    return pop_n(out, count);
+}
+
+template<typename T, typename Allocator>
+template<typename ForwardInputIterator>
+size_t CircularBuffer_mrmw_combining<T, Allocator>::push_back_wait_n(
+            ForwardInputIterator begin,
+            ForwardInputIterator end
+        )
+{
+    const auto* forever = static_cast<const std::chrono::steady_clock::time_point*>(nullptr);
+
+    size_t count = static_cast<size_t>(std::distance(begin, end));
+    size_t counter{0};
+
+    while(counter < count) {
+        if(wait_not_full(forever) != WaitStatus::success)
+            break;
+
+        counter += push_n(begin, count - counter);
+    }
+
+    return counter;
+}
+
+template<typename T, typename Allocator>
+template<typename OutputIterator>
+size_t CircularBuffer_mrmw_combining<T, Allocator>::pop_wait_n(OutputIterator out, size_t max)
+{
+    if(max == 0)
+        return 0;
+
+    const auto* forever = static_cast<const std::chrono::steady_clock::time_point*>(nullptr);
+
+    while(wait_not_empty(forever) == WaitStatus::success) {
+        size_t counter = pop_n(out, max);
+        if(counter != 0)
+            return counter;
+    }
+
+    return 0;
+}
+
+template<typename T, typename Allocator>
+template<typename ContainerType>
+size_t CircularBuffer_mrmw_combining<T, Allocator>::pop_wait_all(ContainerType &container)
+{
+    const auto* forever = static_cast<const std::chrono::steady_clock::time_point*>(nullptr);
+
+    while(wait_not_empty(forever) == WaitStatus::success) {
+        // резерв до запроса: комбайнер не выделяет память контейнера
+        size_t available = size();
+        container.reserve(container.size() + available);
+
+        auto out = std::back_inserter(container);
+        size_t counter = pop_n(out, available);
+        if(counter != 0)
+            return counter;
+    }
+
+    return 0;
+}
+
+template<typename T, typename Allocator>
+template<typename OutputIterator, typename Rep, typename Period>
+size_t CircularBuffer_mrmw_combining<T, Allocator>::pop_collect_for(
+            OutputIterator out,
+            size_t count,
+            const std::chrono::duration<Rep, Period> &timeout
+        )
+{
+    return pop_collect_until(out, count,
+                             std::chrono::steady_clock::now() + timeout);
+}
+
+template<typename T, typename Allocator>
+template<typename OutputIterator, typename Clock, typename Duration>
+size_t CircularBuffer_mrmw_combining<T, Allocator>::pop_collect_until(
+            OutputIterator out,
+            size_t count,
+            const std::chrono::time_point<Clock, Duration> &deadline
+        )
+{
+    size_t counter{0};
+
+    while(counter < count) {
+        if(wait_not_empty(&deadline) != WaitStatus::success)
+            break;
+
+        counter += pop_n(out, count - counter);
+    }
+
+    return counter;
+}
+
+template<typename T, typename Allocator>
+template<typename Type>
+bool CircularBuffer_mrmw_combining<T, Allocator>::try_push_back(Type&& value)
+{
+    // value живет на стеке вызывающего потока до выполнения запроса
+    Request request;
+    request.kind   = Request::Kind::push;
+    request.value  = const_cast<void*>(static_cast<const void*>(&value));
+    request.assign = &CircularBuffer_mrmw_combining<T, Allocator>::template assign<Type>;
+
+    return execute(request);
+}
+
+template<typename T, typename Allocator>
+template<typename Type>
+WaitStatus CircularBuffer_mrmw_combining<T, Allocator>::push_back_wait(Type&& value)
+{
+    return push_wait_impl(
+                std::forward<Type>(value),
+                static_cast<const std::chrono::steady_clock::time_point*>(nullptr));
+}
+
+template<typename T, typename Allocator>
+template<typename Type, typename Rep, typename Period>
+WaitStatus CircularBuffer_mrmw_combining<T, Allocator>::push_back_wait_for(
+            Type&& value,
+            const std::chrono::duration<Rep, Period> &timeout
+        )
+{
+    return push_back_wait_until(std::forward<Type>(value),
+                                std::chrono::steady_clock::now() + timeout);
+}
+
+template<typename T, typename Allocator>
+template<typename Type, typename Clock, typename Duration>
+WaitStatus CircularBuffer_mrmw_combining<T, Allocator>::push_back_wait_until(
+            Type&& value,
+            const std::chrono::time_point<Clock, Duration> &deadline
+        )
+{
+    return push_wait_impl(std::forward<Type>(value), &deadline);
+}
+
+template<typename T, typename Allocator>
+bool CircularBuffer_mrmw_combining<T, Allocator>::try_pop(T &result)
+{
+    Request request;
+    request.kind   = Request::Kind::pop;
+    request.value  = &result;
+    request.assign = nullptr;
+
+    return execute(request);
+}
+
+template<typename T, typename Allocator>
+WaitStatus CircularBuffer_mrmw_combining<T, Allocator>::pop_wait(T &result)
+{
+    return pop_wait_impl(
+                result,
+                static_cast<const std::chrono::steady_clock::time_point*>(nullptr));
+}
+
+template<typename T, typename Allocator>
+template<typename Rep, typename Period>
+WaitStatus CircularBuffer_mrmw_combining<T, Allocator>::pop_wait_for(
+            T &result,
+            const std::chrono::duration<Rep, Period> &timeout
+        )
+{
+    return pop_wait_until(result, std::chrono::steady_clock::now() + timeout);
+}
+
+template<typename T, typename Allocator>
+template<typename Clock, typename Duration>
+WaitStatus CircularBuffer_mrmw_combining<T, Allocator>::pop_wait_until(
+            T &result,
+            const std::chrono::time_point<Clock, Duration> &deadline
+        )
+{
+    return pop_wait_impl(result, &deadline);
+}
+
+template<typename T, typename Allocator>
+void CircularBuffer_mrmw_combining<T, Allocator>::clear()
+{
+    Request request;
+    request.kind   = Request::Kind::clear;
+    request.value  = nullptr;
+    request.assign = nullptr;
+
+    execute(request);
+}
+
+template<typename T, typename Allocator>
+size_t CircularBuffer_mrmw_combining<T, Allocator>::size_unsafe() const noexcept
+{
+    return m_tail >= m_head ? m_tail - m_head
+                            : m_data.size() + m_tail - m_head;
+}
+
+template<typename T, typename Allocator>
+void CircularBuffer_mrmw_combining<T, Allocator>::relocate_unsafe(storage_type &data)
+{
+    size_t count = size_unsafe();
+
+    for(size_t i = 0; i < count; ++i)
+        data[i] = std::move_if_noexcept(m_data[next(m_head, i)]);
+
+    m_data.swap(data);
+    m_head = 0;
+    m_tail = count;
+
+    m_max_size.store(m_data.size() - 1, std::memory_order_relaxed);
+
+    m_high_streak = 0;
+    m_low_streak = 0;
+}
+
+template<typename T, typename Allocator>
+void CircularBuffer_mrmw_combining<T, Allocator>::adapt_unsafe()
+{
+    if(! m_auto_resize)
+        return;
+
+    const AutoResizePolicy& policy = m_auto_resize_policy;
+
+    size_t capacity = m_data.size() - 1;
+    size_t count    = size_unsafe();
+    size_t newSize;
+
+    if(count * 100 >= capacity * policy.high_watermark) {
+        m_low_streak = 0;
+        if(++m_high_streak < policy.window || capacity >= policy.max_size)
+            return;
+
+        newSize = std::min(std::max<size_t>(capacity * 2, 1), policy.max_size);
+    } else {
+        m_high_streak = 0;
+
+        if(count * 100 > capacity * policy.low_watermark) {
+            m_low_streak = 0;
+            return;
+        }
+
+        if(++m_low_streak < policy.window || capacity <= policy.min_size)
+            return;
+
+        newSize = std::max(std::max(capacity / 2, policy.min_size), count);
+        if(newSize == capacity) {
+            m_low_streak = 0;
+            return;
+        }
+    }
+
+    // серия начинается заново: если размер не изменится (нет памяти,
+    // вмешался resize), запрос повторится через window операций
+    m_high_streak = 0;
+    m_low_streak = 0;
+
+    m_resize_from = capacity;
+    m_resize_to.store(newSize, std::memory_order_relaxed);
+}
+
+template<typename T, typename Allocator>
+void CircularBuffer_mrmw_combining<T, Allocator>::apply_auto_resize()
+{
+    if(m_resize_to.load(std::memory_order_relaxed) == 0)
+        return;
+
+    size_t newSize = m_resize_to.exchange(0, std::memory_order_relaxed);
+    if(newSize == 0)
+        return;
+
+    // без памяти размер не меняется
+    std::unique_ptr<storage_type> data;
+    try {
+        data.reset(new storage_type(newSize + 1, m_allocator));
+    } catch(const std::bad_alloc&) {
+        return;
+    }
+
+    Request request;
+    request.kind   = Request::Kind::auto_resize;
+    request.value  = data.get();
+    request.count  = newSize;
+
+    execute(request);
+}
+
+template<typename T, typename Allocator>
+size_t CircularBuffer_mrmw_combining<T, Allocator>::next(size_t position, size_t n) const noexcept
+{
+    return (position + n) % m_data.size();
+}
+
+template<typename T, typename Allocator>
+bool CircularBuffer_mrmw_combining<T, Allocator>::execute(Request &request)
+{
+    request.success = false;
+    request.done.store(false, std::memory_order_relaxed);
+
+    // публикация запроса (Treiber stack)
+    Request* head = m_requests.load(std::memory_order_relaxed);
+    do {
+        request.next = head;
+    } while(! m_requests.compare_exchange_weak(head,
+                                               &request,
+                                               std::memory_order_release,
+                                               std::memory_order_relaxed));
+
+    for(uint32_t spins = 0; ! request.done.load(std::memory_order_acquire); ++spins) {
+        if(! m_combining.load(std::memory_order_relaxed)
+           && ! m_combining.exchange(true, std::memory_order_acquire)) {
+            combine();
+            continue;
+        }
+
+        // комбайнер занят: ждем отметки, изредка уступая процессор
+        if(spins < 64)
+            detail::cpu_relax();
+        else
+            std::this_thread::yield();
+    }
+
+    if(request.kind != Request::Kind::auto_resize)
+        apply_auto_resize();
+
+    return request.success;
+}
+
+template<typename T, typename Allocator>
+void CircularBuffer_mrmw_combining<T, Allocator>::combine()
+{
+    size_t pushed{0};
+    size_t popped{0};
+
+    // несколько проходов: запросы, опубликованные во время прохода,
+    // обслуживаются без повторной передачи флага
+    for(int pass = 0; pass < 4; ++pass) {
+        Request* list = m_requests.exchange(nullptr, std::memory_order_acquire);
+        if(list == nullptr)
+            break;
+
+        // стек -> порядок поступления
+        Request* ordered = nullptr;
+        while(list != nullptr) {
+            Request* next_request = list->next;
+            list->next = ordered;
+            ordered = list;
+            list = next_request;
+        }
+
+        while(ordered != nullptr) {
+            // после done запрос может быть уничтожен владельцем
+            Request* request = ordered;
+            ordered = ordered->next;
+
+            process(*request, pushed, popped);
+
+            m_size.store(size_unsafe(), std::memory_order_relaxed);
+
+            request->done.store(true, std::memory_order_release);
+        }
+    }
+
+    m_combining.store(false, std::memory_order_release);
+
+    wake(pushed, popped);
+}
+
+template<typename T, typename Allocator>
+void CircularBuffer_mrmw_combining<T, Allocator>::process(
+            Request &request,
+            size_t &pushed,
+            size_t &popped
+        )
+{
+    switch(request.kind) {
+    case Request::Kind::push:
+        if(m_head != next(m_tail)) {
+            request.assign(m_data[m_tail], request.value);
+            m_tail = next(m_tail);
+            request.success = true;
+            ++pushed;
+        }
+        break;
+
+    case Request::Kind::pop:
+        if(m_head != m_tail) {
+            *static_cast<T*>(request.value)
+                    = std::move_if_noexcept(m_data[m_head]);
+            m_head = next(m_head);
+            request.success = true;
+            ++popped;
+        }
+        break;
+
+    case Request::Kind::push_n: {
+        size_t counter{0};
+        while(counter < request.count && m_head != next(m_tail)) {
+            request.assign(m_data[m_tail], request.value);
+            m_tail = next(m_tail);
+            ++counter;
+        }
+        request.count = counter;
+        request.success = counter != 0;
+        pushed += counter;
+        break;
+    }
+
+    case Request::Kind::pop_n: {
+        size_t counter{0};
+        while(counter < request.count && m_head != m_tail) {
+            request.extract(m_data[m_head], request.value);
+            m_head = next(m_head);
+            ++counter;
+        }
+        request.count = counter;
+        request.success = counter != 0;
+        popped += counter;
+        break;
+    }
+
+    case Request::Kind::clear:
+        popped += size_unsafe();
+        m_head = m_tail;
+        request.success = true;
+        break;
+
+    case Request::Kind::auto_resize:
+        // политика отключена или размер уже изменен
+        if(! m_auto_resize || m_data.size() - 1 != m_resize_from)
+            return;
+
+        relocate(request, popped);
+        return;
+
+    case Request::Kind::resize:
+        relocate(request, popped);
+        return;
+
+    case Request::Kind::configure:
+        m_auto_resize = request.value != nullptr;
+        if(m_auto_resize)
+            m_auto_resize_policy = *static_cast<AutoResizePolicy*>(request.value);
+        m_high_streak = 0;
+        m_low_streak = 0;
+        request.success = true;
+        return;
+    }
+
+    adapt_unsafe();
+}
+
+template<typename T, typename Allocator>
+void CircularBuffer_mrmw_combining<T, Allocator>::relocate(Request &request, size_t &popped)
+{
+    size_t capacity = m_data.size() - 1;
+    if(request.count < size_unsafe())
+        return;
+
+    relocate_unsafe(*static_cast<storage_type*>(request.value));
+    request.success = true;
+
+    // новые ячейки будят писателей так же, как извлечение
+    if(request.count > capacity)
+        popped += request.count - capacity;
+}
+
+template<typename T, typename Allocator>
+void CircularBuffer_mrmw_combining<T, Allocator>::wake(size_t pushed, size_t popped)
+{
+    // Дополняет fetch_add в sleep (seq_cst): либо спящий увидит
+    // новое m_size, либо комбайнер увидит спящего. Чтение-изменение-
+    // запись вместо барьера: ThreadSanitizer не моделирует барьеры
+    bool readers = pushed != 0
+                && m_waiting_readers.fetch_add(0, std::memory_order_seq_cst) != 0;
+    bool writers = popped != 0
+                && m_waiting_writers.fetch_add(0, std::memory_order_seq_cst) != 0;
+
+    if(! readers && ! writers)
+        return;
+
+    // спящий между проверкой условия и wait держит m_sleep_mutex
+    { std::lock_guard<std::mutex> locker(m_sleep_mutex); }
+
+    if(readers)
+        m_not_empty.notify_all();
+    if(writers)
+        m_not_full.notify_all();
+}
+
+template<typename T, typename Allocator>
+template<typename Type>
+void CircularBuffer_mrmw_combining<T, Allocator>::assign(T &slot, void *src)
+{
+    using Source = typename std::remove_reference<Type>::type;
+    slot = std::forward<Type>(*static_cast<Source*>(src));
+}
+
+template<typename T, typename Allocator>
+template<typename InputIterator>
+void CircularBuffer_mrmw_combining<T, Allocator>::assign_next(T &slot, void *src)
+{
+    InputIterator& it = *static_cast<InputIterator*>(src);
+    slot = *it;
+    ++it;
+}
+
+template<typename T, typename Allocator>
+template<typename OutputIterator>
+void CircularBuffer_mrmw_combining<T, Allocator>::extract_next(T &slot, void *dst)
+{
+    OutputIterator& it = *static_cast<OutputIterator*>(dst);
+    *it = std::move_if_noexcept(slot);
+    ++it;
+}
+
+template<typename T, typename Allocator>
+template<typename Clock, typename Duration>
+WaitStatus CircularBuffer_mrmw_combining<T, Allocator>::wait_not_empty(
+            const std::chrono::time_point<Clock, Duration>* deadline
+        )
+{
+    if(m_delete)
+        return WaitStatus::shutdown;
+
+    if(empty())
+        m_read_spin.wait([this]() { return !empty() || m_delete; });
+
+    if(! empty())
+        return WaitStatus::success;
+
+    return sleep(m_not_empty, m_waiting_readers, [this]() {
+        return m_size.load(std::memory_order_seq_cst) != 0;
+    }, deadline);
+}
+
+template<typename T, typename Allocator>
+template<typename Clock, typename Duration>
+WaitStatus CircularBuffer_mrmw_combining<T, Allocator>::wait_not_full(
+            const std::chrono::time_point<Clock, Duration>* deadline
+        )
+{
+    if(m_delete)
+        return WaitStatus::shutdown;
+
+    if(full())
+        m_write_spin.wait([this]() { return !full() || m_delete; });
+
+    if(! full())
+        return WaitStatus::success;
+
+    return sleep(m_not_full, m_waiting_writers, [this]() {
+        return m_size.load(std::memory_order_seq_cst) < max_size();
+    }, deadline);
+}
+
+template<typename T, typename Allocator>
+template<typename Type, typename Clock, typename Duration>
+WaitStatus CircularBuffer_mrmw_combining<T, Allocator>::push_wait_impl(
+            Type&& value,
+            const std::chrono::time_point<Clock, Duration>* deadline
+        )
+{
+    while(true) {
+        if(m_delete)
+            return WaitStatus::shutdown;
+
+        if(full())
+            m_write_spin.wait([this]() { return !full() || m_delete; });
+
+        if(try_push_back(std::forward<Type>(value)))
+            return WaitStatus::success;
+
+        WaitStatus status = sleep(m_not_full, m_waiting_writers, [this]() {
+            return m_size.load(std::memory_order_seq_cst) < max_size();
+        }, deadline);
+
+        if(status != WaitStatus::success)
+            return status;
+    }
+}
+
+template<typename T, typename Allocator>
+template<typename Clock, typename Duration>
+WaitStatus CircularBuffer_mrmw_combining<T, Allocator>::pop_wait_impl(
+            T& result,
+            const std::chrono::time_point<Clock, Duration>* deadline
+        )
+{
+    while(true) {
+        if(m_delete)
+            return WaitStatus::shutdown;
+
+        if(empty())
+            m_read_spin.wait([this]() { return !empty() || m_delete; });
+
+        if(try_pop(result))
+            return WaitStatus::success;
+
+        WaitStatus status = sleep(m_not_empty, m_waiting_readers, [this]() {
+            return m_size.load(std::memory_order_seq_cst) != 0;
+        }, deadline);
+
+        if(status != WaitStatus::success)
+            return status;
+    }
+}
+
+template<typename T, typename Allocator>
+template<typename Predicate, typename Clock, typename Duration>
+WaitStatus CircularBuffer_mrmw_combining<T, Allocator>::sleep(
+            std::condition_variable &cv,
+            std::atomic<size_t> &waiters,
+            Predicate ready,
+            const std::chrono::time_point<Clock, Duration>* deadline
+        )
+{
+    std::unique_lock<std::mutex> locker(m_sleep_mutex);
+
+    // счетчик увеличивается до повторной проверки условия,
+    // чтобы комбайнер гарантированно увидел спящего
+    waiters.fetch_add(1, std::memory_order_seq_cst);
+
+    auto wake_up = [&]() {
+        return ready() || m_delete;
+    };
+
+    bool success = true;
+    if(deadline)
+        success = cv.wait_until(locker, *deadline, wake_up);
+    else
+        cv.wait(locker, wake_up);
+
+    waiters.fetch_sub(1, std::memory_order_relaxed);
+
+    if(m_delete)
+        return WaitStatus::shutdown;
+
+    return success ? WaitStatus::success : WaitStatus::timeout;
+}
+
+}
+#endif // CIRCULAR_BUFFER_COMBINING_MRMW_H
@@ -0,0 +1,443 @@
+#ifndef CIRCULAR_BUFFER_CORO_H
+#define CIRCULAR_BUFFER_CORO_H
+
+#include <atomic>
+#include <mutex>
+#include <utility>
+
+#include "circular_buffer_fwd.h"
+#include "circular_buffer_policies.h"
+#include "circular_buffer_wait_status.h"
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#include <optional>
+#define CIRCULAR_BUFFER_HAS_COROUTINES 1
+#endif
+#endif
+
+namespace connest {
+namespace detail {
+
+class coro_waiters;
+
+/**
+ * @brief Доступ объектов ожидания к закрытым операциям буферов
+ */
+struct coro_access
+{
+    template<typename Buffer, typename T>
+    static bool take(Buffer& buffer, T& result)
+    {
+        return buffer.take(result);
+    }
+
+    template<typename Buffer, typename Type>
+    static bool put(Buffer& buffer, Type&& value)
+    {
+        return buffer.put(std::forward<Type>(value));
+    }
+
+    template<typename Buffer>
+    static coro_waiters& waiters(Buffer& buffer)
+    {
+        return buffer.coro_waiters();
+    }
+};
+
+#ifdef CIRCULAR_BUFFER_HAS_COROUTINES
+
+/**
+  @brief    Сопрограмма, ожидающая в co_await push / pop
+  @details
+        Хранится в объекте ожидания, т.е. в кадре сопрограммы - без
+        выделения памяти на каждое ожидание. complete - попытка
+        выполнить операцию без пробуждения противоположной стороны;
+        вызывается под мьютексом списка.
+ */
+struct coro_waiter
+{
+    coro_waiter* next = nullptr;
+    std::coroutine_handle<> handle{};
+    bool (*complete)(coro_waiter&) = nullptr;
+    WaitStatus status = WaitStatus::success;
+};
+
+/**
+  @brief    Интрузивная FIFO-очередь ожидающих сопрограмм одной стороны
+  @details
+        Ожидающий увеличивает m_count, затем под мьютексом повторяет
+        операцию и только при неудаче встает в очередь. Сторона,
+        изменившая буфер, читает m_count операцией чтения-изменения-
+        записи (как у park_wait): либо повторная попытка увидит
+        изменение, либо изменивший увидит ожидающего. Без ожидающих
+        мьютекс не захватывается.
+ */
+class coro_waiter_list final
+{
+    std::mutex m_mutex;
+    coro_waiter* m_head = nullptr;
+    coro_waiter* m_tail = nullptr;
+
+    std::atomic<size_t> m_count{0};
+    std::atomic_bool m_closed{false};
+
+public:
+    coro_waiter_list()
+        : m_mutex{}
+    {}
+
+    bool waiting() const noexcept
+    {
+        return m_count.load(std::memory_order_relaxed) != 0;
+    }
+
+    /**
+     * @brief   Проверить ожидающих после изменения буфера: в паре с
+     *          fetch_add в suspend (seq_cst чтение-изменение-запись вместо
+     *          барьера, который не моделирует ThreadSanitizer)
+     */
+    bool waiting_after_change() noexcept
+    {
+        return m_count.fetch_add(0, std::memory_order_seq_cst) != 0;
+    }
+
+    bool closed() const noexcept
+    {
+        return m_closed.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Встать в очередь, если операция по-прежнему невозможна
+     * @return true - сопрограмма приостановлена; false - операция
+     *         выполнена (success) или буфер завершен (shutdown)
+     */
+    bool suspend(coro_waiter& waiter)
+    {
+        m_count.fetch_add(1, std::memory_order_seq_cst);
+
+        std::lock_guard<std::mutex> locker(m_mutex);
+
+        if(m_closed.load(std::memory_order_relaxed)) {
+            m_count.fetch_sub(1, std::memory_order_relaxed);
+            waiter.status = WaitStatus::shutdown;
+            return false;
+        }
+
+        if(waiter.complete(waiter)) {
+            m_count.fetch_sub(1, std::memory_order_relaxed);
+            waiter.status = WaitStatus::success;
+            return false;
+        }
+
+        waiter.next = nullptr;
+        if(m_tail)
+            m_tail->next = &waiter;
+        else
+            m_head = &waiter;
+        m_tail = &waiter;
+
+        return true;
+    }
+
+    /**
+     * @brief   Выполнить операции первых ожидающих, пока это возможно
+     * @param ready хвост цепочки готовых к возобновлению
+     * @return количество выполненных операций
+     */
+    size_t complete(coro_waiter**& ready)
+    {
+        if(! waiting())
+            return 0;
+
+        size_t counter{0};
+        std::lock_guard<std::mutex> locker(m_mutex);
+
+        while(m_head && m_head->complete(*m_head)) {
+            coro_waiter* waiter = m_head;
+            m_head = waiter->next;
+            if(! m_head)
+                m_tail = nullptr;
+
+            waiter->status = WaitStatus::success;
+            waiter->next = nullptr;
+            *ready = waiter;
+            ready = &waiter->next;
+
+            m_count.fetch_sub(1, std::memory_order_relaxed);
+            ++counter;
+        }
+
+        return counter;
+    }
+
+    /**
+     * @brief Закрыть очередь, все ожидающие получают shutdown
+     * @return цепочка для возобновления
+     */
+    coro_waiter* close()
+    {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        m_closed.store(true, std::memory_order_release);
+
+        coro_waiter* result = m_head;
+        for(coro_waiter* waiter = m_head; waiter; waiter = waiter->next)
+            waiter->status = WaitStatus::shutdown;
+
+        m_head = m_tail = nullptr;
+        m_count.store(0, std::memory_order_relaxed);
+        return result;
+    }
+};
+
+/**
+  @brief    Ожидающие сопрограммы обеих сторон буфера
+  @details
+        notify_readable / notify_writable вызываются после добавления /
+        извлечения элементов (без блокировок буфера). Проверяется только
+        сторона, для которой изменилось условие; противоположная - лишь
+        если ожидающие первой выполнили операции (извлечение освобождает
+        место писателям и наоборот). Затем сопрограммы возобновляются
+        в вызывающем потоке - уже без мьютексов.
+ */
+class coro_waiters final
+{
+    coro_waiter_list m_readers;
+    coro_waiter_list m_writers;
+
+public:
+    coro_waiters()
+        : m_readers{}
+        , m_writers{}
+    {}
+
+    coro_waiter_list& readers() noexcept { return m_readers; }
+    coro_waiter_list& writers() noexcept { return m_writers; }
+
+    bool closed() const noexcept { return m_readers.closed(); }
+
+    void notify_readable() { transfer(m_readers, m_writers); }
+    void notify_writable() { transfer(m_writers, m_readers); }
+
+    void shutdown()
+    {
+        resume(m_readers.close());
+        resume(m_writers.close());
+    }
+
+private:
+    static void transfer(coro_waiter_list& first, coro_waiter_list& second)
+    {
+        // без ожидающих - одна операция чтения-изменения-записи
+        if(! first.waiting_after_change())
+            return;
+
+        coro_waiter* ready = nullptr;
+        coro_waiter** tail = &ready;
+
+        // условие второй стороны меняют только выполненные операции первой
+        while(first.complete(tail) != 0
+              && second.waiting_after_change()
+              && second.complete(tail) != 0) {}
+
+        resume(ready);
+    }
+
+    static void resume(coro_waiter* waiter)
+    {
+        while(waiter) {
+            // после возобновления объект ожидания может быть уже разрушен
+            coro_waiter* next = waiter->next;
+            waiter->handle.resume();
+            waiter = next;
+        }
+    }
+};
+
+
+/**
+  @brief    Объект ожидания co_await buffer.pop()
+  @return   std::optional<T>: значение или пусто после shutdown()
+ */
+template<typename Buffer, typename T>
+class pop_awaiter final : private coro_waiter
+{
+    Buffer& m_buffer;
+    T m_value;
+
+public:
+    explicit pop_awaiter(Buffer& buffer)
+        : coro_waiter{}
+        , m_buffer(buffer)
+        , m_value{}
+    {
+        complete = &pop_awaiter::attempt;
+    }
+
+    pop_awaiter(const pop_awaiter&) = delete;
+    pop_awaiter& operator=(const pop_awaiter&) = delete;
+
+    bool await_ready()
+    {
+        if(coro_access::waiters(m_buffer).closed()) {
+            status = WaitStatus::shutdown;
+            return true;
+        }
+
+        return m_buffer.try_pop(m_value);
+    }
+
+    bool await_suspend(std::coroutine_handle<> awaiting)
+    {
+        handle = awaiting;
+
+        coro_waiters& waiters = coro_access::waiters(m_buffer);
+        if(waiters.readers().suspend(*this))
+            return true;
+
+        // элемент извлечен при постановке в очередь - место освободилось
+        if(status == WaitStatus::success)
+            waiters.notify_writable();
+
+        return false;
+    }
+
+    std::optional<T> await_resume()
+    {
+        if(status != WaitStatus::success)
+            return std::nullopt;
+
+        return std::optional<T>(std::move(m_value));
+    }
+
+private:
+    static bool attempt(coro_waiter& waiter)
+    {
+        pop_awaiter& self = static_cast<pop_awaiter&>(waiter);
+        return coro_access::take(self.m_buffer, self.m_value);
+    }
+};
+
+/**
+  @brief    Объект ожидания co_await buffer.push(value)
+  @details  Хранит ссылку на value: аргумент живет до конца выражения
+            co_await (временный объект - в кадре сопрограммы).
+            Значение перемещается / копируется только при успехе
+  @return   WaitStatus::success или WaitStatus::shutdown
+ */
+template<typename Buffer, typename Type>
+class push_awaiter final : private coro_waiter
+{
+    Buffer& m_buffer;
+    Type&& m_value;
+
+public:
+    push_awaiter(Buffer& buffer, Type&& value)
+        : coro_waiter{}
+        , m_buffer(buffer)
+        , m_value(std::forward<Type>(value))
+    {
+        complete = &push_awaiter::attempt;
+    }
+
+    push_awaiter(const push_awaiter&) = delete;
+    push_awaiter& operator=(const push_awaiter&) = delete;
+
+    bool await_ready()
+    {
+        if(coro_access::waiters(m_buffer).closed()) {
+            status = WaitStatus::shutdown;
+            return true;
+        }
+
+        return m_buffer.try_push_back(std::forward<Type>(m_value));
+    }
+
+    bool await_suspend(std::coroutine_handle<> awaiting)
+    {
+        handle = awaiting;
+
+        coro_waiters& waiters = coro_access::waiters(m_buffer);
+        if(waiters.writers().suspend(*this))
+            return true;
+
+        if(status == WaitStatus::success)
+            waiters.notify_readable();
+
+        return false;
+    }
+
+    WaitStatus await_resume() const noexcept
+    {
+        return status;
+    }
+
+private:
+    static bool attempt(coro_waiter& waiter)
+    {
+        push_awaiter& self = static_cast<push_awaiter&>(waiter);
+        return coro_access::put(self.m_buffer, std::forward<Type>(self.m_value));
+    }
+};
+
+
+/**
+  @brief    Ожидание для WaitPolicy = coro_wait
+  @details
+        Потоки в push_back_wait / pop_wait ждут активно (как spin_wait),
+        сопрограммы в co_await push / pop - в coro_waiters.
+ */
+template<>
+class wait_state<coro_wait> final
+{
+    wait_state<spin_wait> m_spin;
+    coro_waiters m_waiters;
+
+public:
+    wait_state()
+        : m_spin{}
+        , m_waiters{}
+    {}
+
+    void notify_readable(size_t = 1) { m_waiters.notify_readable(); }
+    void notify_writable(size_t = 1) { m_waiters.notify_writable(); }
+    void shutdown()        { m_waiters.shutdown(); }
+
+    coro_waiters& waiters() noexcept { return m_waiters; }
+
+    template<typename Ready, typename Clock, typename Duration>
+    WaitStatus wait_readable(Ready ready,
+                             const std::atomic_bool& stop,
+                             const std::chrono::time_point<Clock, Duration>* deadline)
+    {
+        return m_spin.wait_readable(ready, stop, deadline);
+    }
+
+    template<typename Ready, typename Clock, typename Duration>
+    WaitStatus wait_writable(Ready ready,
+                             const std::atomic_bool& stop,
+                             const std::chrono::time_point<Clock, Duration>* deadline)
+    {
+        return m_spin.wait_writable(ready, stop, deadline);
+    }
+};
+
+#else
+
+/**
+ * @brief Без поддержки сопрограмм ожидающих нет
+ */
+class coro_waiters final
+{
+public:
+    void notify_readable() noexcept {}
+    void notify_writable() noexcept {}
+    void shutdown() noexcept {}
+};
+
+#endif
+
+}
+}
+#endif // CIRCULAR_BUFFER_CORO_H
@@ -0,0 +1,444 @@
+#ifndef CIRCULAR_BUFFER_EXECUTOR_H
+#define CIRCULAR_BUFFER_EXECUTOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "circular_buffer_fwd.h"
+#include "circular_buffer_basic.h"
+#include "circular_buffer_wait_status.h"
+
+namespace connest {
+
+/**
+  @brief    Задача без аргументов и результата (только перемещение)
+  @details
+        Замена std::function<void()> для ячеек буфера: вызываемый объект
+        размером до capacity байт (и с noexcept перемещением) хранится
+        внутри задачи, больший - в куче. Size - размер объекта задачи
+        (по умолчанию 64 байта - одна строка кеша на ячейку), из них
+        sizeof(void*) занимает указатель на операции.
+
+        Перемещение оставляет источник пустым, поэтому захваченные
+        объекты освобождаются, как только задача извлечена из ячейки.
+ */
+template<size_t Size = 64>
+class small_task final
+{
+public:
+    static constexpr size_t capacity = Size - sizeof(void*);
+
+private:
+    static_assert(Size > sizeof(void*) && Size % alignof(std::max_align_t) == 0,
+                  "small_task Size must be a multiple of alignof(std::max_align_t)");
+
+    struct operations
+    {
+        void (*invoke)(void* storage);
+        void (*relocate)(void* to, void* from) noexcept;
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    alignas(std::max_align_t) unsigned char m_storage[capacity];
+    const operations* m_operations;
+
+public:
+    /**
+     * @brief Помещается ли F внутрь задачи (иначе размещается в куче)
+     */
+    template<typename F>
+    static constexpr bool fits_inline()
+    {
+        return sizeof(F) <= capacity
+            && alignof(std::max_align_t) % alignof(F) == 0
+            && std::is_nothrow_move_constructible<F>::value;
+    }
+
+    small_task() noexcept
+        : m_operations{nullptr}
+    {}
+
+    template<typename F,
+             typename Function = typename std::decay<F>::type,
+             typename = typename std::enable_if<! std::is_same<Function, small_task>::value>::type>
+    small_task(F&& function)
+        : m_operations{nullptr}
+    {
+        assign<Function>(std::forward<F>(function),
+                         std::integral_constant<bool, fits_inline<Function>()>{});
+    }
+
+    small_task(small_task&& other) noexcept
+        : m_operations{nullptr}
+    {
+        take(other);
+    }
+
+    small_task& operator=(small_task&& other) noexcept
+    {
+        if(this != &other) {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    small_task(const small_task&) = delete;
+    small_task& operator=(const small_task&) = delete;
+
+    ~small_task()
+    {
+        reset();
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return m_operations != nullptr;
+    }
+
+    /**
+     * @brief Выполнить задачу (задача должна быть непустой)
+     */
+    void operator()()
+    {
+        m_operations->invoke(m_storage);
+    }
+
+    /**
+     * @brief Освободить вызываемый объект
+     */
+    void reset() noexcept
+    {
+        if(m_operations) {
+            m_operations->destroy(m_storage);
+            m_operations = nullptr;
+        }
+    }
+
+private:
+    void take(small_task& other) noexcept
+    {
+        if(other.m_operations) {
+            other.m_operations->relocate(m_storage, other.m_storage);
+            m_operations = other.m_operations;
+            other.m_operations = nullptr;
+        }
+    }
+
+    // вызываемый объект внутри задачи
+    template<typename Function, typename F>
+    void assign(F&& function, std::true_type)
+    {
+        static const operations ops = {
+            [](void* storage) {
+                (*static_cast<Function*>(storage))();
+            },
+            [](void* to, void* from) noexcept {
+                Function* source = static_cast<Function*>(from);
+                ::new(to) Function(std::move(*source));
+                source->~Function();
+            },
+            [](void* storage) noexcept {
+                static_cast<Function*>(storage)->~Function();
+            }
+        };
+
+        ::new(static_cast<void*>(m_storage)) Function(std::forward<F>(function));
+        m_operations = &ops;
+    }
+
+    // вызываемый объект в куче, внутри - указатель
+    template<typename Function, typename F>
+    void assign(F&& function, std::false_type)
+    {
+        static const operations ops = {
+            [](void* storage) {
+                (**static_cast<Function**>(storage))();
+            },
+            [](void* to, void* from) noexcept {
+                ::new(to) Function*(*static_cast<Function**>(from));
+            },
+            [](void* storage) noexcept {
+                delete *static_cast<Function**>(storage);
+            }
+        };
+
+        ::new(static_cast<void*>(m_storage)) Function*(new Function(std::forward<F>(function)));
+        m_operations = &ops;
+    }
+};
+
+
+/**
+  @brief    Пул потоков, получающих задачи из lockfree буфера
+  @details
+        Фиксированное количество рабочих потоков читает задачи из
+        basic_circular_buffer<Task, multi_producer, multi_consumer,
+        park_wait>: задачи хранятся прямо в ячейках (small_task - без
+        выделения памяти для небольших вызываемых объектов), а
+        простаивающие потоки после короткого активного ожидания спят на
+        условной переменной. Отправители будят их, только если есть
+        спящие.
+
+        Порядок запуска задач соответствует порядку отправки, порядок
+        завершения не определен. Исключение, вышедшее из задачи,
+        завершает программу (как в std::thread).
+
+        shutdown() (и деструктор) прекращает прием задач, дожидается
+        выполнения уже принятых и останавливает потоки.
+ */
+template<typename Task = small_task<>>
+class thread_pool_executor final
+{
+public:
+    using task_type  = Task;
+    using queue_type = basic_circular_buffer<Task, multi_producer, multi_consumer, park_wait>;
+
+private:
+    queue_type m_queue;
+    std::vector<std::thread> m_workers;
+    std::atomic_bool m_stopped;
+
+    // отправители между проверкой m_stopped и возвратом: shutdown() ждет
+    // их перед последним дочитыванием очереди
+    std::atomic<size_t> m_submitting;
+
+    /**
+     * @brief   Учет отправителя в m_submitting на время отправки
+     */
+    struct submit_scope
+    {
+        std::atomic<size_t>& counter;
+
+        explicit submit_scope(std::atomic<size_t>& submitting) noexcept
+            : counter(submitting)
+        {
+            // seq_cst в паре с m_stopped: либо отправитель увидит остановку,
+            // либо shutdown() увидит отправителя
+            counter.fetch_add(1, std::memory_order_seq_cst);
+        }
+
+        ~submit_scope()
+        {
+            counter.fetch_sub(1, std::memory_order_release);
+        }
+
+        submit_scope(const submit_scope&) = delete;
+        submit_scope& operator=(const submit_scope&) = delete;
+    };
+
+public:
+    /**
+     * @param threads  количество рабочих потоков (0 - по числу процессоров)
+     * @param capacity максимальное количество ожидающих задач
+     */
+    explicit thread_pool_executor(size_t threads = 0, size_t capacity = 1024);
+
+    thread_pool_executor(const thread_pool_executor&) = delete;
+    thread_pool_executor(thread_pool_executor&&) = delete;
+    thread_pool_executor& operator=(const thread_pool_executor&) = delete;
+    thread_pool_executor& operator=(thread_pool_executor&&) = delete;
+
+    ~thread_pool_executor();
+
+    /**
+     * @brief Получить количество рабочих потоков
+     */
+    size_t thread_count() const noexcept;
+
+    /**
+     * @brief   Получить количество задач в очереди
+     *          (без выполняемых; значение может сразу устареть)
+     */
+    size_t pending() const noexcept;
+
+    /**
+     * @brief   Отправить задачу. Если очередь заполнена, ждать места
+     * @param function вызываемый объект без аргументов (или Task)
+     * @return WaitStatus::success или WaitStatus::shutdown
+     */
+    template<typename F>
+    WaitStatus submit(F&& function);
+
+    /**
+     * @brief   Попытаться отправить задачу без ожидания
+     * @param function вызываемый объект без аргументов (или Task)
+     * @return  false, если очередь заполнена или пул остановлен
+     *          (function при этом не перемещается)
+     */
+    template<typename F>
+    bool try_submit(F&& function);
+
+    /**
+     * @brief   Отправить задачи диапазона. Элементы перемещаются сериями
+     *          (push_back_all: один захват ячейки на задачу, одно
+     *          пробуждение рабочих на серию); при заполненной очереди
+     *          отправитель ждет места
+     * @param begin итератор начала диапазона вызываемых объектов
+     * @param end   итератор конца диапазона
+     * @return  количество отправленных задач (меньше размера диапазона
+     *          только при остановке пула)
+     */
+    template<typename ForwardIterator>
+    size_t submit_bulk(ForwardIterator begin, ForwardIterator end);
+
+    /**
+     * @brief   Прекратить прием задач, выполнить принятые и остановить
+     *          рабочие потоки. Вызывается деструктором; не вызывается
+     *          из задач пула
+     */
+    void shutdown();
+
+private:
+    /**
+     * @brief Цикл рабочего потока
+     */
+    void work();
+
+    /**
+     * @brief Выполнить задачу и сразу освободить ее захваченные объекты
+     */
+    static void run(Task& task);
+};
+
+
+// Implementation
+
+template<typename Task>
+thread_pool_executor<Task>::thread_pool_executor(size_t threads, size_t capacity)
+    : m_queue(capacity)
+    , m_workers{}
+    , m_stopped{false}
+    , m_submitting{0}
+{
+    if(threads == 0)
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    m_workers.reserve(threads);
+    for(size_t i = 0; i < threads; ++i)
+        m_workers.emplace_back([this]() { work(); });
+}
+
+template<typename Task>
+thread_pool_executor<Task>::~thread_pool_executor()
+{
+    shutdown();
+}
+
+template<typename Task>
+size_t thread_pool_executor<Task>::thread_count() const noexcept
+{
+    return m_workers.size();
+}
+
+template<typename Task>
+size_t thread_pool_executor<Task>::pending() const noexcept
+{
+    return m_queue.size();
+}
+
+template<typename Task>
+template<typename F>
+WaitStatus thread_pool_executor<Task>::submit(F&& function)
+{
+    submit_scope scope(m_submitting);
+
+    if(m_stopped.load(std::memory_order_seq_cst))
+        return WaitStatus::shutdown;
+
+    return m_queue.push_back_wait(std::forward<F>(function));
+}
+
+template<typename Task>
+template<typename F>
+bool thread_pool_executor<Task>::try_submit(F&& function)
+{
+    submit_scope scope(m_submitting);
+
+    if(m_stopped.load(std::memory_order_seq_cst))
+        return false;
+
+    return m_queue.try_push_back(std::forward<F>(function));
+}
+
+template<typename Task>
+template<typename ForwardIterator>
+size_t thread_pool_executor<Task>::submit_bulk(ForwardIterator begin, ForwardIterator end)
+{
+    auto first = std::make_move_iterator(begin);
+    auto last  = std::make_move_iterator(end);
+
+    size_t counter{0};
+    submit_scope scope(m_submitting);
+
+    while(first != last && ! m_stopped.load(std::memory_order_seq_cst)) {
+        // сколько помещается - одной серией, с одним пробуждением
+        size_t pushed = m_queue.push_back_all(first, last);
+        std::advance(first, pushed);
+        counter += pushed;
+
+        if(first == last)
+            break;
+
+        // очередь заполнена - ждем места для очередной задачи
+        if(m_queue.push_back_wait(*first) != WaitStatus::success)
+            break;
+
+        ++first;
+        ++counter;
+    }
+
+    return counter;
+}
+
+template<typename Task>
+void thread_pool_executor<Task>::shutdown()
+{
+    if(m_stopped.exchange(true))
+        return;
+
+    m_queue.shutdown();
+
+    for(auto& worker : m_workers)
+        worker.join();
+
+    // отправитель, прошедший проверку до остановки, еще может добавить
+    // задачу (и вернуть success) - ждем всех
+    while(m_submitting.load(std::memory_order_seq_cst) != 0)
+        std::this_thread::yield();
+
+    // задачи, принятые одновременно с остановкой
+    Task task;
+    while(m_queue.try_pop(task))
+        run(task);
+}
+
+template<typename Task>
+void thread_pool_executor<Task>::work()
+{
+    Task task;
+
+    while(m_queue.pop_wait(task) == WaitStatus::success)
+        run(task);
+
+    // после shutdown() pop_wait больше не выдает элементы - дочитываем
+    while(m_queue.try_pop(task))
+        run(task);
+}
+
+template<typename Task>
+void thread_pool_executor<Task>::run(Task& task)
+{
+    task();
+    task = Task();
+}
+
+}
+#endif // CIRCULAR_BUFFER_EXECUTOR_H
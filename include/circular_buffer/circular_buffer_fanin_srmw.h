@@ -0,0 +1,492 @@
+#ifndef CIRCULAR_BUFFER_FANIN_SRMW_H
+#define CIRCULAR_BUFFER_FANIN_SRMW_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "circular_buffer_fwd.h"
+#include "circular_buffer_basic.h"
+
+namespace connest {
+
+/**
+  @brief Порядок опроса полос читателем CircularBuffer_srmw_fanin
+ */
+enum class PollOrder
+{
+    round_robin,    // по кругу, начиная со следующей за последней опрошенной
+    occupancy       // сначала самые заполненные
+};
+
+namespace detail {
+
+/**
+  @brief    Полоса одного писателя
+  @details
+        owned - полосу использует поток-писатель (снимается при
+        завершении потока, после чего полосу может занять другой поток).
+        closed - буфер разрушен, запись в реестре потока устарела.
+ */
+template<typename T>
+struct fanin_lane
+{
+    CircularBuffer_srsw<T> buffer;
+    std::atomic_bool owned;
+    std::atomic_bool closed;
+
+    explicit fanin_lane(size_t size)
+        : buffer(size)
+        , owned{true}
+        , closed{false}
+    {}
+};
+
+/**
+ * @brief Уникальный номер буфера (адрес может быть использован повторно)
+ */
+inline uint64_t fanin_next_id() noexcept
+{
+    static std::atomic<uint64_t> counter{0};
+    return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+/**
+  @brief    Полосы текущего потока во всех буферах с элементами T
+  @details
+        При завершении потока его полосы освобождаются для других
+        потоков. Полосы разделяются с буфером (shared_ptr), поэтому
+        порядок разрушения буфера и потока не важен.
+ */
+template<typename T>
+struct fanin_registry
+{
+    struct entry
+    {
+        uint64_t queue;
+        std::shared_ptr<fanin_lane<T>> lane;
+    };
+
+    std::vector<entry> entries;
+
+    fanin_registry()
+        : entries{}
+    {}
+
+    ~fanin_registry()
+    {
+        for(auto& e : entries)
+            e.lane->owned.store(false, std::memory_order_release);
+    }
+
+    static fanin_registry& local()
+    {
+        static thread_local fanin_registry registry;
+        return registry;
+    }
+};
+
+}
+
+/**
+  @brief    Буфер single reader - multiple writer из полос писателей
+  @details
+        Каждый поток-писатель при первой записи получает собственную
+        полосу - CircularBuffer_srsw<T> (lockfree, без CAS): писатели
+        не разделяют ни индексов, ни строк кеша, и стоимость записи
+        не зависит от их количества. Единственный читатель опрашивает
+        полосы по кругу или по заполненности (PollOrder) и забирает из
+        полосы до batch элементов подряд.
+
+        Порядок FIFO соблюдается для элементов одного потока, но не
+        между потоками.
+
+        Полоса закрепляется за потоком до его завершения, затем ее
+        занимает следующий новый поток (оставшиеся в ней элементы
+        прочитываются раньше его элементов). Полос не больше max_lanes:
+        поток, которому полоса не досталась, получает std::length_error.
+        Регистрация выполняется под мьютексом, опрос полос читателем -
+        без блокировок.
+ */
+template <typename T>
+class CircularBuffer_srmw_fanin final
+{
+public:
+    using lane_type = CircularBuffer_srsw<T>;
+
+private:
+    using lane_state = detail::fanin_lane<T>;
+    using registry   = detail::fanin_registry<T>;
+
+    const uint64_t m_id;
+    const size_t m_lane_size;
+    const PollOrder m_order;
+    const size_t m_batch;
+
+    // регистрация полос (писатели, медленный путь)
+    std::mutex m_mutex;
+    std::vector<std::shared_ptr<lane_state>> m_owners;
+
+    // опубликованные полосы: ячейки [0, m_lane_count) заполнены
+    std::unique_ptr<std::atomic<lane_state*>[]> m_lanes;
+    const size_t m_max_lanes;
+    alignas(64) std::atomic<size_t> m_lane_count;
+
+    // состояние читателя
+    alignas(64) size_t m_current;
+    size_t m_taken;
+
+public:
+    /**
+     * @param lane_size максимальное количество элементов в полосе писателя
+     * @param max_lanes максимальное количество полос (потоков-писателей)
+     * @param order     порядок опроса полос читателем
+     * @param batch     сколько элементов подряд try_pop забирает из одной полосы
+     */
+    explicit CircularBuffer_srmw_fanin(size_t lane_size,
+                                       size_t max_lanes = 64,
+                                       PollOrder order = PollOrder::round_robin,
+                                       size_t batch = 64);
+
+    CircularBuffer_srmw_fanin(const CircularBuffer_srmw_fanin& other) = delete;
+    CircularBuffer_srmw_fanin(CircularBuffer_srmw_fanin&& other) = delete;
+    CircularBuffer_srmw_fanin& operator=(const CircularBuffer_srmw_fanin&) = delete;
+    CircularBuffer_srmw_fanin& operator=(CircularBuffer_srmw_fanin&&) = delete;
+
+    ~CircularBuffer_srmw_fanin();
+
+    /**
+     * @brief Получить количество зарегистрированных полос
+     */
+    size_t lane_count() const noexcept;
+
+    /**
+     * @brief Получить максимальное количество полос
+     */
+    size_t max_lanes() const noexcept;
+
+    /**
+     * @brief Получить вместимость одной полосы
+     */
+    size_t lane_size() const noexcept;
+
+    /**
+     * @brief Получить количество элементов во всех полосах
+     * @return количество элементов (значение может сразу устареть)
+     */
+    size_t size() const noexcept;
+
+    /**
+     * @brief Проверить, пусты ли все полосы
+     */
+    bool empty() const noexcept;
+
+    /**
+     * @brief   Добавить элемент в полосу текущего потока
+     *          (при первой записи потока полоса регистрируется)
+     * @param value значение элемента
+     * @return флаг успешности операции (полоса потока заполнена)
+     * @throw std::length_error все max_lanes полос заняты другими потоками
+     */
+    template<typename Type>
+    bool try_push_back(Type&& value);
+
+    /**
+     * @brief   Добавить элементы из диапазона в полосу текущего потока
+     *          (пока есть место)
+     * @param begin итератор начала диапазона контейнера
+     * @param end   итератор конца диапазона контейнера
+     * @return количество записанных элементов
+     * @throw std::length_error все max_lanes полос заняты другими потоками
+     */
+    template<typename ForwardInputIterator>
+    size_t push_back_all(ForwardInputIterator begin, ForwardInputIterator end);
+
+    /**
+     * @brief   Получить элемент. Только поток-читатель
+     * @param result место, куда будет записано значение
+     * @return флаг успешности операции (все полосы пусты)
+     */
+    bool try_pop(T& result);
+
+    /**
+     * @brief   Забрать элементы из всех полос в контейнер, полоса за
+     *          полосой в порядке опроса. Только поток-читатель
+     * @param container    контейнер назначения
+     * @param max_per_lane не больше стольких элементов из одной полосы
+     *                     (0 - все доступные)
+     * @return количество полученных элементов
+     */
+    template<typename ContainerType>
+    size_t pop_all(ContainerType& container, size_t max_per_lane = 0);
+
+private:
+    /**
+     * @brief Полоса текущего потока (регистрируется при первом обращении)
+     */
+    lane_state& local_lane();
+
+    /**
+     * @brief Занять освобожденную полосу или создать новую
+     */
+    std::shared_ptr<lane_state> acquire_lane();
+
+    /**
+     * @brief Номера полос в порядке опроса, начиная после текущей
+     */
+    void poll_order(std::vector<size_t>& order, size_t count) const;
+};
+
+
+// Implementation
+
+template<typename T>
+CircularBuffer_srmw_fanin<T>::CircularBuffer_srmw_fanin(size_t lane_size,
+                                                        size_t max_lanes,
+                                                        PollOrder order,
+                                                        size_t batch)
+    : m_id(detail::fanin_next_id())
+    , m_lane_size(lane_size)
+    , m_order(order)
+    , m_batch(batch == 0 ? 1 : batch)
+    , m_mutex{}
+    , m_owners{}
+    , m_lanes(new std::atomic<lane_state*>[max_lanes == 0 ? 1 : max_lanes])
+    , m_max_lanes(max_lanes == 0 ? 1 : max_lanes)
+    , m_lane_count{0}
+    , m_current{0}
+    , m_taken{0}
+{
+    m_owners.reserve(m_max_lanes);
+
+    for(size_t i = 0; i < m_max_lanes; ++i)
+        m_lanes[i].store(nullptr, std::memory_order_relaxed);
+}
+
+template<typename T>
+CircularBuffer_srmw_fanin<T>::~CircularBuffer_srmw_fanin()
+{
+    // записи в реестрах живых потоков удаляются при их следующей регистрации
+    for(auto& lane : m_owners)
+        lane->closed.store(true, std::memory_order_relaxed);
+}
+
+template<typename T>
+size_t CircularBuffer_srmw_fanin<T>::lane_count() const noexcept
+{
+    return m_lane_count.load(std::memory_order_acquire);
+}
+
+template<typename T>
+size_t CircularBuffer_srmw_fanin<T>::max_lanes() const noexcept
+{
+    return m_max_lanes;
+}
+
+template<typename T>
+size_t CircularBuffer_srmw_fanin<T>::lane_size() const noexcept
+{
+    return m_lane_size;
+}
+
+template<typename T>
+size_t CircularBuffer_srmw_fanin<T>::size() const noexcept
+{
+    size_t count = m_lane_count.load(std::memory_order_acquire);
+
+    size_t result = 0;
+    for(size_t i = 0; i < count; ++i)
+        result += m_lanes[i].load(std::memory_order_relaxed)->buffer.size();
+
+    return result;
+}
+
+template<typename T>
+bool CircularBuffer_srmw_fanin<T>::empty() const noexcept
+{
+    size_t count = m_lane_count.load(std::memory_order_acquire);
+
+    for(size_t i = 0; i < count; ++i)
+        if(! m_lanes[i].load(std::memory_order_relaxed)->buffer.empty())
+            return false;
+
+    return true;
+}
+
+template<typename T>
+template<typename Type>
+bool CircularBuffer_srmw_fanin<T>::try_push_back(Type&& value)
+{
+    return local_lane().buffer.try_push_back(std::forward<Type>(value));
+}
+
+template<typename T>
+template<typename ForwardInputIterator>
+size_t CircularBuffer_srmw_fanin<T>::push_back_all(ForwardInputIterator begin,
+                                                   ForwardInputIterator end)
+{
+    return local_lane().buffer.push_back_all(begin, end);
+}
+
+template<typename T>
+bool CircularBuffer_srmw_fanin<T>::try_pop(T& result)
+{
+    size_t count = m_lane_count.load(std::memory_order_acquire);
+    if(count == 0)
+        return false;
+
+    // продолжаем серию из текущей полосы
+    if(m_current < count && m_taken < m_batch
+            && m_lanes[m_current].load(std::memory_order_relaxed)->buffer.try_pop(result)) {
+        ++m_taken;
+        return true;
+    }
+
+    m_taken = 0;
+
+    if(m_order == PollOrder::occupancy) {
+        size_t fullest = count;
+        size_t largest = 0;
+
+        for(size_t i = 0; i < count; ++i) {
+            size_t occupied = m_lanes[i].load(std::memory_order_relaxed)->buffer.size();
+            if(occupied > largest) {
+                largest = occupied;
+                fullest = i;
+            }
+        }
+
+        if(fullest == count)
+            return false;
+
+        m_current = fullest;
+        if(m_lanes[fullest].load(std::memory_order_relaxed)->buffer.try_pop(result)) {
+            ++m_taken;
+            return true;
+        }
+
+        return false;
+    }
+
+    for(size_t i = 1; i <= count; ++i) {
+        size_t index = (m_current + i) % count;
+
+        if(m_lanes[index].load(std::memory_order_relaxed)->buffer.try_pop(result)) {
+            m_current = index;
+            ++m_taken;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+template<typename T>
+template<typename ContainerType>
+size_t CircularBuffer_srmw_fanin<T>::pop_all(ContainerType& container, size_t max_per_lane)
+{
+    size_t count = m_lane_count.load(std::memory_order_acquire);
+
+    std::vector<size_t> order;
+    poll_order(order, count);
+
+    size_t counter{0};
+    T value{};
+
+    for(size_t index : order) {
+        lane_type& lane = m_lanes[index].load(std::memory_order_relaxed)->buffer;
+
+        if(max_per_lane == 0) {
+            counter += lane.pop_all(container);
+            continue;
+        }
+
+        for(size_t n = 0; n < max_per_lane && lane.try_pop(value); ++n) {
+            container.push_back(std::move(value));
+            ++counter;
+        }
+    }
+
+    // следующий опрос начнется на одну полосу дальше
+    if(! order.empty())
+        m_current = order.front();
+    m_taken = 0;
+
+    return counter;
+}
+
+template<typename T>
+typename CircularBuffer_srmw_fanin<T>::lane_state&
+CircularBuffer_srmw_fanin<T>::local_lane()
+{
+    registry& local = registry::local();
+
+    for(auto& e : local.entries)
+        if(e.queue == m_id)
+            return *e.lane;
+
+    // первая запись потока: удаляем записи разрушенных буферов
+    local.entries.erase(std::remove_if(local.entries.begin(), local.entries.end(),
+                                       [](const typename registry::entry& e) {
+                                           return e.lane->closed.load(std::memory_order_relaxed);
+                                       }),
+                        local.entries.end());
+
+    std::shared_ptr<lane_state> lane = acquire_lane();
+    local.entries.push_back(typename registry::entry{m_id, lane});
+
+    return *lane;
+}
+
+template<typename T>
+std::shared_ptr<typename CircularBuffer_srmw_fanin<T>::lane_state>
+CircularBuffer_srmw_fanin<T>::acquire_lane()
+{
+    std::lock_guard<std::mutex> locker(m_mutex);
+
+    // полоса завершившегося потока: его записи видны после acquire
+    for(auto& lane : m_owners) {
+        bool expected = false;
+        if(lane->owned.compare_exchange_strong(expected, true, std::memory_order_acquire))
+            return lane;
+    }
+
+    if(m_owners.size() == m_max_lanes)
+        throw std::length_error("CircularBuffer_srmw_fanin: no free producer lane");
+
+    m_owners.push_back(std::make_shared<lane_state>(m_lane_size));
+
+    size_t index = m_owners.size() - 1;
+    m_lanes[index].store(m_owners.back().get(), std::memory_order_relaxed);
+    m_lane_count.store(index + 1, std::memory_order_release);
+
+    return m_owners.back();
+}
+
+template<typename T>
+void CircularBuffer_srmw_fanin<T>::poll_order(std::vector<size_t>& order, size_t count) const
+{
+    order.clear();
+    order.reserve(count);
+
+    for(size_t i = 1; i <= count; ++i)
+        order.push_back((m_current + i) % count);
+
+    if(m_order == PollOrder::occupancy) {
+        std::vector<size_t> occupied(count);
+        for(size_t i = 0; i < count; ++i)
+            occupied[i] = m_lanes[i].load(std::memory_order_relaxed)->buffer.size();
+
+        std::stable_sort(order.begin(), order.end(), [&occupied](size_t a, size_t b) {
+            return occupied[a] > occupied[b];
+        });
+    }
+}
+
+}
+#endif // CIRCULAR_BUFFER_FANIN_SRMW_H
@@ -1,15 +1,94 @@
 #ifndef CIRCULAR_BUFFER_FWD_H
 #define CIRCULAR_BUFFER_FWD_H
 
+#include <cstddef>
+#include <functional>
+#include <memory>
+
 namespace connest {
+struct single_producer;
+struct multi_producer;
+struct single_consumer;
+struct multi_consumer;
+
+struct spin_wait;
+struct park_wait;
+struct block_wait;
+struct coro_wait;
+
+struct no_stats;
+struct count_stats;
+
+template <typename Clock>
+struct dwell_stats;
+
+template <typename T, typename Allocator = std::allocator<T>>
+class vector_storage;
+
+template <typename T, std::size_t N>
+class inline_storage;
+
 template <typename T>
-class CircularBuffer_srsw;
+class mmap_storage;
+
+template <typename T,
+          typename ProducerPolicy,
+          typename ConsumerPolicy,
+          typename WaitPolicy    = spin_wait,
+          typename StoragePolicy = vector_storage<T>,
+          typename StatsPolicy   = no_stats>
+class basic_circular_buffer;
+
+template <typename T, typename Allocator = std::allocator<T>>
+using CircularBuffer_srsw = basic_circular_buffer<T,
+                                                  single_producer,
+                                                  single_consumer,
+                                                  spin_wait,
+                                                  vector_storage<T, Allocator>>;
+
+template <typename T, typename Allocator = std::allocator<T>>
+using CircularBuffer_mrmw = basic_circular_buffer<T,
+                                                  multi_producer,
+                                                  multi_consumer,
+                                                  spin_wait,
+                                                  vector_storage<T, Allocator>>;
+
+template <typename T, typename Allocator = std::allocator<T>>
+using CircularBuffer_mrmw_blocked = basic_circular_buffer<T,
+                                                          multi_producer,
+                                                          multi_consumer,
+                                                          block_wait,
+                                                          vector_storage<T, Allocator>>;
+
+template <typename T, typename Allocator = std::allocator<T>>
+class CircularBuffer_mrmw_twolock;
+
+template <typename T, typename Allocator = std::allocator<T>>
+class CircularBuffer_mrmw_combining;
 
 template <typename T>
-class CircularBuffer_mrmw;
+class CircularBuffer_mrmw_sharded;
+
+template <typename T,
+          typename Key,
+          typename Hash        = std::hash<Key>,
+          typename StatsPolicy = no_stats>
+class CircularBuffer_mrmw_partitioned;
+
+template <typename T>
+class CircularBuffer_srmw_fanin;
+
+template <typename Buffer>
+class producer_token;
+
+template <typename Buffer>
+class consumer_token;
+
+template <typename Buffer>
+class staging_buffer;
 
 template <typename T>
-class CircularBuffer_mrmw_blocked;
+class WorkStealingDeque;
 }
 
 #endif // CIRCULAR_BUFFER_FWD_H
@@ -0,0 +1,337 @@
+#ifndef CIRCULAR_BUFFER_MMAP_H
+#define CIRCULAR_BUFFER_MMAP_H
+
+#include <new>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#include <fstream>
+#include <string>
+#define CIRCULAR_BUFFER_HAS_MMAP 1
+#endif
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <vector>
+#endif
+
+namespace connest {
+
+using std::size_t;
+
+/**
+ * @brief Использование больших страниц для отображения памяти
+ */
+enum class huge_pages
+{
+    none,           ///< обычные страницы
+    transparent,    ///< transparent huge pages (madvise(MADV_HUGEPAGE))
+    hugetlb         ///< MAP_HUGETLB, при неудаче - transparent
+};
+
+/**
+ * @brief Параметры выделения памяти через mmap
+ */
+struct mmap_options
+{
+    huge_pages pages = huge_pages::none;
+    bool prefault    = false;   // обратиться к каждой странице при выделении
+    bool lock        = false;   // mlock: страницы не вытесняются в swap
+    int numa_node    = -1;      // узел NUMA для страниц (mbind), -1 - не привязывать
+};
+
+/**
+ * @brief Чем в итоге обеспечена память
+ */
+enum class page_backing
+{
+    heap,               ///< mmap недоступен или завершился ошибкой: operator new
+    regular,            ///< обычные страницы
+    transparent_huge,   ///< обычное отображение с madvise(MADV_HUGEPAGE)
+    huge_tlb            ///< MAP_HUGETLB
+};
+
+/**
+ * @brief Отчет о выделенной памяти
+ */
+struct mapping_info
+{
+    page_backing backing = page_backing::heap;
+    bool prefaulted      = false;
+    bool locked          = false;   // false, если mlock не удался (RLIMIT_MEMLOCK)
+    bool numa_bound      = false;   // false, если mbind не удался (нет узла)
+    size_t bytes         = 0;       // размер отображения (с округлением)
+};
+
+
+namespace detail {
+
+// размер большой страницы x86-64 / aarch64 (4K гранула) по умолчанию
+enum : size_t { huge_page_size = 2 * 1024 * 1024 };
+
+inline size_t round_up(size_t value, size_t alignment) noexcept
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * @brief   Привязать страницы к узлу NUMA (mbind, MPOL_BIND).
+ *          Вызывается до первого обращения к страницам
+ * @return  false, если узла нет или mbind недоступен
+ */
+inline bool bind_to_node(void* memory, size_t bytes, int node)
+{
+#if defined(__linux__) && defined(SYS_mbind)
+    if(node < 0)
+        return false;
+
+    // значения из <numaif.h>: libnuma не требуется
+    const int mpol_bind    = 2;
+    const int mpol_mf_move = 1 << 1;
+    const size_t bits      = sizeof(unsigned long) * 8;
+
+    std::vector<unsigned long> mask(static_cast<size_t>(node) / bits + 1, 0);
+    mask[static_cast<size_t>(node) / bits] |= 1ul << (static_cast<size_t>(node) % bits);
+
+    return syscall(SYS_mbind, memory, bytes, mpol_bind,
+                   mask.data(), mask.size() * bits + 1, mpol_mf_move) == 0;
+#else
+    (void)memory;
+    (void)bytes;
+    (void)node;
+    return false;
+#endif
+}
+
+#ifdef CIRCULAR_BUFFER_HAS_MMAP
+
+inline size_t page_size() noexcept
+{
+    static const size_t value = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return value;
+}
+
+/**
+ * @brief Отключены ли transparent huge pages в системе ("[never]")
+ */
+inline bool transparent_huge_pages_disabled()
+{
+    static const bool value = []() {
+        std::ifstream file("/sys/kernel/mm/transparent_hugepage/enabled");
+        std::string line;
+        return ! std::getline(file, line)
+            || line.find("[never]") != std::string::npos;
+    }();
+    return value;
+}
+
+/**
+ * @brief Размер отображения: зависит только от параметров, а не от
+ *        выбранного пути, чтобы munmap получил ту же длину
+ */
+inline size_t mapping_size(size_t bytes, const mmap_options& options) noexcept
+{
+    return round_up(bytes, options.pages == huge_pages::none ? page_size()
+                                                             : size_t(huge_page_size));
+}
+
+/**
+ * @brief Анонимное отображение, выровненное по alignment
+ */
+inline void* map_aligned(size_t size, size_t alignment) noexcept
+{
+    void* memory = mmap(nullptr, size + alignment, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(memory == MAP_FAILED)
+        return nullptr;
+
+    uintptr_t begin   = reinterpret_cast<uintptr_t>(memory);
+    uintptr_t aligned = round_up(begin, alignment);
+
+    // лишнее до и после выровненного участка возвращается системе
+    if(aligned != begin)
+        munmap(memory, aligned - begin);
+    munmap(reinterpret_cast<void*>(aligned + size), alignment - (aligned - begin));
+
+    return reinterpret_cast<void*>(aligned);
+}
+
+/**
+ * @brief Выделить память согласно options
+ * @param bytes   требуемый размер
+ * @param options параметры
+ * @param info    отчет о выбранном пути
+ * @return память или nullptr, если mmap не удался
+ */
+inline void* map_pages(size_t bytes, const mmap_options& options, mapping_info& info)
+{
+    info = mapping_info();
+
+    size_t size  = mapping_size(bytes, options);
+    void* memory = nullptr;
+
+#ifdef MAP_HUGETLB
+    if(options.pages == huge_pages::hugetlb) {
+        memory = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if(memory == MAP_FAILED)
+            memory = nullptr;   // нет зарезервированных страниц
+        else
+            info.backing = page_backing::huge_tlb;
+    }
+#endif
+
+    if(! memory && options.pages != huge_pages::none) {
+        memory = map_aligned(size, huge_page_size);
+        if(memory) {
+            info.backing = page_backing::regular;
+#ifdef MADV_HUGEPAGE
+            if(! transparent_huge_pages_disabled()
+                    && madvise(memory, size, MADV_HUGEPAGE) == 0)
+                info.backing = page_backing::transparent_huge;
+#endif
+        }
+    }
+
+    if(! memory && options.pages == huge_pages::none) {
+        memory = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(memory == MAP_FAILED)
+            memory = nullptr;
+        else
+            info.backing = page_backing::regular;
+    }
+
+    if(! memory)
+        return nullptr;
+
+    info.bytes = size;
+
+    if(options.numa_node >= 0)
+        info.numa_bound = bind_to_node(memory, size, options.numa_node);
+
+    if(options.prefault) {
+        // запись, а не чтение: чтение отобразило бы общую нулевую страницу
+        volatile char* page = static_cast<char*>(memory);
+        for(size_t offset = 0; offset < size; offset += page_size())
+            page[offset] = 0;
+        info.prefaulted = true;
+    }
+
+    if(options.lock)
+        info.locked = mlock(memory, size) == 0;
+
+    return memory;
+}
+
+inline void unmap_pages(void* memory, size_t bytes, const mmap_options& options) noexcept
+{
+    // munmap снимает и mlock
+    munmap(memory, mapping_size(bytes, options));
+}
+
+#else
+
+inline void* map_pages(size_t bytes, const mmap_options&, mapping_info& info)
+{
+    info = mapping_info();
+    info.bytes = bytes;
+    return ::operator new(bytes);
+}
+
+inline void unmap_pages(void* memory, size_t, const mmap_options&) noexcept
+{
+    ::operator delete(memory);
+}
+
+#endif
+
+}
+
+
+/**
+  @brief    Аллокатор, выделяющий каждый блок отдельным отображением mmap
+  @details
+        Параметры (большие страницы, предварительное обращение к
+        страницам, mlock, узел NUMA) сохраняются в копиях аллокатора, поэтому
+        новое хранилище при resize получает те же параметры.
+        Подходит для vector_storage; mmap_storage дополнительно
+        сообщает выбранный путь (mapping_info).
+ */
+template<typename T>
+class mmap_allocator
+{
+    mmap_options m_options;
+
+public:
+    using value_type = T;
+
+    explicit mmap_allocator(const mmap_options& options = mmap_options()) noexcept
+        : m_options(options)
+    {}
+
+    template<typename U>
+    mmap_allocator(const mmap_allocator<U>& other) noexcept
+        : m_options(other.options())
+    {}
+
+    const mmap_options& options() const noexcept
+    {
+        return m_options;
+    }
+
+    T* allocate(size_t n)
+    {
+        mapping_info info;
+        void* memory = map(n * sizeof(T), info);
+        if(! memory)
+            throw std::bad_alloc();
+
+        return static_cast<T*>(memory);
+    }
+
+    void deallocate(T* memory, size_t n) noexcept
+    {
+        unmap(memory, n * sizeof(T));
+    }
+
+    /**
+     * @brief Выделить память с отчетом о выбранном пути
+     * @param bytes размер
+     * @param info  отчет
+     * @return память или nullptr
+     */
+    void* map(size_t bytes, mapping_info& info) const
+    {
+        return detail::map_pages(bytes, m_options, info);
+    }
+
+    /**
+     * @brief Освободить память, полученную map
+     */
+    void unmap(void* memory, size_t bytes) const noexcept
+    {
+        detail::unmap_pages(memory, bytes, m_options);
+    }
+
+    template<typename U>
+    bool operator==(const mmap_allocator<U>& other) const noexcept
+    {
+        // длина munmap зависит только от того, используются ли
+        // большие страницы
+        return (m_options.pages == huge_pages::none)
+            == (other.options().pages == huge_pages::none);
+    }
+
+    template<typename U>
+    bool operator!=(const mmap_allocator<U>& other) const noexcept
+    {
+        return ! (*this == other);
+    }
+};
+
+}
+#endif // CIRCULAR_BUFFER_MMAP_H
@@ -0,0 +1,216 @@
+#ifndef CIRCULAR_BUFFER_NUMA_H
+#define CIRCULAR_BUFFER_NUMA_H
+
+#include <new>
+#include <memory>
+#include <utility>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include "circular_buffer_mmap.h"
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace connest {
+namespace numa {
+
+using std::size_t;
+
+/**
+ * @brief Количество узлов NUMA (по /sys/devices/system/node/online)
+ * @return количество узлов, 1 - если сведений нет
+ */
+inline size_t node_count()
+{
+    static const size_t value = []() -> size_t {
+        // формат: "0", "0-1", "0,2-3"
+        std::ifstream file("/sys/devices/system/node/online");
+        std::string line;
+        if(! std::getline(file, line) || line.empty())
+            return 1;
+
+        size_t last = line.find_last_of(",-");
+        std::string tail = last == std::string::npos ? line : line.substr(last + 1);
+        try {
+            return static_cast<size_t>(std::stoul(tail)) + 1;
+        }
+        catch(...) {
+            return 1;
+        }
+    }();
+    return value;
+}
+
+namespace detail {
+
+inline int& node_override() noexcept
+{
+    static thread_local int value = -1;
+    return value;
+}
+
+/**
+ * @brief   Прочитать узлы процессоров (по /sys/devices/system/node/nodeN/cpulist)
+ * @return  узел по номеру процессора; пустая таблица - сведений нет
+ */
+inline std::vector<int> read_cpu_nodes()
+{
+    std::vector<int> result;
+
+    for(size_t node = 0; node < node_count(); ++node) {
+        // формат: "0-3,8-11"
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string list;
+        if(! std::getline(file, list))
+            continue;
+
+        std::istringstream ranges(list);
+        std::string range;
+        while(std::getline(ranges, range, ',')) {
+            try {
+                size_t dash = range.find('-');
+                size_t first = std::stoul(range.substr(0, dash));
+                size_t last  = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+
+                if(result.size() <= last)
+                    result.resize(last + 1, 0);
+                for(size_t cpu = first; cpu <= last; ++cpu)
+                    result[cpu] = static_cast<int>(node);
+            }
+            catch(...) {
+            }
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief   Узлы процессоров, таблица строится один раз.
+ *          Не бросает исключений: при нехватке памяти таблица пустая
+ *          (узел не определяется по процессору)
+ * @return  узел по номеру процессора; пустая таблица - сведений нет
+ */
+inline const std::vector<int>& cpu_nodes() noexcept
+{
+    static const std::vector<int> table = []() noexcept -> std::vector<int> {
+        try {
+            return read_cpu_nodes();
+        }
+        catch(...) {
+            return std::vector<int>{};
+        }
+    }();
+    return table;
+}
+
+}
+
+/**
+ * @brief   Назначить потоку узел NUMA вместо определенного по процессору.
+ *          Для потоков, закрепленных за узлом, и для имитации нескольких
+ *          узлов на одноузловой машине; -1 - отменить назначение
+ * @param node узел
+ */
+inline void set_current_node(int node) noexcept
+{
+    detail::node_override() = node;
+}
+
+/**
+ * @brief Узел NUMA текущего потока
+ * @return назначенный узел или узел процессора, на котором выполняется поток
+ */
+inline int current_node() noexcept
+{
+    int node = detail::node_override();
+    if(node >= 0)
+        return node;
+
+#if defined(__linux__)
+    // sched_getcpu - без входа в ядро (vDSO / rseq), узел - по таблице
+    static const std::vector<int>& nodes = detail::cpu_nodes();
+
+    int cpu = sched_getcpu();
+    if(cpu >= 0 && static_cast<size_t>(cpu) < nodes.size())
+        return nodes[static_cast<size_t>(cpu)];
+#endif
+    return 0;
+}
+
+
+/**
+ * @brief Освобождает объект, созданный make_on_node
+ */
+struct node_deleter
+{
+    size_t bytes = 0;   // 0 - объект создан operator new
+
+    template<typename T>
+    void operator()(T* object) const noexcept
+    {
+        object->~T();
+#ifdef CIRCULAR_BUFFER_HAS_MMAP
+        if(bytes != 0) {
+            munmap(object, bytes);
+            return;
+        }
+#endif
+        ::operator delete(object);
+    }
+};
+
+template<typename T>
+using node_ptr = std::unique_ptr<T, node_deleter>;
+
+/**
+  @brief    Создать объект в памяти узла NUMA
+  @details
+        Объект (для буфера - индексы и состояние ожидания) размещается
+        в отдельных страницах, привязанных к узлу mbind. Ячейки буфера
+        привязываются отдельно: mmap_options::numa_node аллокатора.
+        Если mmap недоступен, объект создается operator new без привязки.
+  @param node узел NUMA
+  @param args аргументы конструктора
+  @return владеющий указатель
+ */
+template<typename T, typename ... Args>
+node_ptr<T> make_on_node(int node, Args&& ... args)
+{
+    node_deleter deleter;
+    void* memory = nullptr;
+
+#ifdef CIRCULAR_BUFFER_HAS_MMAP
+    deleter.bytes = connest::detail::round_up(sizeof(T), connest::detail::page_size());
+    memory = mmap(nullptr, deleter.bytes, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(memory == MAP_FAILED)
+        throw std::bad_alloc();
+
+    connest::detail::bind_to_node(memory, deleter.bytes, node);
+#else
+    (void)node;
+    memory = ::operator new(sizeof(T));
+#endif
+
+    try {
+        return node_ptr<T>(new (memory) T(std::forward<Args>(args) ...), deleter);
+    }
+    catch(...) {
+#ifdef CIRCULAR_BUFFER_HAS_MMAP
+        munmap(memory, deleter.bytes);
+#else
+        ::operator delete(memory);
+#endif
+        throw;
+    }
+}
+
+}
+}
+#endif // CIRCULAR_BUFFER_NUMA_H
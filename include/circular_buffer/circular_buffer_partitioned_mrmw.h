@@ -0,0 +1,479 @@
+#ifndef CIRCULAR_BUFFER_PARTITIONED_MRMW_H
+#define CIRCULAR_BUFFER_PARTITIONED_MRMW_H
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "circular_buffer_fwd.h"
+#include "circular_buffer_basic.h"
+#include "circular_buffer_stats.h"
+
+namespace connest {
+
+/**
+ * @brief Снимок состояния раздела (см. CircularBuffer_mrmw_partitioned::stats())
+ */
+struct partition_stats
+{
+    size_t occupancy = 0;       // элементов в разделе
+    size_t capacity  = 0;       // вместимость раздела
+    size_t consumer  = 0;       // назначенный читатель (после передачи)
+    bool   moving    = false;   // передача назначенному читателю еще не выполнена
+    buffer_stats counters;      // счетчики кольца (при StatsPolicy = no_stats нулевые)
+};
+
+/**
+ * @brief   Назначение разделов для rebalance() по умолчанию: пока это
+ *          уменьшает разницу, самый заполненный подходящий раздел самого
+ *          нагруженного читателя передается наименее нагруженному
+ *          (нагрузка - сумма заполненности разделов)
+ * @param partitions состояние разделов
+ * @param consumers  количество читателей
+ * @return читатель для каждого раздела
+ */
+inline std::vector<size_t> balance_by_occupancy(const std::vector<partition_stats>& partitions,
+                                                size_t consumers)
+{
+    std::vector<size_t> owners(partitions.size());
+    std::vector<size_t> load(consumers, 0);
+
+    for(size_t p = 0; p < partitions.size(); ++p) {
+        owners[p] = partitions[p].consumer;
+        if(owners[p] < consumers)
+            load[owners[p]] += partitions[p].occupancy;
+    }
+
+    for(size_t step = 0; step < partitions.size(); ++step) {
+        size_t busiest = 0, idlest = 0;
+        for(size_t c = 1; c < consumers; ++c) {
+            if(load[c] > load[busiest])
+                busiest = c;
+            if(load[c] < load[idlest])
+                idlest = c;
+        }
+
+        size_t gap = load[busiest] - load[idlest];
+
+        // раздел, перенос которого сокращает разницу
+        size_t hottest = partitions.size();
+        for(size_t p = 0; p < partitions.size(); ++p)
+            if(owners[p] == busiest
+                    && partitions[p].occupancy > 0
+                    && partitions[p].occupancy < gap
+                    && (hottest == partitions.size()
+                        || partitions[p].occupancy > partitions[hottest].occupancy))
+                hottest = p;
+
+        if(hottest == partitions.size())
+            break;
+
+        owners[hottest] = idlest;
+        load[busiest] -= partitions[hottest].occupancy;
+        load[idlest]  += partitions[hottest].occupancy;
+    }
+
+    return owners;
+}
+
+/**
+  @brief    Буфер multiple reader - multiple writer, разделенный по ключу
+  @details
+        Элемент добавляется с ключом и попадает в раздел
+        Hash(key) % partitions - отдельное lockfree кольцо (несколько
+        писателей, один читатель). Каждый раздел в каждый момент
+        принадлежит одному читателю, поэтому элементы одного ключа
+        (от одного писателя) извлекаются и обрабатываются в порядке
+        добавления, а пропускная способность растет с числом разделов
+        и читателей.
+
+        Читатель обращается к буферу со своим номером (0 - consumers-1)
+        и получает элементы только своих разделов. Разделов можно
+        создать больше, чем читателей, и перераспределять их: assign()
+        и rebalance() только назначают раздел новому читателю, а
+        передает его текущий владелец при следующем своем вызове
+        try_pop / pop_all - то есть после обработки уже полученных
+        элементов. Поэтому читатель, владеющий разделами, должен
+        продолжать опрос.
+
+        Hash - std::hash<Key> или свой функтор; StatsPolicy колец -
+        no_stats / count_stats (счетчики в stats()).
+ */
+template <typename T, typename Key, typename Hash, typename StatsPolicy>
+class CircularBuffer_mrmw_partitioned final
+{
+public:
+    using ring_type = basic_circular_buffer<T,
+                                            multi_producer,
+                                            single_consumer,
+                                            spin_wait,
+                                            vector_storage<T>,
+                                            StatsPolicy>;
+
+private:
+    struct partition
+    {
+        ring_type ring;
+
+        // owner меняет только текущий владелец, next_owner - assign()
+        alignas(64) std::atomic<size_t> owner;
+        std::atomic<size_t> next_owner;
+
+        partition(size_t size, size_t consumer)
+            : ring(size)
+            , owner{consumer}
+            , next_owner{consumer}
+        {}
+    };
+
+    // позиция опроса читателя (изменяет только сам читатель)
+    struct alignas(64) cursor
+    {
+        size_t next = 0;
+    };
+
+    std::deque<partition> m_partitions;
+    std::vector<cursor> m_cursors;
+    Hash m_hash;
+
+    // rebalance() вызывается из разных потоков
+    std::mutex m_rebalance_mutex;
+
+public:
+    /**
+     * @param partition_size максимальное количество элементов в разделе
+     * @param partitions     количество разделов
+     * @param consumers      количество читателей (раздел p изначально
+     *                       принадлежит читателю p % consumers)
+     * @param hash           функтор хеширования ключа
+     */
+    CircularBuffer_mrmw_partitioned(size_t partition_size,
+                                    size_t partitions,
+                                    size_t consumers,
+                                    const Hash& hash = Hash());
+
+    CircularBuffer_mrmw_partitioned(const CircularBuffer_mrmw_partitioned& other) = delete;
+    CircularBuffer_mrmw_partitioned(CircularBuffer_mrmw_partitioned&& other) = delete;
+    CircularBuffer_mrmw_partitioned& operator=(const CircularBuffer_mrmw_partitioned&) = delete;
+    CircularBuffer_mrmw_partitioned& operator=(CircularBuffer_mrmw_partitioned&&) = delete;
+
+    /**
+     * @brief Получить количество разделов
+     */
+    size_t partition_count() const noexcept;
+
+    /**
+     * @brief Получить количество читателей
+     */
+    size_t consumer_count() const noexcept;
+
+    /**
+     * @brief Получить раздел ключа
+     */
+    size_t partition_of(const Key& key) const;
+
+    /**
+     * @brief   Получить текущего владельца раздела
+     *          (значение может сразу устареть)
+     */
+    size_t owner(size_t partition) const noexcept;
+
+    /**
+     * @brief Получить количество элементов во всех разделах
+     * @return количество элементов (значение может сразу устареть)
+     */
+    size_t size() const noexcept;
+
+    /**
+     * @brief Получить суммарную вместимость разделов
+     */
+    size_t max_size() const noexcept;
+
+    /**
+     * @brief Проверить, пусты ли все разделы
+     */
+    bool empty() const noexcept;
+
+    /**
+     * @brief   Добавить элемент в раздел ключа
+     * @param key   ключ элемента
+     * @param value значение элемента
+     * @return флаг успешности операции (раздел ключа заполнен)
+     */
+    template<typename Type>
+    bool try_push_back(const Key& key, Type&& value);
+
+    /**
+     * @brief   Получить элемент из разделов читателя (по кругу, по
+     *          одному из раздела). Передает назначенные другим читателям
+     *          разделы
+     * @param consumer номер читателя
+     * @param result   место, куда будет записано значение
+     * @return флаг успешности операции (разделы читателя пусты)
+     */
+    bool try_pop(size_t consumer, T& result);
+
+    /**
+     * @brief   Забрать элементы из разделов читателя в контейнер, раздел
+     *          за разделом. Передает назначенные другим читателям разделы
+     * @param consumer      номер читателя
+     * @param container     контейнер назначения
+     * @param max_per_partition не больше стольких элементов из одного
+     *                      раздела (0 - все доступные)
+     * @return количество полученных элементов
+     */
+    template<typename ContainerType>
+    size_t pop_all(size_t consumer, ContainerType& container, size_t max_per_partition = 0);
+
+    /**
+     * @brief   Назначить раздел читателю. Текущий владелец передаст раздел
+     *          при следующем вызове try_pop / pop_all
+     * @param partition номер раздела
+     * @param consumer  номер читателя
+     * @return  false, если partition или consumer вне диапазона
+     *          (назначение не меняется)
+     */
+    bool assign(size_t partition, size_t consumer) noexcept;
+
+    /**
+     * @brief Получить заполненность, назначение и счетчики разделов
+     */
+    std::vector<partition_stats> stats() const;
+
+    /**
+     * @brief   Перераспределить разделы между читателями
+     * @param hook функция std::vector<size_t>(const std::vector<partition_stats>&,
+     *             size_t consumers): новый читатель для каждого раздела
+     * @return количество переназначенных разделов
+     */
+    template<typename Hook>
+    size_t rebalance(Hook&& hook);
+
+    /**
+     * @brief   Перенести горячие разделы с перегруженных читателей
+     *          (balance_by_occupancy)
+     * @return количество переназначенных разделов
+     */
+    size_t rebalance();
+
+private:
+    /**
+     * @brief   Проверить, владеет ли читатель разделом; если раздел
+     *          назначен другому - передать его
+     */
+    bool owns(size_t consumer, partition& part) noexcept;
+};
+
+
+// Implementation
+
+template<typename T, typename Key, typename Hash, typename StatsPolicy>
+CircularBuffer_mrmw_partitioned<T, Key, Hash, StatsPolicy>::
+CircularBuffer_mrmw_partitioned(size_t partition_size,
+                                size_t partitions,
+                                size_t consumers,
+                                const Hash& hash)
+    : m_partitions{}
+    , m_cursors(consumers == 0 ? 1 : consumers)
+    , m_hash(hash)
+    , m_rebalance_mutex{}
+{
+    if(partitions == 0)
+        partitions = 1;
+
+    for(size_t p = 0; p < partitions; ++p)
+        m_partitions.emplace_back(partition_size, p % m_cursors.size());
+}
+
+template<typename T, typename Key, typename Hash, typename StatsPolicy>
+size_t CircularBuffer_mrmw_partitioned<T, Key, Hash, StatsPolicy>::partition_count() const noexcept
+{
+    return m_partitions.size();
+}
+
+template<typename T, typename Key, typename Hash, typename StatsPolicy>
+size_t CircularBuffer_mrmw_partitioned<T, Key, Hash, StatsPolicy>::consumer_count() const noexcept
+{
+    return m_cursors.size();
+}
+
+template<typename T, typename Key, typename Hash, typename StatsPolicy>
+size_t CircularBuffer_mrmw_partitioned<T, Key, Hash, StatsPolicy>::partition_of(const Key& key) const
+{
+    return static_cast<size_t>(m_hash(key)) % m_partitions.size();
+}
+
+template<typename T, typename Key, typename Hash, typename StatsPolicy>
+size_t CircularBuffer_mrmw_partitioned<T, Key, Hash, StatsPolicy>::owner(size_t partition) const noexcept
+{
+    return m_partitions[partition].owner.load(std::memory_order_relaxed);
+}
+
+template<typename T, typename Key, typename Hash, typename StatsPolicy>
+size_t CircularBuffer_mrmw_partitioned<T, Key, Hash, StatsPolicy>::size() const noexcept
+{
+    size_t result = 0;
+    for(const auto& part : m_partitions)
+        result += part.ring.size();
+
+    return result;
+}
+
+template<typename T, typename Key, typename Hash, typename StatsPolicy>
+size_t CircularBuffer_mrmw_partitioned<T, Key, Hash, StatsPolicy>::max_size() const noexcept
+{
+    size_t result = 0;
+    for(const auto& part : m_partitions)
+        result += part.ring.max_size();
+
+    return result;
+}
+
+template<typename T, typename Key, typename Hash, typename StatsPolicy>
+bool CircularBuffer_mrmw_partitioned<T, Key, Hash, StatsPolicy>::empty() const noexcept
+{
+    for(const auto& part : m_partitions)
+        if(! part.ring.empty())
+            return false;
+
+    return true;
+}
+
+template<typename T, typename Key, typename Hash, typename StatsPolicy>
+template<typename Type>
+bool CircularBuffer_mrmw_partitioned<T, Key, Hash, StatsPolicy>::try_push_back(const Key& key, Type&& value)
+{
+    return m_partitions[partition_of(key)].ring.try_push_back(std::forward<Type>(value));
+}
+
+template<typename T, typename Key, typename Hash, typename StatsPolicy>
+bool CircularBuffer_mrmw_partitioned<T, Key, Hash, StatsPolicy>::try_pop(size_t consumer, T& result)
+{
+    size_t count = m_partitions.size();
+    size_t& next = m_cursors[consumer].next;
+
+    for(size_t i = 0; i < count; ++i) {
+        size_t index = (next + i) % count;
+        partition& part = m_partitions[index];
+
+        if(owns(consumer, part) && part.ring.try_pop(result)) {
+            next = index + 1;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+template<typename T, typename Key, typename Hash, typename StatsPolicy>
+template<typename ContainerType>
+size_t CircularBuffer_mrmw_partitioned<T, Key, Hash, StatsPolicy>::pop_all(size_t consumer,
+                                                                           ContainerType& container,
+                                                                           size_t max_per_partition)
+{
+    size_t count = m_partitions.size();
+    size_t& next = m_cursors[consumer].next;
+
+    size_t counter{0};
+    T value{};
+
+    for(size_t i = 0; i < count; ++i) {
+        partition& part = m_partitions[(next + i) % count];
+        if(! owns(consumer, part))
+            continue;
+
+        if(max_per_partition == 0) {
+            counter += part.ring.pop_all(container);
+            continue;
+        }
+
+        for(size_t n = 0; n < max_per_partition && part.ring.try_pop(value); ++n) {
+            container.push_back(std::move(value));
+            ++counter;
+        }
+    }
+
+    // следующий опрос начнется на один раздел дальше
+    next = (next + 1) % count;
+
+    return counter;
+}
+
+template<typename T, typename Key, typename Hash, typename StatsPolicy>
+bool CircularBuffer_mrmw_partitioned<T, Key, Hash, StatsPolicy>::assign(size_t partition, size_t consumer) noexcept
+{
+    // раздел читателя вне диапазона больше никто не опросил бы
+    if(partition >= m_partitions.size() || consumer >= m_cursors.size())
+        return false;
+
+    m_partitions[partition].next_owner.store(consumer, std::memory_order_relaxed);
+    return true;
+}
+
+template<typename T, typename Key, typename Hash, typename StatsPolicy>
+std::vector<partition_stats> CircularBuffer_mrmw_partitioned<T, Key, Hash, StatsPolicy>::stats() const
+{
+    std::vector<partition_stats> result(m_partitions.size());
+
+    for(size_t p = 0; p < m_partitions.size(); ++p) {
+        const partition& part = m_partitions[p];
+
+        result[p].occupancy = part.ring.size();
+        result[p].capacity  = part.ring.max_size();
+        result[p].consumer  = part.next_owner.load(std::memory_order_relaxed);
+        result[p].moving    = result[p].consumer != part.owner.load(std::memory_order_relaxed);
+        result[p].counters  = part.ring.stats();
+    }
+
+    return result;
+}
+
+template<typename T, typename Key, typename Hash, typename StatsPolicy>
+template<typename Hook>
+size_t CircularBuffer_mrmw_partitioned<T, Key, Hash, StatsPolicy>::rebalance(Hook&& hook)
+{
+    std::lock_guard<std::mutex> locker(m_rebalance_mutex);
+
+    std::vector<partition_stats> current = stats();
+    std::vector<size_t> owners = hook(static_cast<const std::vector<partition_stats>&>(current),
+                                      m_cursors.size());
+
+    size_t moved{0};
+
+    for(size_t p = 0; p < owners.size() && p < m_partitions.size(); ++p) {
+        if(owners[p] >= m_cursors.size() || owners[p] == current[p].consumer)
+            continue;
+
+        assign(p, owners[p]);
+        ++moved;
+    }
+
+    return moved;
+}
+
+template<typename T, typename Key, typename Hash, typename StatsPolicy>
+size_t CircularBuffer_mrmw_partitioned<T, Key, Hash, StatsPolicy>::rebalance()
+{
+    return rebalance(balance_by_occupancy);
+}
+
+template<typename T, typename Key, typename Hash, typename StatsPolicy>
+bool CircularBuffer_mrmw_partitioned<T, Key, Hash, StatsPolicy>::owns(size_t consumer, partition& part) noexcept
+{
+    // acquire: извлечения предыдущего владельца видны новому
+    if(part.owner.load(std::memory_order_acquire) != consumer)
+        return false;
+
+    size_t target = part.next_owner.load(std::memory_order_relaxed);
+    if(target == consumer)
+        return true;
+
+    part.owner.store(target, std::memory_order_release);
+    return false;
+}
+
+}
+#endif // CIRCULAR_BUFFER_PARTITIONED_MRMW_H
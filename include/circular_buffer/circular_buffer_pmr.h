@@ -0,0 +1,68 @@
+#ifndef CIRCULAR_BUFFER_PMR_H
+#define CIRCULAR_BUFFER_PMR_H
+
+#include "circular_buffer_fwd.h"
+#include "circular_buffer_basic.h"
+#include "circular_buffer_blocked_mrmw.h"
+#include "circular_buffer_twolock_mrmw.h"
+#include "circular_buffer_combining_mrmw.h"
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define CIRCULAR_BUFFER_HAS_PMR 1
+#endif
+#endif
+
+#ifdef CIRCULAR_BUFFER_HAS_PMR
+
+namespace connest {
+namespace pmr {
+
+/*
+    Буферы, ячейки которых выделяются из std::pmr::memory_resource
+    (арена, monotonic_buffer_resource и т.п.):
+
+        std::pmr::monotonic_buffer_resource arena(...);
+        connest::pmr::CircularBuffer_mrmw<int> cb(1024, &arena);
+
+    Ресурс должен жить дольше буфера.
+ */
+
+template <typename T>
+using CircularBuffer_srsw
+    = connest::CircularBuffer_srsw<T, std::pmr::polymorphic_allocator<T>>;
+
+template <typename T>
+using CircularBuffer_mrmw
+    = connest::CircularBuffer_mrmw<T, std::pmr::polymorphic_allocator<T>>;
+
+template <typename T>
+using CircularBuffer_mrmw_blocked
+    = connest::CircularBuffer_mrmw_blocked<T, std::pmr::polymorphic_allocator<T>>;
+
+template <typename T>
+using CircularBuffer_mrmw_twolock
+    = connest::CircularBuffer_mrmw_twolock<T, std::pmr::polymorphic_allocator<T>>;
+
+template <typename T>
+using CircularBuffer_mrmw_combining
+    = connest::CircularBuffer_mrmw_combining<T, std::pmr::polymorphic_allocator<T>>;
+
+template <typename T,
+          typename ProducerPolicy,
+          typename ConsumerPolicy,
+          typename WaitPolicy = spin_wait>
+using basic_circular_buffer
+    = connest::basic_circular_buffer<T,
+                                     ProducerPolicy,
+                                     ConsumerPolicy,
+                                     WaitPolicy,
+                                     vector_storage<T, std::pmr::polymorphic_allocator<T>>>;
+
+}
+}
+
+#endif // CIRCULAR_BUFFER_HAS_PMR
+
+#endif // CIRCULAR_BUFFER_PMR_H
@@ -0,0 +1,419 @@
+#ifndef CIRCULAR_BUFFER_POLICIES_H
+#define CIRCULAR_BUFFER_POLICIES_H
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <thread>
+#include <cstddef>
+
+#include "circular_buffer_fwd.h"
+#include "circular_buffer_spin.h"
+#include "circular_buffer_wait_status.h"
+
+namespace connest {
+
+using std::size_t;
+
+// Политики сторон буфера: сколько потоков пишут / читают одновременно
+
+/**
+ * @brief Буфер заполняет единственный поток
+ */
+struct single_producer
+{
+    static constexpr bool multi = false;
+};
+
+/**
+ * @brief Буфер заполняют несколько потоков
+ */
+struct multi_producer
+{
+    static constexpr bool multi = true;
+};
+
+/**
+ * @brief Буфер читает единственный поток
+ */
+struct single_consumer
+{
+    static constexpr bool multi = false;
+};
+
+/**
+ * @brief Буфер читают несколько потоков
+ */
+struct multi_consumer
+{
+    static constexpr bool multi = true;
+};
+
+
+// Политики ожидания для push_back_wait / pop_wait
+
+/**
+ * @brief Активное ожидание (pause, затем yield) без засыпания потока
+ */
+struct spin_wait {};
+
+/**
+ * @brief   Короткое активное ожидание, затем сон на условной переменной.
+ *          Противоположная сторона захватывает мьютекс только при
+ *          наличии спящих потоков
+ */
+struct park_wait {};
+
+/**
+ * @brief   Все операции под одним мьютексом (CircularBuffer_mrmw_blocked).
+ *          Политики сторон на алгоритм не влияют
+ */
+struct block_wait {};
+
+/**
+ * @brief   Сопрограммы ждут в co_await push / pop, возобновляются
+ *          противоположной операцией; потоки - активно, как spin_wait.
+ *          Требует C++20 (см. circular_buffer_coro.h)
+ */
+struct coro_wait {};
+
+
+namespace detail {
+
+/**
+  @brief    Индексы одной стороны кольцевого буфера
+  @details
+        Для нескольких потоков сторона хранит две позиции:
+        claim    - захваченная позиция (W или R),
+        complete - позиция, до которой операции завершены (W' или R').
+        Захват выполняется CAS по claim, завершение - продвижением
+        complete строго по порядку захвата.
+
+        Для единственного потока claim == complete, поэтому хранится
+        одна атомарная переменная и CAS не нужен.
+
+        Порядок памяти. Данные ячеек передаются между сторонами только
+        через complete: publish - release (запись / извлечение элемента
+        происходит раньше), а противоположная сторона читает complete
+        с acquire в условии blocked перед захватом. Завершения одной
+        стороны - цепочка CAS по complete (release sequence), поэтому
+        acquire последнего значения видит операции всех предыдущих
+        позиций. claim упорядочивает только потоки одной стороны между
+        собой и ни с какими данными не связан - его загрузки и CAS
+        relaxed. Загрузка собственной позиции единственным потоком -
+        relaxed.
+ */
+template<bool Multi>
+class ring_side;
+
+template<>
+class ring_side<false> final
+{
+    std::atomic<size_t> m_position;
+
+public:
+    ring_side() noexcept
+        : m_position{0}
+    {}
+
+    /**
+     * @brief Позиция, до которой операции завершены
+     */
+    size_t complete(std::memory_order order) const noexcept
+    {
+        return m_position.load(order);
+    }
+
+    /**
+     * @brief Захваченная позиция
+     */
+    size_t claimed(std::memory_order order) const noexcept
+    {
+        return m_position.load(order);
+    }
+
+    /**
+     * @brief Захватить очередную позицию
+     * @param position захваченная позиция
+     * @param blocked  условие невозможности захвата (пуст / заполнен)
+     * @param next     функция получения следующей позиции
+     * @param retry    вызывается при каждом повторе CAS
+     * @return флаг успешности захвата
+     */
+    template<typename Blocked, typename Next, typename Retry>
+    bool claim(size_t& position, Blocked blocked, Next, Retry) noexcept
+    {
+        // позицию изменяет только этот поток
+        position = m_position.load(std::memory_order_relaxed);
+        return ! blocked(position);
+    }
+
+    /**
+     * @brief Завершить операцию над захваченной позицией
+     * @param position захваченная позиция
+     * @param next     следующая позиция
+     */
+    void publish(size_t, size_t next) noexcept
+    {
+        m_position.store(next, std::memory_order_release);
+    }
+
+    /**
+     * @brief Переставить обе позиции (только при отсутствии операций)
+     */
+    void reset(size_t position) noexcept
+    {
+        m_position.store(position, std::memory_order_release);
+    }
+};
+
+template<>
+class ring_side<true> final
+{
+    std::atomic<size_t> m_claim;
+    std::atomic<size_t> m_complete;
+
+public:
+    ring_side() noexcept
+        : m_claim{0}
+        , m_complete{0}
+    {}
+
+    size_t complete(std::memory_order order) const noexcept
+    {
+        return m_complete.load(order);
+    }
+
+    size_t claimed(std::memory_order order) const noexcept
+    {
+        return m_claim.load(order);
+    }
+
+    template<typename Blocked, typename Next, typename Retry>
+    bool claim(size_t& position, Blocked blocked, Next next, Retry retry) noexcept
+    {
+        // видимость ячейки обеспечивает acquire в blocked, а не claim
+        position = m_claim.load(std::memory_order_relaxed);
+
+        while(true) {
+            if(blocked(position))
+                return false;
+
+            // при неудаче position получает текущее значение
+            if(m_claim.compare_exchange_weak(position,
+                                             next(position),
+                                             std::memory_order_relaxed,
+                                             std::memory_order_relaxed))
+                return true;
+
+            retry();
+        }
+    }
+
+    void publish(size_t position, size_t next) noexcept
+    {
+        size_t expected = position;
+
+        // ждем, пока завершатся операции, захватившие позиции раньше;
+        // если предшественник вытеснен (потоков больше, чем ядер),
+        // уступаем ему процессор
+        for(uint32_t i = 0;
+            ! m_complete.compare_exchange_weak(expected,
+                                               next,
+                                               std::memory_order_release,
+                                               std::memory_order_relaxed);
+            ++i) {
+            expected = position;
+
+            if(i < 64)
+                cpu_relax();
+            else
+                std::this_thread::yield();
+        }
+    }
+
+    void reset(size_t position) noexcept
+    {
+        m_claim.store(position, std::memory_order_relaxed);
+        m_complete.store(position, std::memory_order_release);
+    }
+};
+
+
+/**
+  @brief    Состояние ожидания для политики WaitPolicy
+  @details
+        wait_readable / wait_writable возвращают success, когда условие
+        ready() выполнилось (операцию нужно повторить: её мог опередить
+        другой поток), timeout - по истечении deadline (nullptr - без
+        ограничения), shutdown - если выставлен флаг stop.
+        notify_readable / notify_writable вызываются после добавления /
+        извлечения count элементов.
+ */
+template<typename WaitPolicy>
+class wait_state;
+
+template<>
+class wait_state<spin_wait> final
+{
+public:
+    void notify_readable(size_t = 1) noexcept {}
+    void notify_writable(size_t = 1) noexcept {}
+    void shutdown() noexcept {}
+
+    template<typename Ready, typename Clock, typename Duration>
+    WaitStatus wait_readable(Ready ready,
+                             const std::atomic_bool& stop,
+                             const std::chrono::time_point<Clock, Duration>* deadline)
+    {
+        return spin(ready, stop, deadline);
+    }
+
+    template<typename Ready, typename Clock, typename Duration>
+    WaitStatus wait_writable(Ready ready,
+                             const std::atomic_bool& stop,
+                             const std::chrono::time_point<Clock, Duration>* deadline)
+    {
+        return spin(ready, stop, deadline);
+    }
+
+private:
+    template<typename Ready, typename Clock, typename Duration>
+    static WaitStatus spin(Ready ready,
+                           const std::atomic_bool& stop,
+                           const std::chrono::time_point<Clock, Duration>* deadline)
+    {
+        for(uint32_t i = 0; ; ++i) {
+            if(stop.load(std::memory_order_relaxed))
+                return WaitStatus::shutdown;
+
+            if(ready())
+                return WaitStatus::success;
+
+            // часы опрашиваются не на каждой итерации
+            if(deadline && i % 64 == 0 && Clock::now() >= *deadline)
+                return WaitStatus::timeout;
+
+            if(i < 64)
+                cpu_relax();
+            else
+                std::this_thread::yield();
+        }
+    }
+};
+
+template<>
+class wait_state<park_wait> final
+{
+    // бюджет активного ожидания у читателей и писателей свой
+    AdaptiveSpin m_read_spin;
+    AdaptiveSpin m_write_spin;
+
+    std::mutex m_mutex;
+    std::condition_variable m_readable;
+    std::condition_variable m_writable;
+
+    std::atomic<size_t> m_waiting_readers;
+    std::atomic<size_t> m_waiting_writers;
+
+public:
+    wait_state()
+        : m_read_spin{}
+        , m_write_spin{}
+        , m_mutex{}
+        , m_readable{}
+        , m_writable{}
+        , m_waiting_readers{0}
+        , m_waiting_writers{0}
+    {}
+
+    void notify_readable(size_t count = 1)
+    {
+        notify(m_readable, m_waiting_readers, count);
+    }
+
+    void notify_writable(size_t count = 1)
+    {
+        notify(m_writable, m_waiting_writers, count);
+    }
+
+    void shutdown()
+    {
+        { std::lock_guard<std::mutex> locker(m_mutex); }
+        m_readable.notify_all();
+        m_writable.notify_all();
+    }
+
+    template<typename Ready, typename Clock, typename Duration>
+    WaitStatus wait_readable(Ready ready,
+                             const std::atomic_bool& stop,
+                             const std::chrono::time_point<Clock, Duration>* deadline)
+    {
+        return park(m_readable, m_waiting_readers, m_read_spin, ready, stop, deadline);
+    }
+
+    template<typename Ready, typename Clock, typename Duration>
+    WaitStatus wait_writable(Ready ready,
+                             const std::atomic_bool& stop,
+                             const std::chrono::time_point<Clock, Duration>* deadline)
+    {
+        return park(m_writable, m_waiting_writers, m_write_spin, ready, stop, deadline);
+    }
+
+private:
+    void notify(std::condition_variable& cv, std::atomic<size_t>& waiters, size_t count)
+    {
+        // Дополняет fetch_add в park: либо спящий увидит новую позицию,
+        // либо уведомляющий увидит спящего. Чтение-изменение-запись
+        // вместо барьера: ThreadSanitizer не моделирует отдельные барьеры
+        if(waiters.fetch_add(0, std::memory_order_seq_cst) == 0)
+            return;
+
+        // спящий между проверкой условия и wait держит m_mutex
+        { std::lock_guard<std::mutex> locker(m_mutex); }
+
+        // пакет элементов - работа для нескольких спящих
+        if(count > 1)
+            cv.notify_all();
+        else
+            cv.notify_one();
+    }
+
+    template<typename Ready, typename Clock, typename Duration>
+    WaitStatus park(std::condition_variable& cv,
+                    std::atomic<size_t>& waiters,
+                    AdaptiveSpin& spin,
+                    Ready ready,
+                    const std::atomic_bool& stop,
+                    const std::chrono::time_point<Clock, Duration>* deadline)
+    {
+        auto wake_up = [&]() {
+            return ready() || stop.load(std::memory_order_relaxed);
+        };
+
+        if(spin.wait(wake_up))
+            return stop ? WaitStatus::shutdown : WaitStatus::success;
+
+        std::unique_lock<std::mutex> locker(m_mutex);
+
+        waiters.fetch_add(1, std::memory_order_seq_cst);
+
+        bool success = true;
+        if(deadline)
+            success = cv.wait_until(locker, *deadline, wake_up);
+        else
+            cv.wait(locker, wake_up);
+
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+
+        if(stop)
+            return WaitStatus::shutdown;
+
+        return success ? WaitStatus::success : WaitStatus::timeout;
+    }
+};
+
+}
+}
+#endif // CIRCULAR_BUFFER_POLICIES_H
@@ -0,0 +1,207 @@
+#ifndef CIRCULAR_BUFFER_SHARDED_MRMW_H
+#define CIRCULAR_BUFFER_SHARDED_MRMW_H
+
+#include <vector>
+#include <utility>
+
+#include "circular_buffer_fwd.h"
+#include "circular_buffer_basic.h"
+#include "circular_buffer_mmap.h"
+#include "circular_buffer_numa.h"
+
+namespace connest {
+
+/**
+  @brief    Буфер multiple reader - multiple writer, разделенный по узлам NUMA
+  @details
+        Для каждого узла создается свой lockfree CircularBuffer_mrmw
+        (шард). Объект шарда (индексы) и его ячейки размещаются в памяти
+        своего узла. Поток пишет в шард своего узла и читает из него же;
+        к шардам других узлов он обращается, только если свой шард
+        заполнен (запись) или пуст (чтение).
+
+        Порядок FIFO соблюдается внутри шарда, но не между шардами.
+
+        Узел потока определяется numa::current_node(); количество шардов
+        можно задать больше числа узлов (имитация на одноузловой машине,
+        узел назначается numa::set_current_node).
+ */
+template <typename T>
+class CircularBuffer_mrmw_sharded final
+{
+public:
+    using shard_type = CircularBuffer_mrmw<T, mmap_allocator<T>>;
+
+private:
+    std::vector<numa::node_ptr<shard_type>> m_shards;
+
+public:
+    /**
+     * @param shard_size максимальное количество элементов в каждом шарде
+     * @param shards     количество шардов (по умолчанию - количество узлов)
+     */
+    CircularBuffer_mrmw_sharded(size_t shard_size,
+                                size_t shards = numa::node_count());
+
+    CircularBuffer_mrmw_sharded(const CircularBuffer_mrmw_sharded& other) = delete;
+    CircularBuffer_mrmw_sharded(CircularBuffer_mrmw_sharded&& other) = delete;
+    CircularBuffer_mrmw_sharded& operator=(const CircularBuffer_mrmw_sharded&) = delete;
+    CircularBuffer_mrmw_sharded& operator=(CircularBuffer_mrmw_sharded&&) = delete;
+
+    /**
+     * @brief Получить количество шардов
+     */
+    size_t shard_count() const noexcept;
+
+    /**
+     * @brief Получить шард узла
+     * @param node номер узла (по модулю количества шардов)
+     * @return ссылка на шард
+     */
+    shard_type& shard(size_t node) noexcept;
+
+    /**
+     * @brief Получить количество элементов во всех шардах
+     * @return количество элементов (значение может сразу устареть)
+     */
+    size_t size() const noexcept;
+
+    /**
+     * @brief Получить суммарную вместимость шардов
+     */
+    size_t max_size() const noexcept;
+
+    /**
+     * @brief Проверить, пусты ли все шарды
+     */
+    bool empty() const noexcept;
+
+    /**
+     * @brief   Добавить элемент в шард своего узла, а если он заполнен -
+     *          в первый незаполненный шард другого узла
+     * @param value значение элемента
+     * @return флаг успешности операции (все шарды заполнены)
+     */
+    template<typename Type>
+    bool try_push_back(Type&& value);
+
+    /**
+     * @brief   Получить элемент из шарда своего узла, а если он пуст -
+     *          забрать из шарда другого узла
+     * @param result место, куда будет записано значение
+     * @return флаг успешности операции (все шарды пусты)
+     */
+    bool try_pop(T& result);
+
+private:
+    /**
+     * @brief Шард узла текущего потока
+     */
+    size_t local_shard() const noexcept;
+};
+
+
+// Implementation
+
+template<typename T>
+CircularBuffer_mrmw_sharded<T>::CircularBuffer_mrmw_sharded(size_t shard_size,
+                                                            size_t shards)
+    : m_shards{}
+{
+    if(shards == 0)
+        shards = 1;
+
+    // таблица процессор - узел строится здесь, а не при первой операции
+    numa::detail::cpu_nodes();
+
+    m_shards.reserve(shards);
+
+    for(size_t node = 0; node < shards; ++node) {
+        // при имитации узлов, которых нет в системе, память не привязывается
+        int target = node < numa::node_count() ? static_cast<int>(node) : -1;
+
+        mmap_options options;
+        options.numa_node = target;
+
+        m_shards.push_back(numa::make_on_node<shard_type>(
+                               target, shard_size, mmap_allocator<T>(options)));
+    }
+}
+
+template<typename T>
+size_t CircularBuffer_mrmw_sharded<T>::shard_count() const noexcept
+{
+    return m_shards.size();
+}
+
+template<typename T>
+typename CircularBuffer_mrmw_sharded<T>::shard_type&
+CircularBuffer_mrmw_sharded<T>::shard(size_t node) noexcept
+{
+    return *m_shards[node % m_shards.size()];
+}
+
+template<typename T>
+size_t CircularBuffer_mrmw_sharded<T>::size() const noexcept
+{
+    size_t result = 0;
+    for(const auto& shard : m_shards)
+        result += shard->size();
+
+    return result;
+}
+
+template<typename T>
+size_t CircularBuffer_mrmw_sharded<T>::max_size() const noexcept
+{
+    size_t result = 0;
+    for(const auto& shard : m_shards)
+        result += shard->max_size();
+
+    return result;
+}
+
+template<typename T>
+bool CircularBuffer_mrmw_sharded<T>::empty() const noexcept
+{
+    for(const auto& shard : m_shards)
+        if(! shard->empty())
+            return false;
+
+    return true;
+}
+
+template<typename T>
+template<typename Type>
+bool CircularBuffer_mrmw_sharded<T>::try_push_back(Type&& value)
+{
+    size_t local = local_shard();
+
+    // value перемещается только при успешной записи
+    for(size_t i = 0; i < m_shards.size(); ++i)
+        if(m_shards[(local + i) % m_shards.size()]->try_push_back(std::forward<Type>(value)))
+            return true;
+
+    return false;
+}
+
+template<typename T>
+bool CircularBuffer_mrmw_sharded<T>::try_pop(T& result)
+{
+    size_t local = local_shard();
+
+    for(size_t i = 0; i < m_shards.size(); ++i)
+        if(m_shards[(local + i) % m_shards.size()]->try_pop(result))
+            return true;
+
+    return false;
+}
+
+template<typename T>
+size_t CircularBuffer_mrmw_sharded<T>::local_shard() const noexcept
+{
+    return static_cast<size_t>(numa::current_node()) % m_shards.size();
+}
+
+}
+#endif // CIRCULAR_BUFFER_SHARDED_MRMW_H
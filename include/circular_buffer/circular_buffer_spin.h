@@ -0,0 +1,121 @@
+#ifndef CIRCULAR_BUFFER_SPIN_H
+#define CIRCULAR_BUFFER_SPIN_H
+
+#include <atomic>
+#include <thread>
+#include <cstdint>
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace connest {
+namespace detail {
+
+/**
+ * @brief   Подсказка процессору, что поток находится в цикле
+ *          активного ожидания (pause / yield)
+ */
+inline void cpu_relax() noexcept
+{
+#if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+/**
+  @brief    Адаптивное активное ожидание перед блокировкой потока
+  @details
+        Поток сначала крутится budget итераций с cpu_relax(), затем
+        несколько раз уступает процессор (std::this_thread::yield()).
+        Если условие выполнилось за это время, бюджет подтягивается
+        к удвоенному фактически потраченному количеству итераций,
+        иначе - уменьшается вдвое: при долгих ожиданиях поток почти
+        сразу уходит в сон, при коротких - не платит за сон/пробуждение.
+ */
+class AdaptiveSpin final
+{
+    std::atomic<uint32_t> m_budget;
+
+public:
+    // enum, а не static constexpr: std::min/std::max принимают ссылки,
+    // а до C++17 это потребовало бы внешнего определения констант
+    enum : uint32_t {
+        min_budget  = 16,
+        max_budget  = 4096,
+        yield_count = 4
+    };
+
+    AdaptiveSpin() noexcept
+        : m_budget{single_core() ? 0u : 256u}
+    {}
+
+    /**
+     * @brief Текущий бюджет активного ожидания
+     * @return количество итераций
+     */
+    uint32_t budget() const noexcept
+    {
+        return m_budget.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Крутиться, пока не выполнится условие или не кончится бюджет
+     * @param ready условие окончания ожидания
+     * @return true, если условие выполнилось
+     */
+    template<typename Predicate>
+    bool wait(Predicate ready)
+    {
+        // на одном ядре другая сторона не может продвинуться, пока
+        // поток крутится, поэтому ожидание сразу уходит в сон
+        if(single_core())
+            return ready();
+
+        uint32_t budget = m_budget.load(std::memory_order_relaxed);
+
+        for(uint32_t i = 0; i < budget; ++i) {
+            if(ready()) {
+                succeeded(budget, i);
+                return true;
+            }
+            cpu_relax();
+        }
+
+        for(uint32_t i = 0; i < yield_count; ++i) {
+            std::this_thread::yield();
+            if(ready()) {
+                succeeded(budget, budget + i);
+                return true;
+            }
+        }
+
+        m_budget.store(std::max<uint32_t>(min_budget, budget / 2),
+                       std::memory_order_relaxed);
+        return false;
+    }
+
+private:
+    static bool single_core() noexcept
+    {
+        static const bool value = std::thread::hardware_concurrency() == 1;
+        return value;
+    }
+
+    void succeeded(uint32_t budget, uint32_t spent) noexcept
+    {
+        uint32_t target = (7 * budget + 2 * spent) / 8;
+        m_budget.store(std::min<uint32_t>(max_budget,
+                                           std::max<uint32_t>(min_budget, target)),
+                       std::memory_order_relaxed);
+    }
+};
+
+}
+}
+#endif // CIRCULAR_BUFFER_SPIN_H
@@ -0,0 +1,485 @@
+#ifndef CIRCULAR_BUFFER_STAGING_H
+#define CIRCULAR_BUFFER_STAGING_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "circular_buffer_fwd.h"
+#include "circular_buffer_spin.h"
+#include "circular_buffer_wait_status.h"
+
+namespace connest {
+
+namespace detail {
+
+/**
+  @brief    Накопитель одного потока-писателя
+  @details
+        items и oldest изменяются только при захваченном busy: владельцем
+        (добавление) или потоком сброса по таймеру. owned - накопитель
+        используется потоком (снимается при его завершении, после чего
+        накопитель может занять другой поток); closed - staging_buffer
+        разрушен, запись в реестре потока устарела.
+ */
+template<typename T>
+struct staging_stage
+{
+    alignas(64) std::atomic_bool busy;
+    std::atomic_bool owned;
+    std::atomic_bool closed;
+
+    std::vector<T> items;
+    std::chrono::steady_clock::time_point oldest;   // добавление первого элемента
+
+    // сброс накопленного в буфер, см. staging_buffer
+    size_t (*flush)(void* buffer, staging_stage& stage);
+    void* buffer;
+
+    staging_stage(size_t block, size_t (*flusher)(void*, staging_stage&), void* target)
+        : busy{false}
+        , owned{true}
+        , closed{false}
+        , items{}
+        , oldest{}
+        , flush(flusher)
+        , buffer(target)
+    {
+        items.reserve(block);
+    }
+
+    void lock() noexcept
+    {
+        for(uint32_t i = 0; busy.exchange(true, std::memory_order_acquire); ++i) {
+            if(i < 64)
+                cpu_relax();
+            else
+                std::this_thread::yield();
+        }
+    }
+
+    bool try_lock() noexcept
+    {
+        return ! busy.load(std::memory_order_relaxed)
+            && ! busy.exchange(true, std::memory_order_acquire);
+    }
+
+    void unlock() noexcept
+    {
+        busy.store(false, std::memory_order_release);
+    }
+};
+
+/**
+ * @brief Уникальный номер staging_buffer (адрес может быть использован повторно)
+ */
+inline uint64_t staging_next_id() noexcept
+{
+    static std::atomic<uint64_t> counter{0};
+    return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+/**
+  @brief    Накопители текущего потока во всех staging_buffer с элементами T
+  @details
+        При завершении потока накопленные элементы один раз пробуют
+        уйти в буфер (без ожидания), остаток сбрасывается по таймеру или
+        в деструкторе staging_buffer; накопитель освобождается для
+        других потоков.
+ */
+template<typename T>
+struct staging_registry
+{
+    struct entry
+    {
+        uint64_t owner;
+        std::shared_ptr<staging_stage<T>> stage;
+    };
+
+    std::vector<entry> entries;
+
+    staging_registry()
+        : entries{}
+    {}
+
+    ~staging_registry()
+    {
+        for(auto& e : entries) {
+            staging_stage<T>& stage = *e.stage;
+
+            {
+                std::lock_guard<staging_stage<T>> busy(stage);
+                if(! stage.closed.load(std::memory_order_relaxed))
+                    stage.flush(stage.buffer, stage);
+            }
+
+            stage.owned.store(false, std::memory_order_release);
+        }
+    }
+
+    static staging_registry& local()
+    {
+        static thread_local staging_registry registry;
+        return registry;
+    }
+};
+
+}
+
+/**
+  @brief    Накопление записей в потоке перед общим буфером
+  @details
+        Для писателей, которые добавляют элементы по одному и не могут
+        собрать серию сами. try_push_back кладет элемент в накопитель
+        текущего потока (создается при первой записи потока) - массив
+        до block элементов, - а в буфер элементы уходят серией
+        (Buffer::try_push_back_n: один захват позиций для lockfree
+        буфера, один захват мьютекса для CircularBuffer_mrmw_blocked):
+        - когда накопитель заполнен;
+        - по таймеру: поток сброса раз в max_latency / 2 отправляет
+          накопители, первый элемент которых ждет не меньше
+          max_latency / 2, поэтому добавленная задержка не превышает
+          max_latency (плюс задержка планировщика);
+        - по flush() (накопитель текущего потока) и flush_all().
+
+        max_latency = 0 - без потока сброса: только заполнение и flush.
+
+        Порядок элементов одного потока сохраняется. Накопитель
+        защищен флагом, который владелец захватывает на каждую запись
+        (без конкуренции, кроме моментов сброса по таймеру).
+        Деструктор останавливает таймер и ждет места в буфере для всех
+        накопленных элементов (push_back_wait), пока буфер не завершает
+        работу: после shutdown() остаток отбрасывается. Буфер должен
+        пережить staging_buffer.
+
+        Buffer - CircularBuffer_mrmw<T>, CircularBuffer_mrmw_blocked<T> или
+        другой basic_circular_buffer.
+ */
+template<typename Buffer>
+class staging_buffer final
+{
+public:
+    using value_type = typename Buffer::value_type;
+
+private:
+    using stage_type = detail::staging_stage<value_type>;
+    using registry   = detail::staging_registry<value_type>;
+
+    Buffer& m_buffer;
+    const uint64_t m_id;
+    const size_t m_block_size;
+    const std::chrono::nanoseconds m_max_latency;
+
+    // накопители всех потоков (регистрация и обход таймером)
+    std::mutex m_stages_mutex;
+    std::vector<std::shared_ptr<stage_type>> m_stages;
+
+    // поток сброса по таймеру
+    std::mutex m_timer_mutex;
+    std::condition_variable m_timer_cv;
+    bool m_stopped;
+    std::thread m_timer;
+
+public:
+    /**
+     * @param buffer      буфер, в который отправляются серии
+     * @param block       вместимость накопителя потока
+     * @param max_latency максимальная добавленная задержка (0 - без таймера)
+     */
+    explicit staging_buffer(Buffer& buffer,
+                            size_t block = 64,
+                            std::chrono::nanoseconds max_latency = std::chrono::microseconds(100));
+
+    staging_buffer(const staging_buffer&) = delete;
+    staging_buffer(staging_buffer&&) = delete;
+    staging_buffer& operator=(const staging_buffer&) = delete;
+    staging_buffer& operator=(staging_buffer&&) = delete;
+
+    ~staging_buffer();
+
+    /**
+     * @brief Получить вместимость накопителя
+     */
+    size_t block_size() const noexcept;
+
+    /**
+     * @brief Получить максимальную добавленную задержку (0 - без таймера)
+     */
+    std::chrono::nanoseconds max_latency() const noexcept;
+
+    /**
+     * @brief   Добавить элемент в накопитель текущего потока; заполненный
+     *          накопитель отправляется в буфер
+     * @param value значение элемента
+     * @return  false, если накопитель заполнен, а в буфере нет места
+     *          (value при этом не перемещается)
+     */
+    template<typename Type>
+    bool try_push_back(Type&& value);
+
+    /**
+     * @brief   Отправить накопленные текущим потоком элементы в буфер
+     *          (сколько есть места)
+     * @return количество отправленных элементов
+     */
+    size_t flush();
+
+    /**
+     * @brief   Отправить в буфер накопленные элементы всех потоков
+     *          (сколько есть места)
+     * @return количество отправленных элементов
+     */
+    size_t flush_all();
+
+    /**
+     * @brief   Получить количество элементов во всех накопителях
+     *          (значение может сразу устареть)
+     */
+    size_t pending();
+
+private:
+    /**
+     * @brief Накопитель текущего потока (регистрируется при первом обращении)
+     */
+    stage_type& local_stage();
+
+    /**
+     * @brief Занять освобожденный накопитель или создать новый
+     */
+    std::shared_ptr<stage_type> acquire_stage();
+
+    /**
+     * @brief   Отправить элементы накопителя в буфер.
+     *          Вызывается при захваченном stage.busy
+     */
+    static size_t flush_stage(void* self, stage_type& stage);
+
+    /**
+     * @brief Цикл потока сброса по таймеру
+     */
+    void timer_loop();
+};
+
+
+// Implementation
+
+template<typename Buffer>
+staging_buffer<Buffer>::staging_buffer(Buffer& buffer,
+                                       size_t block,
+                                       std::chrono::nanoseconds max_latency)
+    : m_buffer(buffer)
+    , m_id(detail::staging_next_id())
+    , m_block_size(block == 0 ? 1 : block)
+    , m_max_latency(max_latency < std::chrono::nanoseconds::zero() ? std::chrono::nanoseconds::zero() : max_latency)
+    , m_stages_mutex{}
+    , m_stages{}
+    , m_timer_mutex{}
+    , m_timer_cv{}
+    , m_stopped{false}
+    , m_timer{}
+{
+    if(m_max_latency.count() > 0)
+        m_timer = std::thread([this]() { timer_loop(); });
+}
+
+template<typename Buffer>
+staging_buffer<Buffer>::~staging_buffer()
+{
+    if(m_timer.joinable()) {
+        {
+            std::lock_guard<std::mutex> locker(m_timer_mutex);
+            m_stopped = true;
+        }
+        m_timer_cv.notify_one();
+        m_timer.join();
+    }
+
+    // не поместившееся забирается из накопителей, ожидание места
+    // не держит ни m_stages_mutex, ни флаги накопителей
+    std::vector<value_type> rest;
+    {
+        std::lock_guard<std::mutex> locker(m_stages_mutex);
+
+        for(auto& stage : m_stages) {
+            std::lock_guard<stage_type> busy(*stage);
+
+            flush_stage(this, *stage);
+            std::move(stage->items.begin(), stage->items.end(), std::back_inserter(rest));
+            stage->items.clear();
+
+            // записи в реестрах живых потоков удаляются при их следующей регистрации
+            stage->closed.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    // после shutdown() буфера остаток отбрасывается
+    for(value_type& value : rest)
+        if(m_buffer.push_back_wait(std::move(value)) != WaitStatus::success)
+            break;
+}
+
+template<typename Buffer>
+size_t staging_buffer<Buffer>::block_size() const noexcept
+{
+    return m_block_size;
+}
+
+template<typename Buffer>
+std::chrono::nanoseconds staging_buffer<Buffer>::max_latency() const noexcept
+{
+    return m_max_latency;
+}
+
+template<typename Buffer>
+template<typename Type>
+bool staging_buffer<Buffer>::try_push_back(Type&& value)
+{
+    stage_type& stage = local_stage();
+
+    // элемент или Buffer может бросить исключение - флаг снимается всегда
+    std::lock_guard<stage_type> busy(stage);
+
+    if(stage.items.size() == m_block_size && flush_stage(this, stage) == 0)
+        return false;
+
+    if(stage.items.empty() && m_max_latency.count() > 0)
+        stage.oldest = std::chrono::steady_clock::now();
+
+    stage.items.emplace_back(std::forward<Type>(value));
+
+    if(stage.items.size() == m_block_size)
+        flush_stage(this, stage);
+
+    return true;
+}
+
+template<typename Buffer>
+size_t staging_buffer<Buffer>::flush()
+{
+    stage_type& stage = local_stage();
+
+    std::lock_guard<stage_type> busy(stage);
+    return flush_stage(this, stage);
+}
+
+template<typename Buffer>
+size_t staging_buffer<Buffer>::flush_all()
+{
+    std::lock_guard<std::mutex> locker(m_stages_mutex);
+
+    size_t pushed{0};
+    for(auto& stage : m_stages) {
+        std::lock_guard<stage_type> busy(*stage);
+        pushed += flush_stage(this, *stage);
+    }
+
+    return pushed;
+}
+
+template<typename Buffer>
+size_t staging_buffer<Buffer>::pending()
+{
+    std::lock_guard<std::mutex> locker(m_stages_mutex);
+
+    size_t result{0};
+    for(auto& stage : m_stages) {
+        std::lock_guard<stage_type> busy(*stage);
+        result += stage->items.size();
+    }
+
+    return result;
+}
+
+template<typename Buffer>
+typename staging_buffer<Buffer>::stage_type&
+staging_buffer<Buffer>::local_stage()
+{
+    registry& local = registry::local();
+
+    for(auto& e : local.entries)
+        if(e.owner == m_id)
+            return *e.stage;
+
+    // первая запись потока: удаляем записи разрушенных staging_buffer
+    local.entries.erase(std::remove_if(local.entries.begin(), local.entries.end(),
+                                       [](const typename registry::entry& e) {
+                                           return e.stage->closed.load(std::memory_order_relaxed);
+                                       }),
+                        local.entries.end());
+
+    std::shared_ptr<stage_type> stage = acquire_stage();
+    local.entries.push_back(typename registry::entry{m_id, stage});
+
+    return *stage;
+}
+
+template<typename Buffer>
+std::shared_ptr<typename staging_buffer<Buffer>::stage_type>
+staging_buffer<Buffer>::acquire_stage()
+{
+    std::lock_guard<std::mutex> locker(m_stages_mutex);
+
+    // накопитель завершившегося потока: его остаток уйдет раньше новых элементов
+    for(auto& stage : m_stages) {
+        bool expected = false;
+        if(stage->owned.compare_exchange_strong(expected, true, std::memory_order_acquire))
+            return stage;
+    }
+
+    m_stages.push_back(std::make_shared<stage_type>(m_block_size, &flush_stage, this));
+    return m_stages.back();
+}
+
+template<typename Buffer>
+size_t staging_buffer<Buffer>::flush_stage(void* self, stage_type& stage)
+{
+    if(stage.items.empty())
+        return 0;
+
+    Buffer& buffer = static_cast<staging_buffer*>(self)->m_buffer;
+
+    size_t pushed = buffer.try_push_back_n(std::make_move_iterator(stage.items.begin()),
+                                           stage.items.size());
+
+    stage.items.erase(stage.items.begin(),
+                      stage.items.begin() + static_cast<std::ptrdiff_t>(pushed));
+
+    // остаток ждет дольше всех - время первого элемента не меняется
+    return pushed;
+}
+
+template<typename Buffer>
+void staging_buffer<Buffer>::timer_loop()
+{
+    const auto period = m_max_latency / 2;
+
+    std::unique_lock<std::mutex> timer(m_timer_mutex);
+
+    while(! m_timer_cv.wait_for(timer, period, [this]() { return m_stopped; })) {
+        auto expired = std::chrono::steady_clock::now() - period;
+
+        std::lock_guard<std::mutex> locker(m_stages_mutex);
+
+        for(auto& stage : m_stages) {
+            // владелец занят накопителем - отправит сам или на следующем шаге
+            if(! stage->try_lock())
+                continue;
+
+            std::lock_guard<stage_type> busy(*stage, std::adopt_lock);
+
+            if(! stage->items.empty() && stage->oldest <= expired)
+                flush_stage(this, *stage);
+        }
+    }
+}
+
+}
+#endif // CIRCULAR_BUFFER_STAGING_H
@@ -0,0 +1,592 @@
+#ifndef CIRCULAR_BUFFER_STATS_H
+#define CIRCULAR_BUFFER_STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "circular_buffer_fwd.h"
+
+namespace connest {
+
+using std::size_t;
+
+// Политики статистики буфера
+
+/**
+ * @brief Статистика не собирается (по умолчанию): вызовы пустые
+ */
+struct no_stats
+{
+    static constexpr bool enabled = false;
+    static constexpr bool dwell   = false;
+};
+
+/**
+ * @brief   Счетчики операций, повторов CAS, максимальной заполненности
+ *          и времени ожидания. Счетчики разнесены по шардам (поток пишет
+ *          в свой), поэтому измерение не добавляет конкуренции
+ */
+struct count_stats
+{
+    static constexpr bool enabled = true;
+    static constexpr bool dwell   = false;
+};
+
+/**
+ * @brief   count_stats и гистограмма времени пребывания элемента в буфере
+ *          (от захвата ячейки писателем до захвата читателем), см.
+ *          dwell_times(). Время добавления хранится по ячейкам в отдельном
+ *          массиве, поэтому тип T не меняется.
+ *          Clock - std::chrono::steady_clock или tsc_clock
+ */
+template<typename Clock = std::chrono::steady_clock>
+struct dwell_stats
+{
+    static constexpr bool enabled = true;
+    static constexpr bool dwell   = true;
+};
+
+
+/**
+  @brief    Часы на счетчике тактов процессора (rdtsc)
+  @details
+        Частота счетчика измеряется один раз при первом обращении
+        (около 1 мс по steady_clock). Предполагается инвариантный TSC
+        (постоянная частота, синхронный между ядрами). На других
+        архитектурах - steady_clock.
+ */
+struct tsc_clock
+{
+    using duration   = std::chrono::nanoseconds;
+    using rep        = duration::rep;
+    using period     = duration::period;
+    using time_point = std::chrono::time_point<tsc_clock, duration>;
+
+    static constexpr bool is_steady = true;
+
+    static time_point now() noexcept
+    {
+#if defined(__i386__) || defined(__x86_64__) || (defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64)))
+        return time_point(duration(static_cast<rep>(
+                    static_cast<double>(ticks()) * ns_per_tick())));
+#else
+        return time_point(std::chrono::duration_cast<duration>(
+                    std::chrono::steady_clock::now().time_since_epoch()));
+#endif
+    }
+
+private:
+#if defined(__i386__) || defined(__x86_64__) || (defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64)))
+    static uint64_t ticks() noexcept
+    {
+#if defined(_MSC_VER)
+        return __rdtsc();
+#else
+        return __builtin_ia32_rdtsc();
+#endif
+    }
+
+    static double ns_per_tick() noexcept
+    {
+        static const double value = []() {
+            auto start = std::chrono::steady_clock::now();
+            uint64_t begin = ticks();
+
+            auto elapsed = std::chrono::steady_clock::duration::zero();
+            while(elapsed < std::chrono::milliseconds(1))
+                elapsed = std::chrono::steady_clock::now() - start;
+
+            uint64_t end = ticks();
+            return static_cast<double>(
+                        std::chrono::duration_cast<duration>(elapsed).count())
+                 / static_cast<double>(end - begin);
+        }();
+        return value;
+    }
+#endif
+};
+
+
+/**
+ * @brief Снимок гистограммы времени (см. latency_histogram)
+ */
+struct latency_snapshot
+{
+    uint64_t count = 0;
+    std::chrono::nanoseconds min{0};
+    std::chrono::nanoseconds max{0};
+    std::chrono::nanoseconds total{0};
+
+    std::vector<uint64_t> buckets;  // количество значений по интервалам
+
+    /**
+     * @brief Среднее значение
+     */
+    std::chrono::nanoseconds mean() const noexcept
+    {
+        return count == 0 ? std::chrono::nanoseconds(0)
+                          : std::chrono::nanoseconds(total.count() / static_cast<int64_t>(count));
+    }
+
+    /**
+     * @brief   Значение, не меньше которого percent процентов значений
+     *          (с точностью интервала гистограммы, около 6%)
+     * @param percent процент (0 - 100)
+     * @return верхняя граница интервала, в котором находится перцентиль
+     */
+    std::chrono::nanoseconds percentile(double percent) const noexcept;
+};
+
+
+/**
+  @brief    Lock-free гистограмма с логарифмически-линейными интервалами
+  @details
+        Как в HdrHistogram: значения до 16 нс учитываются точно, далее
+        каждая степень двойки делится на 16 равных интервалов
+        (относительная погрешность не больше 1/16). Запись - один
+        fetch_add в интервал и в сумму, min / max обновляются только
+        при изменении.
+
+        snapshot(true) обнуляет интервалы по одному (exchange):
+        значение, записанное во время чтения, попадает либо в этот
+        снимок, либо в следующий, но не теряется.
+ */
+class latency_histogram final
+{
+public:
+    enum : unsigned {
+        sub_bits     = 4,
+        sub_count    = 1u << sub_bits,
+        bucket_count = (64 - sub_bits + 1) * sub_count
+    };
+
+private:
+    std::atomic<uint64_t> m_buckets[bucket_count];
+
+    std::atomic<uint64_t> m_total;
+    std::atomic<uint64_t> m_min;
+    std::atomic<uint64_t> m_max;
+
+public:
+    latency_histogram() noexcept
+        : m_total{0}
+        , m_min{std::numeric_limits<uint64_t>::max()}
+        , m_max{0}
+    {
+        for(auto& bucket : m_buckets)
+            bucket.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Учесть значение
+     * @param ns значение в наносекундах
+     */
+    void record(uint64_t ns) noexcept
+    {
+        m_buckets[index(ns)].fetch_add(1, std::memory_order_relaxed);
+        m_total.fetch_add(ns, std::memory_order_relaxed);
+
+        uint64_t current = m_max.load(std::memory_order_relaxed);
+        while(ns > current
+              && ! m_max.compare_exchange_weak(current, ns, std::memory_order_relaxed)) {}
+
+        current = m_min.load(std::memory_order_relaxed);
+        while(ns < current
+              && ! m_min.compare_exchange_weak(current, ns, std::memory_order_relaxed)) {}
+    }
+
+    /**
+     * @brief Получить снимок гистограммы
+     * @param reset обнулить гистограмму (reset-on-read)
+     * @return снимок
+     */
+    latency_snapshot snapshot(bool reset = false) noexcept
+    {
+        latency_snapshot result;
+        result.buckets.resize(bucket_count);
+
+        for(unsigned i = 0; i < bucket_count; ++i)
+            result.buckets[i] = take(m_buckets[i], reset, 0);
+
+        for(uint64_t n : result.buckets)
+            result.count += n;
+
+        result.total = std::chrono::nanoseconds(take(m_total, reset, 0));
+        result.max   = std::chrono::nanoseconds(take(m_max, reset, 0));
+
+        uint64_t min = take(m_min, reset, std::numeric_limits<uint64_t>::max());
+        result.min = std::chrono::nanoseconds(result.count == 0 ? 0 : min);
+
+        return result;
+    }
+
+    /**
+     * @brief Номер интервала для значения
+     */
+    static unsigned index(uint64_t value) noexcept
+    {
+        if(value < sub_count)
+            return static_cast<unsigned>(value);
+
+        unsigned magnitude = 63 - count_leading_zeros(value);
+        unsigned shift     = magnitude - sub_bits;
+
+        // старшие sub_bits + 1 бит значения: [sub_count, 2 * sub_count)
+        return (shift + 1) * sub_count
+             + static_cast<unsigned>(value >> shift) - sub_count;
+    }
+
+    /**
+     * @brief Наибольшее значение, попадающее в интервал
+     */
+    static uint64_t upper_bound(unsigned index) noexcept
+    {
+        unsigned block  = index / sub_count;
+        unsigned offset = index % sub_count;
+
+        if(block == 0)
+            return offset;
+
+        unsigned shift = block - 1;
+        uint64_t lower = static_cast<uint64_t>(sub_count + offset) << shift;
+        return lower + ((uint64_t(1) << shift) - 1);
+    }
+
+private:
+    static uint64_t take(std::atomic<uint64_t>& value, bool reset, uint64_t initial) noexcept
+    {
+        return reset ? value.exchange(initial, std::memory_order_relaxed)
+                     : value.load(std::memory_order_relaxed);
+    }
+
+    static unsigned count_leading_zeros(uint64_t value) noexcept
+    {
+#if defined(__GNUC__)
+        return static_cast<unsigned>(__builtin_clzll(value));
+#else
+        unsigned result = 0;
+        for(uint64_t bit = uint64_t(1) << 63; ! (value & bit); bit >>= 1)
+            ++result;
+        return result;
+#endif
+    }
+};
+
+inline std::chrono::nanoseconds latency_snapshot::percentile(double percent) const noexcept
+{
+    if(count == 0)
+        return std::chrono::nanoseconds(0);
+
+    double target = percent / 100.0 * static_cast<double>(count);
+    uint64_t rank = target <= 1.0 ? 1 : static_cast<uint64_t>(target + 0.999999);
+    if(rank > count)
+        rank = count;
+
+    uint64_t seen = 0;
+    for(size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if(seen >= rank) {
+            uint64_t bound = latency_histogram::upper_bound(static_cast<unsigned>(i));
+            // граница интервала не больше наблюдавшегося максимума
+            return std::chrono::nanoseconds(
+                        std::min<uint64_t>(bound, static_cast<uint64_t>(max.count())));
+        }
+    }
+
+    return max;
+}
+
+
+/**
+ * @brief Снимок статистики буфера (см. stats())
+ */
+struct buffer_stats
+{
+    uint64_t pushes      = 0;   // добавленные элементы
+    uint64_t pops        = 0;   // извлеченные элементы
+    uint64_t push_full   = 0;   // неудачные попытки добавления (заполнен)
+    uint64_t pop_empty   = 0;   // неудачные попытки извлечения (пуст)
+    uint64_t cas_retries = 0;   // повторы CAS при захвате позиции
+    size_t   high_water  = 0;   // максимальная заполненность
+
+    uint64_t waits = 0;                             // ожидания места / данных
+    std::chrono::nanoseconds wait_time{0};          // суммарное время ожиданий
+    std::chrono::nanoseconds max_wait{0};           // самое долгое ожидание
+};
+
+
+namespace detail {
+
+/**
+ * @brief Номер потока для выбора шарда счетчиков
+ */
+inline unsigned stats_thread_index() noexcept
+{
+    static std::atomic<unsigned> counter{0};
+    static thread_local unsigned index = counter.fetch_add(1, std::memory_order_relaxed);
+    return index;
+}
+
+/**
+  @brief    Состояние статистики для политики StatsPolicy
+  @details
+        occupancy и timed_wait принимают функции, чтобы при no_stats
+        заполненность не вычислялась, а часы не опрашивались.
+
+        enqueued / dequeued получают номер ячейки после её захвата
+        (до публикации), поэтому запись и чтение времени добавления
+        упорядочены так же, как сам элемент. relocate вызывается
+        при переносе элементов в новое хранилище (resize):
+        source(i) - прежняя ячейка i-го элемента.
+ */
+template<typename StatsPolicy>
+class stats_state;
+
+template<>
+class stats_state<no_stats> final
+{
+public:
+    explicit stats_state(size_t = 0) noexcept {}
+
+    void enqueued(size_t) noexcept {}
+    void dequeued(size_t) noexcept {}
+
+    template<typename Source>
+    void relocate(size_t, size_t, Source) {}
+
+    void pushed(size_t = 1) noexcept {}
+    void popped(size_t = 1) noexcept {}
+    void push_failed() noexcept {}
+    void pop_failed() noexcept {}
+    void cas_retry() noexcept {}
+
+    template<typename Occupancy>
+    void occupancy(Occupancy) noexcept {}
+
+    template<typename Wait>
+    auto timed_wait(Wait wait) -> decltype(wait())
+    {
+        return wait();
+    }
+
+    buffer_stats snapshot() const noexcept
+    {
+        return buffer_stats();
+    }
+};
+
+template<>
+class stats_state<count_stats> final
+{
+    enum : size_t { shards = 16 };
+
+    struct alignas(64) shard
+    {
+        std::atomic<uint64_t> pushes{0};
+        std::atomic<uint64_t> pops{0};
+        std::atomic<uint64_t> push_full{0};
+        std::atomic<uint64_t> pop_empty{0};
+        std::atomic<uint64_t> cas_retries{0};
+        std::atomic<uint64_t> waits{0};
+        std::atomic<uint64_t> wait_ns{0};
+    };
+
+    shard m_shards[shards];
+
+    // изменяются только при обновлении максимума
+    alignas(64) std::atomic<size_t> m_high_water;
+    std::atomic<uint64_t> m_max_wait_ns;
+
+public:
+    explicit stats_state(size_t = 0) noexcept
+        : m_high_water{0}
+        , m_max_wait_ns{0}
+    {}
+
+    void enqueued(size_t) noexcept {}
+    void dequeued(size_t) noexcept {}
+
+    template<typename Source>
+    void relocate(size_t, size_t, Source) {}
+
+    void pushed(size_t n = 1) noexcept
+    {
+        local().pushes.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    void popped(size_t n = 1) noexcept
+    {
+        local().pops.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    void push_failed() noexcept
+    {
+        local().push_full.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void pop_failed() noexcept
+    {
+        local().pop_empty.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void cas_retry() noexcept
+    {
+        local().cas_retries.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    template<typename Occupancy>
+    void occupancy(Occupancy current) noexcept
+    {
+        raise(m_high_water, static_cast<size_t>(current()));
+    }
+
+    template<typename Wait>
+    auto timed_wait(Wait wait) -> decltype(wait())
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        struct record
+        {
+            stats_state& stats;
+            std::chrono::steady_clock::time_point start;
+
+            ~record()
+            {
+                uint64_t ns = static_cast<uint64_t>(
+                            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                std::chrono::steady_clock::now() - start).count());
+
+                shard& s = stats.local();
+                s.waits.fetch_add(1, std::memory_order_relaxed);
+                s.wait_ns.fetch_add(ns, std::memory_order_relaxed);
+                raise(stats.m_max_wait_ns, ns);
+            }
+        } guard{*this, start};
+
+        return wait();
+    }
+
+    buffer_stats snapshot() const noexcept
+    {
+        buffer_stats result;
+        uint64_t wait_ns = 0;
+
+        for(const shard& s : m_shards) {
+            result.pushes      += s.pushes     .load(std::memory_order_relaxed);
+            result.pops        += s.pops       .load(std::memory_order_relaxed);
+            result.push_full   += s.push_full  .load(std::memory_order_relaxed);
+            result.pop_empty   += s.pop_empty  .load(std::memory_order_relaxed);
+            result.cas_retries += s.cas_retries.load(std::memory_order_relaxed);
+            result.waits       += s.waits      .load(std::memory_order_relaxed);
+            wait_ns            += s.wait_ns    .load(std::memory_order_relaxed);
+        }
+
+        result.high_water = m_high_water.load(std::memory_order_relaxed);
+        result.wait_time  = std::chrono::nanoseconds(wait_ns);
+        result.max_wait   = std::chrono::nanoseconds(
+                    m_max_wait_ns.load(std::memory_order_relaxed));
+
+        return result;
+    }
+
+private:
+    shard& local() noexcept
+    {
+        return m_shards[stats_thread_index() % shards];
+    }
+
+    template<typename Value>
+    static void raise(std::atomic<Value>& maximum, Value value) noexcept
+    {
+        // запись только при новом максимуме: обычно это одно чтение
+        Value current = maximum.load(std::memory_order_relaxed);
+        while(value > current
+              && ! maximum.compare_exchange_weak(current, value,
+                                                 std::memory_order_relaxed)) {}
+    }
+};
+
+template<typename Clock>
+class stats_state<dwell_stats<Clock>> final
+{
+    stats_state<count_stats> m_counters;
+
+    std::vector<int64_t> m_enqueued;    // время добавления по ячейкам, нс
+    latency_histogram m_dwell;
+
+public:
+    explicit stats_state(size_t slots)
+        : m_counters{}
+        , m_enqueued(slots, 0)
+        , m_dwell{}
+    {}
+
+    void enqueued(size_t position) noexcept
+    {
+        m_enqueued[position] = now();
+    }
+
+    void dequeued(size_t position) noexcept
+    {
+        int64_t dwell = now() - m_enqueued[position];
+        m_dwell.record(dwell > 0 ? static_cast<uint64_t>(dwell) : 0);
+    }
+
+    template<typename Source>
+    void relocate(size_t slots, size_t count, Source source)
+    {
+        std::vector<int64_t> enqueued(slots, 0);
+        for(size_t i = 0; i < count; ++i)
+            enqueued[i] = m_enqueued[source(i)];
+
+        m_enqueued.swap(enqueued);
+    }
+
+    void pushed(size_t n = 1) noexcept  { m_counters.pushed(n); }
+    void popped(size_t n = 1) noexcept  { m_counters.popped(n); }
+    void push_failed() noexcept         { m_counters.push_failed(); }
+    void pop_failed() noexcept          { m_counters.pop_failed(); }
+    void cas_retry() noexcept           { m_counters.cas_retry(); }
+
+    template<typename Occupancy>
+    void occupancy(Occupancy current) noexcept
+    {
+        m_counters.occupancy(current);
+    }
+
+    template<typename Wait>
+    auto timed_wait(Wait wait) -> decltype(wait())
+    {
+        return m_counters.timed_wait(wait);
+    }
+
+    buffer_stats snapshot() const noexcept
+    {
+        return m_counters.snapshot();
+    }
+
+    latency_snapshot dwell(bool reset) noexcept
+    {
+        return m_dwell.snapshot(reset);
+    }
+
+private:
+    static int64_t now() noexcept
+    {
+        return static_cast<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    Clock::now().time_since_epoch()).count());
+    }
+};
+
+}
+}
+#endif // CIRCULAR_BUFFER_STATS_H
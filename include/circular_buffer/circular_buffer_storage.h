@@ -0,0 +1,275 @@
+#ifndef CIRCULAR_BUFFER_STORAGE_H
+#define CIRCULAR_BUFFER_STORAGE_H
+
+#include <vector>
+#include <array>
+#include <new>
+#include <memory>
+#include <utility>
+#include <stdexcept>
+#include <cstddef>
+
+#include "circular_buffer_fwd.h"
+#include "circular_buffer_mmap.h"
+
+namespace connest {
+
+using std::size_t;
+
+/*
+    Политика хранения элементов кольцевого буфера.
+
+    Хранилище создается с количеством ячеек (емкость буфера + резервная
+    ячейка) и аллокатором и предоставляет:
+        T& operator[](size_t)              - доступ без проверки границ
+        size_t size() const noexcept       - количество ячеек
+        void swap(Storage&) noexcept       - обмен содержимым
+        allocator_type get_allocator()     - аллокатор (для нового
+                                             хранилища при resize)
+        static constexpr bool resizable    - можно ли создать хранилище
+                                             другого размера (resize)
+ */
+
+
+/**
+  @brief    Ячейки в std::vector (поведение по умолчанию)
+  @details
+        Allocator приводится (rebind) к типу T, поэтому подходит
+        аллокатор любого типа, в том числе std::pmr::polymorphic_allocator
+ */
+template<typename T, typename Allocator>
+class vector_storage final
+{
+public:
+    using allocator_type =
+        typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
+
+    static constexpr bool resizable = true;
+
+private:
+    std::vector<T, allocator_type> m_data;
+
+public:
+    explicit vector_storage(size_t slots,
+                            const allocator_type& allocator = allocator_type())
+        : m_data(allocator)
+    {
+        m_data.resize(slots);
+    }
+
+    allocator_type get_allocator() const
+    {
+        return m_data.get_allocator();
+    }
+
+    T& operator[](size_t pos) noexcept
+    {
+        return m_data[pos];
+    }
+
+    const T& operator[](size_t pos) const noexcept
+    {
+        return m_data[pos];
+    }
+
+    size_t size() const noexcept
+    {
+        return m_data.size();
+    }
+
+    void swap(vector_storage& other) noexcept
+    {
+        m_data.swap(other.m_data);
+    }
+};
+
+
+/**
+  @brief    Ячейки внутри объекта буфера (без обращения к куче)
+  @details
+        Емкость задается при компиляции: N полезных элементов плюс
+        резервная ячейка. Конструктор буфера с большей емкостью
+        выбрасывает std::length_error. Изменение размера недоступно.
+ */
+template<typename T, size_t N>
+class inline_storage final
+{
+    std::array<T, N + 1> m_data;
+    size_t m_slots;
+
+public:
+    // память не выделяется, аллокатор принимается для единообразия
+    using allocator_type = std::allocator<T>;
+
+    static constexpr bool resizable = false;
+
+    explicit inline_storage(size_t slots,
+                            const allocator_type& = allocator_type())
+        : m_data{}
+        , m_slots{slots}
+    {
+        if(slots > N + 1)
+            throw std::length_error("inline_storage: capacity exceeds N");
+    }
+
+    allocator_type get_allocator() const noexcept
+    {
+        return allocator_type();
+    }
+
+    T& operator[](size_t pos) noexcept
+    {
+        return m_data[pos];
+    }
+
+    const T& operator[](size_t pos) const noexcept
+    {
+        return m_data[pos];
+    }
+
+    size_t size() const noexcept
+    {
+        return m_slots;
+    }
+
+    void swap(inline_storage& other) noexcept(noexcept(std::swap(std::declval<T&>(),
+                                                                 std::declval<T&>())))
+    {
+        m_data.swap(other.m_data);
+        std::swap(m_slots, other.m_slots);
+    }
+};
+
+
+/**
+  @brief    Ячейки в анонимном отображении памяти (mmap)
+  @details
+        Память выделяется отдельным отображением, выровненным по
+        странице, и не делит страницы с другими объектами кучи.
+        Параметры отображения (большие страницы, предварительное
+        обращение к страницам, mlock) задаются аллокатором
+        mmap_allocator, выбранный путь доступен через mapping().
+        Если mmap недоступен (не POSIX) или завершился ошибкой,
+        используется operator new (page_backing::heap).
+ */
+template<typename T>
+class mmap_storage final
+{
+public:
+    using allocator_type = mmap_allocator<T>;
+
+    static constexpr bool resizable = true;
+
+private:
+    T* m_data;
+    size_t m_slots;
+    allocator_type m_allocator;
+    mapping_info m_mapping;
+
+public:
+    explicit mmap_storage(size_t slots,
+                          const allocator_type& allocator = allocator_type())
+        : m_data{nullptr}
+        , m_slots{slots}
+        , m_allocator{allocator}
+        , m_mapping{}
+    {
+        void* memory = allocate();
+
+        size_t constructed = 0;
+        try {
+            for(; constructed < m_slots; ++constructed)
+                new (static_cast<T*>(memory) + constructed) T();
+        }
+        catch(...) {
+            destroy(static_cast<T*>(memory), constructed);
+            deallocate(memory);
+            throw;
+        }
+
+        m_data = static_cast<T*>(memory);
+    }
+
+    mmap_storage(const mmap_storage&) = delete;
+    mmap_storage& operator=(const mmap_storage&) = delete;
+
+    ~mmap_storage()
+    {
+        destroy(m_data, m_slots);
+        deallocate(m_data);
+    }
+
+    allocator_type get_allocator() const noexcept
+    {
+        return m_allocator;
+    }
+
+    T& operator[](size_t pos) noexcept
+    {
+        return m_data[pos];
+    }
+
+    const T& operator[](size_t pos) const noexcept
+    {
+        return m_data[pos];
+    }
+
+    size_t size() const noexcept
+    {
+        return m_slots;
+    }
+
+    void swap(mmap_storage& other) noexcept
+    {
+        std::swap(m_data, other.m_data);
+        std::swap(m_slots, other.m_slots);
+        std::swap(m_allocator, other.m_allocator);
+        std::swap(m_mapping, other.m_mapping);
+    }
+
+    /**
+     * @brief Получить отчет о выделенной памяти
+     * @return выбранный путь (обычные / большие страницы, куча),
+     *         результат предварительного обращения и mlock
+     */
+    const mapping_info& mapping() const noexcept
+    {
+        return m_mapping;
+    }
+
+private:
+    size_t bytes() const noexcept
+    {
+        return m_slots * sizeof(T);
+    }
+
+    static void destroy(T* data, size_t count) noexcept
+    {
+        for(size_t i = 0; i < count; ++i)
+            data[i].~T();
+    }
+
+    void* allocate()
+    {
+        void* memory = m_allocator.map(bytes(), m_mapping);
+        if(memory)
+            return memory;
+
+        m_mapping = mapping_info();
+        m_mapping.bytes = bytes();
+        return ::operator new(bytes());
+    }
+
+    void deallocate(void* memory) noexcept
+    {
+        if(m_mapping.backing == page_backing::heap) {
+            ::operator delete(memory);
+            return;
+        }
+
+        m_allocator.unmap(memory, bytes());
+    }
+};
+
+}
+#endif // CIRCULAR_BUFFER_STORAGE_H
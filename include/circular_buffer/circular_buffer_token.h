@@ -0,0 +1,248 @@
+#ifndef CIRCULAR_BUFFER_TOKEN_H
+#define CIRCULAR_BUFFER_TOKEN_H
+
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "circular_buffer_fwd.h"
+#include "circular_buffer_basic.h"
+#include "circular_buffer_wait_status.h"
+
+namespace connest {
+
+/**
+  @brief    Маркер писателя: один захват позиций на серию элементов
+  @details
+        Поток получает маркер один раз и добавляет элементы через него.
+        Маркер копит до block элементов и, когда серия набрана, захватывает
+        под нее позиции одним CAS по W (try_push_back_n) и продвигает W'
+        один раз - вместо CAS и продвижения на каждый элемент.
+
+        Позиции не захватываются заранее: в кольце W' продвигается строго
+        по порядку захвата, и незаполненные заранее захваченные позиции
+        остановили бы всех последующих писателей и читателей, пока
+        владелец маркера не добавит следующий элемент.
+
+        Элементы становятся видны читателям при заполнении серии или по
+        flush(); порядок элементов одного маркера сохраняется.
+        Деструктор ждет места для отложенных элементов (push_back_wait),
+        пока буфер не завершает работу: после shutdown() оставшиеся
+        элементы отбрасываются.
+
+        Buffer - basic_circular_buffer (например, CircularBuffer_mrmw<T>).
+        Маркер используется одним потоком.
+ */
+template<typename Buffer>
+class producer_token final
+{
+public:
+    using value_type = typename Buffer::value_type;
+
+private:
+    Buffer& m_buffer;
+    size_t m_block_size;
+    std::vector<value_type> m_block;
+
+public:
+    /**
+     * @param buffer буфер
+     * @param block  количество элементов в серии
+     */
+    explicit producer_token(Buffer& buffer, size_t block = 64);
+
+    producer_token(producer_token&& other) = default;
+    producer_token(const producer_token&) = delete;
+    producer_token& operator=(const producer_token&) = delete;
+    producer_token& operator=(producer_token&&) = delete;
+
+    ~producer_token();
+
+    /**
+     * @brief Получить количество элементов в серии
+     */
+    size_t block_size() const noexcept;
+
+    /**
+     * @brief Получить количество отложенных (еще не добавленных) элементов
+     */
+    size_t pending() const noexcept;
+
+    /**
+     * @brief   Добавить элемент в серию; заполненная серия добавляется
+     *          в буфер
+     * @param value значение элемента
+     * @return  false, если серия заполнена, а в буфере нет места
+     *          (value при этом не перемещается)
+     */
+    template<typename Type>
+    bool try_push_back(Type&& value);
+
+    /**
+     * @brief   Добавить отложенные элементы в буфер (сколько есть места)
+     * @return количество добавленных элементов
+     */
+    size_t flush();
+};
+
+
+/**
+  @brief    Маркер читателя: один захват позиций на серию элементов
+  @details
+        При пустом запасе маркер забирает из буфера до block элементов
+        одним CAS по R (try_pop_n) и выдает их по одному из запаса.
+
+        Элементы запаса уже извлечены из буфера (не учитываются в size()
+        и недоступны другим читателям); при разрушении маркера
+        невыданные элементы теряются - перед этим их нужно дочитать
+        (pending()).
+
+        Buffer - basic_circular_buffer (например, CircularBuffer_mrmw<T>).
+        Маркер используется одним потоком.
+ */
+template<typename Buffer>
+class consumer_token final
+{
+public:
+    using value_type = typename Buffer::value_type;
+
+private:
+    Buffer& m_buffer;
+    size_t m_block_size;
+    std::vector<value_type> m_block;
+    size_t m_next;
+
+public:
+    /**
+     * @param buffer буфер
+     * @param block  максимальное количество элементов в серии
+     */
+    explicit consumer_token(Buffer& buffer, size_t block = 64);
+
+    consumer_token(consumer_token&& other) = default;
+    consumer_token(const consumer_token&) = delete;
+    consumer_token& operator=(const consumer_token&) = delete;
+    consumer_token& operator=(consumer_token&&) = delete;
+
+    /**
+     * @brief Получить максимальное количество элементов в серии
+     */
+    size_t block_size() const noexcept;
+
+    /**
+     * @brief Получить количество невыданных элементов запаса
+     */
+    size_t pending() const noexcept;
+
+    /**
+     * @brief   Получить очередной элемент (из запаса, при пустом запасе -
+     *          новой серией из буфера)
+     * @param result место, куда будет записано значение
+     * @return флаг успешности операции (запас и буфер пусты)
+     */
+    bool try_pop(value_type& result);
+};
+
+
+// Implementation
+
+template<typename Buffer>
+producer_token<Buffer>::producer_token(Buffer& buffer, size_t block)
+    : m_buffer(buffer)
+    , m_block_size(block == 0 ? 1 : block)
+    , m_block{}
+{
+    m_block.reserve(m_block_size);
+}
+
+template<typename Buffer>
+producer_token<Buffer>::~producer_token()
+{
+    flush();
+
+    // остаток - по одному с ожиданием; после shutdown() отбрасывается
+    for(value_type& value : m_block)
+        if(m_buffer.push_back_wait(std::move(value)) != WaitStatus::success)
+            break;
+}
+
+template<typename Buffer>
+size_t producer_token<Buffer>::block_size() const noexcept
+{
+    return m_block_size;
+}
+
+template<typename Buffer>
+size_t producer_token<Buffer>::pending() const noexcept
+{
+    return m_block.size();
+}
+
+template<typename Buffer>
+template<typename Type>
+bool producer_token<Buffer>::try_push_back(Type&& value)
+{
+    if(m_block.size() == m_block_size && flush() == 0)
+        return false;
+
+    m_block.emplace_back(std::forward<Type>(value));
+
+    if(m_block.size() == m_block_size)
+        flush();
+
+    return true;
+}
+
+template<typename Buffer>
+size_t producer_token<Buffer>::flush()
+{
+    if(m_block.empty())
+        return 0;
+
+    size_t pushed = m_buffer.try_push_back_n(std::make_move_iterator(m_block.begin()),
+                                             m_block.size());
+
+    m_block.erase(m_block.begin(), m_block.begin() + static_cast<std::ptrdiff_t>(pushed));
+    return pushed;
+}
+
+
+template<typename Buffer>
+consumer_token<Buffer>::consumer_token(Buffer& buffer, size_t block)
+    : m_buffer(buffer)
+    , m_block_size(block == 0 ? 1 : block)
+    , m_block{}
+    , m_next{0}
+{
+    m_block.reserve(m_block_size);
+}
+
+template<typename Buffer>
+size_t consumer_token<Buffer>::block_size() const noexcept
+{
+    return m_block_size;
+}
+
+template<typename Buffer>
+size_t consumer_token<Buffer>::pending() const noexcept
+{
+    return m_block.size() - m_next;
+}
+
+template<typename Buffer>
+bool consumer_token<Buffer>::try_pop(value_type& result)
+{
+    if(m_next == m_block.size()) {
+        m_block.clear();
+        m_next = 0;
+
+        if(m_buffer.try_pop_n(std::back_inserter(m_block), m_block_size) == 0)
+            return false;
+    }
+
+    result = std::move(m_block[m_next++]);
+    return true;
+}
+
+}
+#endif // CIRCULAR_BUFFER_TOKEN_H
@@ -0,0 +1,567 @@
+#ifndef CIRCULAR_BUFFER_TWOLOCK_MRMW_H
+#define CIRCULAR_BUFFER_TWOLOCK_MRMW_H
+
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <type_traits>
+#include <chrono>
+
+#include "circular_buffer_fwd.h"
+#include "circular_buffer_storage.h"
+#include "circular_buffer_wait_status.h"
+
+namespace connest {
+
+/**
+  @brief    Циклический буфер multiple reader - multiple writter
+            с раздельными блокировками для писателей и читателей
+  @details
+        Писатели сериализуются мьютексом m_push_mutex (охраняет m_tail),
+        читатели - мьютексом m_pop_mutex (охраняет m_head).
+        Индексы публикуются между сторонами через атомарные переменные,
+        поэтому один писатель и один читатель работают одновременно.
+
+                H                       T
+                |                       |
+                V                       V
+  -----------------------------------------------------
+  |   |   |   |XXX|XXX|XXX|XXX|XXX|XXX|   |   |   |RES|
+  -----------------------------------------------------
+
+  H - позиция чтения (пишет только владелец m_pop_mutex)
+  T - позиция записи (пишет только владелец m_push_mutex)
+
+  RES - зарезервированный элемент, чтобы отличать
+        состояния "пуст" и "заполнен"
+ */
+template <typename T, typename Allocator>
+class CircularBuffer_mrmw_twolock final
+{
+    static_assert ( std::is_default_constructible<T>::value,
+                    "Type T must be default constructible: empty buffer should "
+                    "have initialized elements");
+
+    vector_storage<T, Allocator> m_data;
+
+    // сторона читателей
+    alignas(64) std::mutex m_pop_mutex;
+    std::condition_variable m_not_empty;
+    std::atomic<size_t> m_head;
+    std::atomic<size_t> m_waiting_readers;
+
+    // сторона писателей
+    alignas(64) std::mutex m_push_mutex;
+    std::condition_variable m_not_full;
+    std::atomic<size_t> m_tail;
+    std::atomic<size_t> m_waiting_writers;
+
+    std::atomic_bool m_delete;
+
+public:
+    using allocator_type = typename vector_storage<T, Allocator>::allocator_type;
+
+    /**
+     * @param size      максимальное количество элементов
+     * @param allocator аллокатор хранилища ячеек
+     */
+    CircularBuffer_mrmw_twolock(size_t size,
+                                const allocator_type& allocator = allocator_type());
+
+    CircularBuffer_mrmw_twolock(const CircularBuffer_mrmw_twolock& other) = delete;
+    CircularBuffer_mrmw_twolock(CircularBuffer_mrmw_twolock&& other) = delete;
+    CircularBuffer_mrmw_twolock& operator=(const CircularBuffer_mrmw_twolock&) = delete;
+    CircularBuffer_mrmw_twolock& operator=(CircularBuffer_mrmw_twolock&&) = delete;
+
+    ~CircularBuffer_mrmw_twolock();
+
+    /**
+     * @brief Получить размер данных в буфере (без блокировок)
+     * @return количество элементов в буфере
+     */
+    size_t size() const noexcept;
+
+    /**
+     * @brief Получить размер буфера
+     * @return максимальное количество элементов в буфере
+     */
+    size_t max_size() const noexcept;
+
+    /**
+     * @brief Проверить буфер на пустоту (без блокировок)
+     * @return флаг пустоты
+     */
+    bool empty() const noexcept;
+
+    /**
+     * @brief Проверить буфер на заполненность (без блокировок)
+     * @return флаг полноты
+     */
+    bool full() const noexcept;
+
+    /**
+     * @brief Попытаться добавить элемент в буфер
+     * @param value значение элемента
+     * @return флаг успешности операции
+     */
+    template<typename Type>
+    bool try_push_back(Type&& value);
+
+    /**
+     * @brief   Добавить элемент в буфер.
+     *          Если буфер заполнен, приостановить выполнения потока
+     * @param value значение элемента
+     * @return WaitStatus::success или WaitStatus::shutdown
+     */
+    template<typename Type>
+    WaitStatus push_back_wait(Type&& value);
+
+    /**
+     * @brief   Добавить элемент в буфер, ожидая свободного места
+     *          не дольше timeout
+     * @param value   значение элемента
+     * @param timeout максимальное время ожидания
+     * @return результат операции
+     */
+    template<typename Type, typename Rep, typename Period>
+    WaitStatus push_back_wait_for(Type&& value,
+                                  const std::chrono::duration<Rep, Period>& timeout);
+
+    /**
+     * @brief   Добавить элемент в буфер, ожидая свободного места
+     *          не позже deadline
+     * @param value    значение элемента
+     * @param deadline момент окончания ожидания
+     * @return результат операции
+     */
+    template<typename Type, typename Clock, typename Duration>
+    WaitStatus push_back_wait_until(Type&& value,
+                                    const std::chrono::time_point<Clock, Duration>& deadline);
+
+    /**
+     * @brief Попытаться получить очередной элемент.
+     * @param result Ссылка на место помещения результата
+     * @return успешность операции
+     */
+    bool try_pop(T& result);
+
+    /**
+     * @brief   Получить очередной элемент.
+     *          Если буфер пуст, приостановить выполнения потока
+     * @param result Ссылка на место помещения результата
+     * @return  WaitStatus::success или WaitStatus::shutdown
+     *          (result не изменяется)
+     */
+    WaitStatus pop_wait(T& result);
+
+    /**
+     * @brief   Получить очередной элемент, ожидая данных не дольше timeout
+     * @param result  Ссылка на место помещения результата
+     * @param timeout максимальное время ожидания
+     * @return результат операции (при неудаче result не изменяется)
+     */
+    template<typename Rep, typename Period>
+    WaitStatus pop_wait_for(T& result,
+                            const std::chrono::duration<Rep, Period>& timeout);
+
+    /**
+     * @brief   Получить очередной элемент, ожидая данных не позже deadline
+     * @param result   Ссылка на место помещения результата
+     * @param deadline момент окончания ожидания
+     * @return результат операции (при неудаче result не изменяется)
+     */
+    template<typename Clock, typename Duration>
+    WaitStatus pop_wait_until(T& result,
+                              const std::chrono::time_point<Clock, Duration>& deadline);
+
+    /**
+     * @brief Очистить буфер
+     */
+    void clear();
+
+    /**
+     * @brief   Завершить работу буфера: все ожидающие и последующие
+     *          блокирующие операции возвращают WaitStatus::shutdown.
+     *          Вызывается деструктором
+     */
+    void shutdown();
+
+private:
+    /**
+     * @brief Получить очередную позицию в кольцевом буфере
+     * @param position  Текущая позиция
+     * @param n         Количество пропускаемых элементов
+     * @return новая позиция
+     */
+    size_t next(size_t position, size_t n = 1) const noexcept;
+
+    /**
+     * @brief   Записать элемент в ячейку m_tail.
+     *          Вызывается с захваченным m_push_mutex, буфер не заполнен
+     * @param value значение элемента
+     * @param tail  текущее значение m_tail
+     */
+    template<typename Type>
+    void push_locked(Type&& value, size_t tail);
+
+    /**
+     * @brief   Извлечь элемент из ячейки m_head.
+     *          Вызывается с захваченным m_pop_mutex, буфер не пуст
+     * @param result Ссылка на место помещения результата
+     * @param head   текущее значение m_head
+     */
+    void pop_locked(T& result, size_t head);
+
+    /**
+     * @brief   Добавить элемент, ожидая свободного места
+     * @param value    значение элемента
+     * @param deadline момент окончания ожидания (nullptr - без ограничения)
+     * @return результат операции
+     */
+    template<typename Type, typename Clock, typename Duration>
+    WaitStatus push_wait_impl(Type&& value,
+                              const std::chrono::time_point<Clock, Duration>* deadline);
+
+    /**
+     * @brief   Получить элемент, ожидая данных
+     * @param result   Ссылка на место помещения результата
+     * @param deadline момент окончания ожидания (nullptr - без ограничения)
+     * @return результат операции
+     */
+    template<typename Clock, typename Duration>
+    WaitStatus pop_wait_impl(T& result,
+                             const std::chrono::time_point<Clock, Duration>* deadline);
+
+    /**
+     * @brief   Разбудить читателя, если он спит.
+     *          Вызывается после публикации m_tail без m_push_mutex
+     */
+    void wake_reader();
+
+    /**
+     * @brief   Разбудить писателя, если он спит.
+     *          Вызывается после публикации m_head без m_pop_mutex
+     */
+    void wake_writer();
+};
+
+
+
+// Implementation
+
+
+
+template<typename T, typename Allocator>
+CircularBuffer_mrmw_twolock<T, Allocator>::CircularBuffer_mrmw_twolock(
+            size_t size,
+            const allocator_type& allocator
+        )
+    : m_data(size + 1, allocator) // +1 для определения "полон" / "пуст"
+    , m_pop_mutex{}
+    , m_not_empty{}
+    , m_head{0}
+    , m_waiting_readers{0}
+    , m_push_mutex{}
+    , m_not_full{}
+    , m_tail{0}
+    , m_waiting_writers{0}
+    , m_delete{false}
+{}
+
+template<typename T, typename Allocator>
+CircularBuffer_mrmw_twolock<T, Allocator>::~CircularBuffer_mrmw_twolock()
+{
+    shutdown();
+}
+
+template<typename T, typename Allocator>
+void CircularBuffer_mrmw_twolock<T, Allocator>::shutdown()
+{
+    m_delete = true;
+
+    // захват мьютексов гарантирует, что ожидающие уже в wait
+    { std::lock_guard<std::mutex> locker(m_pop_mutex); }
+    { std::lock_guard<std::mutex> locker(m_push_mutex); }
+
+    m_not_empty.notify_all();
+    m_not_full.notify_all();
+}
+
+template<typename T, typename Allocator>
+size_t CircularBuffer_mrmw_twolock<T, Allocator>::size() const noexcept
+{
+    size_t head = m_head.load(std::memory_order_acquire);
+    size_t tail = m_tail.load(std::memory_order_acquire);
+
+    if(tail < head)
+        return m_data.size() + tail - head;
+
+    return tail - head;
+}
+
+template<typename T, typename Allocator>
+size_t CircularBuffer_mrmw_twolock<T, Allocator>::max_size() const noexcept
+{
+    return m_data.size() - 1;
+}
+
+template<typename T, typename Allocator>
+bool CircularBuffer_mrmw_twolock<T, Allocator>::empty() const noexcept
+{
+    return m_head.load(std::memory_order_acquire)
+        == m_tail.load(std::memory_order_acquire);
+}
+
+template<typename T, typename Allocator>
+bool CircularBuffer_mrmw_twolock<T, Allocator>::full() const noexcept
+{
+    return m_head.load(std::memory_order_acquire)
+        == next(m_tail.load(std::memory_order_acquire));
+}
+
+template<typename T, typename Allocator>
+template<typename Type>
+bool CircularBuffer_mrmw_twolock<T, Allocator>::try_push_back(Type&& value)
+{
+    {
+        std::lock_guard<std::mutex> locker(m_push_mutex);
+
+        // m_tail меняется только под m_push_mutex
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if(next(tail) == m_head.load(std::memory_order_acquire))
+            return false;
+
+        push_locked(std::forward<Type>(value), tail);
+    }
+
+    wake_reader();
+
+    return true;
+}
+
+template<typename T, typename Allocator>
+template<typename Type>
+WaitStatus CircularBuffer_mrmw_twolock<T, Allocator>::push_back_wait(Type&& value)
+{
+    return push_wait_impl(
+                std::forward<Type>(value),
+                static_cast<const std::chrono::steady_clock::time_point*>(nullptr));
+}
+
+template<typename T, typename Allocator>
+template<typename Type, typename Rep, typename Period>
+WaitStatus CircularBuffer_mrmw_twolock<T, Allocator>::push_back_wait_for(
+            Type&& value,
+            const std::chrono::duration<Rep, Period> &timeout
+        )
+{
+    return push_back_wait_until(std::forward<Type>(value),
+                                std::chrono::steady_clock::now() + timeout);
+}
+
+template<typename T, typename Allocator>
+template<typename Type, typename Clock, typename Duration>
+WaitStatus CircularBuffer_mrmw_twolock<T, Allocator>::push_back_wait_until(
+            Type&& value,
+            const std::chrono::time_point<Clock, Duration> &deadline
+        )
+{
+    return push_wait_impl(std::forward<Type>(value), &deadline);
+}
+
+template<typename T, typename Allocator>
+template<typename Type, typename Clock, typename Duration>
+WaitStatus CircularBuffer_mrmw_twolock<T, Allocator>::push_wait_impl(
+            Type&& value,
+            const std::chrono::time_point<Clock, Duration>* deadline
+        )
+{
+    {
+        std::unique_lock<std::mutex> locker(m_push_mutex);
+
+        // m_tail перечитывается: пока поток спал, писали другие
+        auto not_full = [&]() {
+            return next(m_tail.load(std::memory_order_relaxed))
+                        != m_head.load(std::memory_order_seq_cst)
+                || m_delete;
+        };
+
+        bool ready = not_full();
+        if(! ready) {
+            // счетчик увеличивается до повторной проверки условия,
+            // чтобы читатель гарантированно увидел ожидающего
+            m_waiting_writers.fetch_add(1, std::memory_order_seq_cst);
+            if(deadline) {
+                ready = m_not_full.wait_until(locker, *deadline, not_full);
+            } else {
+                m_not_full.wait(locker, not_full);
+                ready = true;
+            }
+            m_waiting_writers.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        if(m_delete)
+            return WaitStatus::shutdown;
+
+        if(! ready)
+            return WaitStatus::timeout;
+
+        push_locked(std::forward<Type>(value),
+                    m_tail.load(std::memory_order_relaxed));
+    }
+
+    wake_reader();
+
+    return WaitStatus::success;
+}
+
+template<typename T, typename Allocator>
+bool CircularBuffer_mrmw_twolock<T, Allocator>::try_pop(T &result)
+{
+    {
+        std::lock_guard<std::mutex> locker(m_pop_mutex);
+
+        // m_head меняется только под m_pop_mutex
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if(head == m_tail.load(std::memory_order_acquire))
+            return false;
+
+        pop_locked(result, head);
+    }
+
+    wake_writer();
+
+    return true;
+}
+
+template<typename T, typename Allocator>
+WaitStatus CircularBuffer_mrmw_twolock<T, Allocator>::pop_wait(T &result)
+{
+    return pop_wait_impl(
+                result,
+                static_cast<const std::chrono::steady_clock::time_point*>(nullptr));
+}
+
+template<typename T, typename Allocator>
+template<typename Rep, typename Period>
+WaitStatus CircularBuffer_mrmw_twolock<T, Allocator>::pop_wait_for(
+            T &result,
+            const std::chrono::duration<Rep, Period> &timeout
+        )
+{
+    return pop_wait_until(result, std::chrono::steady_clock::now() + timeout);
+}
+
+template<typename T, typename Allocator>
+template<typename Clock, typename Duration>
+WaitStatus CircularBuffer_mrmw_twolock<T, Allocator>::pop_wait_until(
+            T &result,
+            const std::chrono::time_point<Clock, Duration> &deadline
+        )
+{
+    return pop_wait_impl(result, &deadline);
+}
+
+template<typename T, typename Allocator>
+template<typename Clock, typename Duration>
+WaitStatus CircularBuffer_mrmw_twolock<T, Allocator>::pop_wait_impl(
+            T &result,
+            const std::chrono::time_point<Clock, Duration>* deadline
+        )
+{
+    {
+        std::unique_lock<std::mutex> locker(m_pop_mutex);
+
+        auto not_empty = [&]() {
+            return m_head.load(std::memory_order_relaxed)
+                        != m_tail.load(std::memory_order_seq_cst)
+                || m_delete;
+        };
+
+        bool ready = not_empty();
+        if(! ready) {
+            m_waiting_readers.fetch_add(1, std::memory_order_seq_cst);
+            if(deadline) {
+                ready = m_not_empty.wait_until(locker, *deadline, not_empty);
+            } else {
+                m_not_empty.wait(locker, not_empty);
+                ready = true;
+            }
+            m_waiting_readers.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        if(m_delete)
+            return WaitStatus::shutdown;
+
+        if(! ready)
+            return WaitStatus::timeout;
+
+        pop_locked(result, m_head.load(std::memory_order_relaxed));
+    }
+
+    wake_writer();
+
+    return WaitStatus::success;
+}
+
+template<typename T, typename Allocator>
+void CircularBuffer_mrmw_twolock<T, Allocator>::clear()
+{
+    {
+        std::lock_guard<std::mutex> locker(m_pop_mutex);
+        m_head.store(m_tail.load(std::memory_order_acquire),
+                     std::memory_order_seq_cst);
+    }
+
+    if(m_waiting_writers.load(std::memory_order_seq_cst) != 0) {
+        { std::lock_guard<std::mutex> locker(m_push_mutex); }
+        m_not_full.notify_all();
+    }
+}
+
+template<typename T, typename Allocator>
+size_t CircularBuffer_mrmw_twolock<T, Allocator>::next(size_t position, size_t n) const noexcept
+{
+    return (position + n) % m_data.size();
+}
+
+template<typename T, typename Allocator>
+template<typename Type>
+void CircularBuffer_mrmw_twolock<T, Allocator>::push_locked(Type&& value, size_t tail)
+{
+    m_data[tail] = std::forward<Type>(value);
+    m_tail.store(next(tail), std::memory_order_seq_cst);
+}
+
+template<typename T, typename Allocator>
+void CircularBuffer_mrmw_twolock<T, Allocator>::pop_locked(T& result, size_t head)
+{
+    result = std::move_if_noexcept(m_data[head]);
+    m_head.store(next(head), std::memory_order_seq_cst);
+}
+
+template<typename T, typename Allocator>
+void CircularBuffer_mrmw_twolock<T, Allocator>::wake_reader()
+{
+    // Дополняет fetch_add в pop_wait (seq_cst): либо читатель увидит
+    // новый m_tail, либо писатель увидит ожидающего читателя
+    if(m_waiting_readers.load(std::memory_order_seq_cst) == 0)
+        return;
+
+    // читатель между проверкой условия и wait держит m_pop_mutex
+    { std::lock_guard<std::mutex> locker(m_pop_mutex); }
+    m_not_empty.notify_one();
+}
+
+template<typename T, typename Allocator>
+void CircularBuffer_mrmw_twolock<T, Allocator>::wake_writer()
+{
+    if(m_waiting_writers.load(std::memory_order_seq_cst) == 0)
+        return;
+
+    { std::lock_guard<std::mutex> locker(m_push_mutex); }
+    m_not_full.notify_one();
+}
+
+}
+#endif // CIRCULAR_BUFFER_TWOLOCK_MRMW_H
@@ -0,0 +1,17 @@
+#ifndef CIRCULAR_BUFFER_WAIT_STATUS_H
+#define CIRCULAR_BUFFER_WAIT_STATUS_H
+
+namespace connest {
+
+/**
+  @brief Результат блокирующей операции с буфером
+ */
+enum class WaitStatus
+{
+    success,    // операция выполнена
+    timeout,    // истекло время ожидания, буфер не изменен
+    shutdown    // буфер завершает работу (shutdown() или деструктор)
+};
+
+}
+#endif // CIRCULAR_BUFFER_WAIT_STATUS_H
@@ -0,0 +1,265 @@
+#ifndef CIRCULAR_BUFFER_WORK_STEALING_H
+#define CIRCULAR_BUFFER_WORK_STEALING_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+
+#include "circular_buffer_fwd.h"
+
+namespace connest {
+
+namespace detail {
+
+/**
+  @brief    Кольцевой массив деки с индексами без переполнения
+  @details
+        Индексы - номера операций (растут неограниченно), ячейка -
+        индекс по маске. Ячейки атомарные: вор читает ячейку до CAS по
+        top и может прочитать ее одновременно с записью владельца
+        (значение в этом случае отбрасывается).
+ */
+template<typename T>
+class steal_array final
+{
+    size_t m_mask;
+    std::unique_ptr<std::atomic<T>[]> m_cells;
+
+public:
+    explicit steal_array(size_t capacity)
+        : m_mask(capacity - 1)
+        , m_cells(new std::atomic<T>[capacity])
+    {}
+
+    size_t capacity() const noexcept
+    {
+        return m_mask + 1;
+    }
+
+    T get(int64_t index) const noexcept
+    {
+        return m_cells[static_cast<size_t>(index) & m_mask].load(std::memory_order_relaxed);
+    }
+
+    void put(int64_t index, T value) noexcept
+    {
+        m_cells[static_cast<size_t>(index) & m_mask].store(value, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Новый массив вдвое больше с элементами [top, bottom)
+     */
+    steal_array* grow(int64_t top, int64_t bottom) const
+    {
+        steal_array* result = new steal_array(capacity() * 2);
+        for(int64_t i = top; i < bottom; ++i)
+            result->put(i, get(i));
+
+        return result;
+    }
+};
+
+}
+
+/**
+  @brief    Дека с перехватом работы (Chase-Lev)
+  @details
+        Владелец добавляет и забирает элементы с нижнего конца (LIFO,
+        без атомарных операций чтения-изменения-записи, кроме борьбы за
+        последний элемент), остальные потоки перехватывают с верхнего
+        конца (FIFO) одним CAS по top. Порядок памяти - по Lê, Pop,
+        Cohen, Zappa Nardelli, "Correct and Efficient Work-Stealing for
+        Weak Memory Models" (PPoPP 2013), но барьеры seq_cst заменены
+        seq_cst операциями над самими top / bottom: ThreadSanitizer
+        барьеры не моделирует (-Wtsan), а на x86 код тот же (xchg
+        вместо mov + mfence, обычное чтение).
+
+        Когда кольцевой массив заполнен, владелец переносит элементы в
+        массив вдвое больше. Старые массивы освобождаются только в
+        деструкторе: вор мог получить указатель на них до замены.
+
+        T должен быть тривиально копируемым (обычно указатель на
+        задачу): ячейки хранятся как std::atomic<T>.
+ */
+template<typename T>
+class WorkStealingDeque final
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "WorkStealingDeque<T> requires trivially copyable T (e.g. a task pointer)");
+
+    using array_type = detail::steal_array<T>;
+
+    alignas(64) std::atomic<int64_t> m_top;     // воры
+    alignas(64) std::atomic<int64_t> m_bottom;  // владелец
+    std::atomic<array_type*> m_array;
+
+    // текущий и замененные массивы (изменяет только владелец)
+    std::vector<std::unique_ptr<array_type>> m_arrays;
+
+public:
+    /**
+     * @param capacity начальная вместимость (округляется вверх до степени 2)
+     */
+    explicit WorkStealingDeque(size_t capacity = 1024);
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque(WorkStealingDeque&&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(WorkStealingDeque&&) = delete;
+
+    /**
+     * @brief   Добавить элемент снизу. Только поток-владелец.
+     *          При заполнении массив увеличивается вдвое
+     * @param value значение элемента
+     */
+    void push(T value);
+
+    /**
+     * @brief   Забрать последний добавленный элемент. Только поток-владелец
+     * @param result место, куда будет записано значение
+     * @return  false, если дека пуста (или последний элемент перехвачен)
+     */
+    bool try_pop(T& result);
+
+    /**
+     * @brief   Перехватить самый старый элемент. Любой поток
+     * @param result место, куда будет записано значение
+     * @return  false, если дека пуста или другой поток перехватил элемент
+     *          одновременно (можно повторить или выбрать другую деку)
+     */
+    bool try_steal(T& result);
+
+    /**
+     * @brief   Получить количество элементов
+     *          (значение может сразу устареть)
+     */
+    size_t size() const noexcept;
+
+    /**
+     * @brief Проверить деку на пустоту (значение может сразу устареть)
+     */
+    bool empty() const noexcept;
+
+    /**
+     * @brief Текущая вместимость массива (только поток-владелец)
+     */
+    size_t capacity() const noexcept;
+};
+
+
+// Implementation
+
+template<typename T>
+WorkStealingDeque<T>::WorkStealingDeque(size_t capacity)
+    : m_top{0}
+    , m_bottom{0}
+    , m_array{nullptr}
+    , m_arrays{}
+{
+    size_t rounded = 1;
+    while(rounded < capacity)
+        rounded *= 2;
+
+    m_arrays.emplace_back(new array_type(rounded));
+    m_array.store(m_arrays.back().get(), std::memory_order_relaxed);
+}
+
+template<typename T>
+void WorkStealingDeque<T>::push(T value)
+{
+    int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+    int64_t top    = m_top.load(std::memory_order_acquire);
+    array_type* array = m_array.load(std::memory_order_relaxed);
+
+    if(bottom - top > static_cast<int64_t>(array->capacity()) - 1) {
+        m_arrays.emplace_back(array->grow(top, bottom));
+        array = m_arrays.back().get();
+        m_array.store(array, std::memory_order_release);
+    }
+
+    array->put(bottom, value);
+
+    // элемент виден вору, прочитавшему новое значение bottom
+    m_bottom.store(bottom + 1, std::memory_order_release);
+}
+
+template<typename T>
+bool WorkStealingDeque<T>::try_pop(T& result)
+{
+    int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+    array_type* array = m_array.load(std::memory_order_relaxed);
+    // резервирование bottom должно быть видно ворам до чтения top:
+    // обе операции seq_cst и не переставляются друг с другом
+    m_bottom.store(bottom, std::memory_order_seq_cst);
+    int64_t top = m_top.load(std::memory_order_seq_cst);
+
+    if(top > bottom) {
+        // пусто
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        return false;
+    }
+
+    T value = array->get(bottom);
+
+    if(top == bottom) {
+        // последний элемент - соревнуемся с ворами за top
+        bool won = m_top.compare_exchange_strong(top, top + 1,
+                                                 std::memory_order_seq_cst,
+                                                 std::memory_order_relaxed);
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+
+        if(! won)
+            return false;
+    }
+
+    result = value;
+    return true;
+}
+
+template<typename T>
+bool WorkStealingDeque<T>::try_steal(T& result)
+{
+    // top читается раньше bottom (seq_cst), в паре с try_pop
+    int64_t top = m_top.load(std::memory_order_seq_cst);
+    int64_t bottom = m_bottom.load(std::memory_order_seq_cst);
+
+    if(top >= bottom)
+        return false;
+
+    array_type* array = m_array.load(std::memory_order_acquire);
+    T value = array->get(top);
+
+    if(! m_top.compare_exchange_strong(top, top + 1,
+                                       std::memory_order_seq_cst,
+                                       std::memory_order_relaxed))
+        return false;
+
+    result = value;
+    return true;
+}
+
+template<typename T>
+size_t WorkStealingDeque<T>::size() const noexcept
+{
+    int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+    int64_t top    = m_top.load(std::memory_order_relaxed);
+
+    return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+}
+
+template<typename T>
+bool WorkStealingDeque<T>::empty() const noexcept
+{
+    return size() == 0;
+}
+
+template<typename T>
+size_t WorkStealingDeque<T>::capacity() const noexcept
+{
+    return m_array.load(std::memory_order_relaxed)->capacity();
+}
+
+}
+#endif // CIRCULAR_BUFFER_WORK_STEALING_H
@@ -1,157 +1,465 @@
+// Генератор нагрузки для подбора буфера:
+//
+//   CircularBuffer_example --variant mrmw --producers 4 --consumers 4
+//                          --capacity 1024 --payload heap --size 256
+//                          --rate 200000 --pattern poisson --duration 10
+//
+// Писатели кладут элементы с заданной интенсивностью, читатели забирают
+// их, пока не будет прочитано всё записанное; затем буфер завершается
+// (shutdown) и потоки присоединяются. Отчет: пропускная способность,
+// перцентили задержки от момента отправки до извлечения, процессорное
+// время на элемент.
+//
+// При заданной интенсивности задержка отсчитывается от запланированного
+// момента отправки, а не от фактического: писатель, задержанный
+// заполненным буфером, не скрывает эту задержку (coordinated omission).
+
 #include <iostream>
+#include <iomanip>
 #include <thread>
 #include <atomic>
 #include <vector>
+#include <array>
+#include <limits>
 #include <string>
-#include <sstream>
+#include <memory>
 #include <random>
-#include <cassert>
+#include <chrono>
+#include <ctime>
+#include <cstdlib>
+#include <stdexcept>
 
 #include <circular_buffer/circular_buffer_lockfree_srsw.h>
-#include <circular_buffer/circular_buffer_blocked_mrmw.h>
 #include <circular_buffer/circular_buffer_lockfree_mrmw.h>
+#include <circular_buffer/circular_buffer_blocked_mrmw.h>
+#include <circular_buffer/circular_buffer_twolock_mrmw.h>
+#include <circular_buffer/circular_buffer_combining_mrmw.h>
+#include <circular_buffer/circular_buffer_stats.h>
 
-#define READER_COUNT 4
-#define WRITER_COUNT 4
-#define ELEMENTS_COUNT 1000u
+namespace {
 
+using clock_type = std::chrono::steady_clock;
 
 
-class CrazyCopyClass {
-    std::string m_str;
-    size_t m_value;
+// Параметры
 
-    void sleepForCrazy() const {
-        std::mt19937 gen(std::random_device{}());
-        std::uniform_int_distribution<> dist(m_value % 140, 150);
-        std::this_thread::sleep_for(std::chrono::nanoseconds(dist(gen)));
-    }
+struct options
+{
+    std::string variant = "mrmw";
+    size_t producers    = 1;
+    size_t consumers    = 1;
+    size_t capacity     = 1024;
 
-public:
-    CrazyCopyClass(size_t value = 0) noexcept
-        : m_str{"It is not small string. I want to be in heap!"}
-        , m_value{value}
-    {
-        sleepForCrazy();
+    std::string payload = "trivial";
+    size_t size         = 16;
+
+    double duration     = 0;        // секунд, 0 - без ограничения
+    size_t items        = 0;        // всего элементов, 0 - без ограничения
+
+    double rate         = 0;        // элементов в секунду на всех писателей, 0 - без паузы
+    std::string pattern = "steady";
+    size_t burst        = 64;       // элементов в пачке для bursty
+};
+
+void usage(std::ostream& out)
+{
+    out << "usage: CircularBuffer_example [options]\n"
+           "  --variant   srsw|mrmw|blocked|twolock|combining  (mrmw)\n"
+           "  --producers N                                  (1)\n"
+           "  --consumers N                                  (1)\n"
+           "  --capacity  N     slots                        (1024)\n"
+           "  --payload   trivial|heap                       (trivial)\n"
+           "  --size      BYTES element size; trivial: 16, 64, 256, 1024 or 4096 (16)\n"
+           "  --duration  SEC   run time\n"
+           "  --items     N     total items (default 1000000 without --duration)\n"
+           "  --rate      N     items per second, all producers; 0 - unthrottled (0)\n"
+           "  --pattern   steady|bursty|poisson              (steady)\n"
+           "  --burst     N     items per burst for bursty   (64)\n";
+}
+
+options parse(int argc, char* argv[])
+{
+    options result;
+
+    for(int i = 1; i < argc; ++i) {
+        std::string name = argv[i];
+        std::string value;
+
+        if(name == "--help" || name == "-h") {
+            usage(std::cout);
+            std::exit(0);
+        }
+
+        size_t equal = name.find('=');
+        if(equal != std::string::npos) {
+            value = name.substr(equal + 1);
+            name.resize(equal);
+        }
+        else if(i + 1 < argc)
+            value = argv[++i];
+        else
+            throw std::invalid_argument("missing value for " + name);
+
+        if(name == "--variant")        result.variant   = value;
+        else if(name == "--producers") result.producers = std::stoul(value);
+        else if(name == "--consumers") result.consumers = std::stoul(value);
+        else if(name == "--capacity")  result.capacity  = std::stoul(value);
+        else if(name == "--payload")   result.payload   = value;
+        else if(name == "--size")      result.size      = std::stoul(value);
+        else if(name == "--duration")  result.duration  = std::stod(value);
+        else if(name == "--items")     result.items     = std::stoul(value);
+        else if(name == "--rate")      result.rate      = std::stod(value);
+        else if(name == "--pattern")   result.pattern   = value;
+        else if(name == "--burst")     result.burst     = std::stoul(value);
+        else
+            throw std::invalid_argument("unknown option " + name);
     }
 
-    CrazyCopyClass(const CrazyCopyClass& other) noexcept
-        : m_str{"It is not small string. I want to be in heap!"}
-        , m_value{other.m_value}
+    if(result.duration <= 0 && result.items == 0)
+        result.items = 1000000;
+
+    if(result.producers == 0 || result.consumers == 0 || result.capacity == 0 || result.burst == 0)
+        throw std::invalid_argument("producers, consumers, capacity and burst must be positive");
+
+    if(result.variant == "srsw" && (result.producers != 1 || result.consumers != 1))
+        throw std::invalid_argument("srsw supports one producer and one consumer");
+
+    if(result.pattern != "steady" && result.pattern != "bursty" && result.pattern != "poisson")
+        throw std::invalid_argument("unknown pattern " + result.pattern);
+
+    return result;
+}
+
+
+// Элементы: момент отправки и значение для контрольной суммы
+
+template<size_t N>
+struct trivial_payload
+{
+    int64_t stamp;
+    uint64_t value;
+    std::array<unsigned char, N - 2 * sizeof(uint64_t)> padding;
+
+    static trivial_payload make(int64_t stamp, uint64_t value, size_t)
     {
-        sleepForCrazy();
+        trivial_payload result;
+        result.stamp = stamp;
+        result.value = value;
+        result.padding.fill(0);
+        return result;
     }
-    CrazyCopyClass(CrazyCopyClass&& other) noexcept
-        : m_str{std::move(other.m_str)}
-        , m_value{other.m_value}
+};
+
+// владеет size байтами в куче; только перемещение
+struct heap_payload
+{
+    int64_t stamp = 0;
+    uint64_t value = 0;
+    std::unique_ptr<unsigned char[]> bytes{};
+
+    static heap_payload make(int64_t stamp, uint64_t value, size_t size)
     {
-        sleepForCrazy();
+        heap_payload result;
+        result.stamp = stamp;
+        result.value = value;
+        result.bytes.reset(new unsigned char[size]());
+        return result;
     }
-    ~CrazyCopyClass() = default;
+};
 
-    const std::string& str() const {
-        return m_str;
-    }
 
-    operator size_t() const {
-        return m_value;
-    }
+// Интенсивность отправки
 
-    CrazyCopyClass& operator=(const CrazyCopyClass& other) noexcept // noexcept - ВАЖЕН
+class arrival
+{
+    const options& m_options;
+    std::chrono::nanoseconds m_interval;    // средний интервал одного писателя
+    std::mt19937_64 m_random;
+    std::exponential_distribution<double> m_exponential;
+    clock_type::time_point m_next;
+    size_t m_sent;
+
+public:
+    arrival(const options& opts, size_t seed, clock_type::time_point start)
+        : m_options(opts)
+        , m_interval(opts.rate > 0
+                     ? static_cast<int64_t>(1e9 * static_cast<double>(opts.producers) / opts.rate)
+                     : 0)
+        , m_random(seed)
+        , m_exponential(1.0)
+        , m_next(start)
+        , m_sent(0)
+    {}
+
+    bool throttled() const { return m_interval.count() > 0; }
+
+    /**
+     * @brief Запланированный момент отправки очередного элемента
+     */
+    clock_type::time_point next()
     {
-        sleepForCrazy();
-        m_value = other.m_value;
-        m_str = other.m_str;
-        return *this;
+        if(! throttled())
+            return clock_type::now();
+
+        clock_type::time_point scheduled = m_next;
+        advance();
+        return scheduled;
     }
 
-    CrazyCopyClass& operator=(CrazyCopyClass&& other) noexcept // noexcept - ВАЖЕН
+    /**
+     * @brief Дождаться момента отправки: сон - до последних 100 мкс,
+     *        затем уступка процессора
+     */
+    static void wait(clock_type::time_point scheduled)
     {
-        sleepForCrazy();
-        m_value = other.m_value;
-        m_str = std::move(other.m_str);
-        return *this;
+        for(clock_type::time_point now = clock_type::now(); now < scheduled; now = clock_type::now()) {
+            if(scheduled - now > std::chrono::microseconds(200))
+                std::this_thread::sleep_for(scheduled - now - std::chrono::microseconds(100));
+            else
+                std::this_thread::yield();
+        }
     }
 
+private:
+    void advance()
+    {
+        ++m_sent;
+
+        if(m_options.pattern == "poisson")
+            m_next += std::chrono::nanoseconds(static_cast<int64_t>(
+                          m_exponential(m_random) * static_cast<double>(m_interval.count())));
+        // пачка из burst элементов подряд, затем пауза той же средней интенсивности
+        else if(m_options.pattern == "bursty") {
+            if(m_sent % m_options.burst == 0)
+                m_next += m_interval * static_cast<int64_t>(m_options.burst);
+        }
+        else
+            m_next += m_interval;
+    }
 };
 
 
+// Запуск
 
-// Собственно кольцевой буфер
-//                        хранимый тип данных
-//                          vvvvvvvvvvvvvvv
-connest::CircularBuffer_mrmw<CrazyCopyClass> queue{16};
-//                                                ^^^^
-//                               размер буфера в элементах
+struct result
+{
+    size_t produced = 0;
+    size_t consumed = 0;
+    uint64_t produced_sum = 0;
+    uint64_t consumed_sum = 0;
+
+    double seconds = 0;
+    double cpu_seconds = 0;
+    connest::latency_snapshot latency{};
+};
 
-// сумма значений считанных элементов
-std::atomic<size_t> read_counter{0};
-// сумма значений записанных элементов
-std::atomic<size_t> write_counter{0};
+void merge(connest::latency_snapshot& to, const connest::latency_snapshot& from)
+{
+    if(from.count == 0)
+        return;
 
-// количество считанных элементов
-std::atomic<size_t> amount_readed{0};
-// количество записанных элементов
-std::atomic<size_t> amount_written{0};
+    if(to.count == 0 || from.min < to.min)
+        to.min = from.min;
+    if(from.max > to.max)
+        to.max = from.max;
 
+    to.count += from.count;
+    to.total += from.total;
 
+    to.buckets.resize(from.buckets.size());
+    for(size_t i = 0; i < from.buckets.size(); ++i)
+        to.buckets[i] += from.buckets[i];
+}
 
-void reader()
+template<typename Queue, typename Payload>
+result run(const options& opts)
 {
-    /*size_t*/ CrazyCopyClass value{0};
-    while(true) {
-        if(queue.try_pop(value)) {
-            ++amount_readed;
-            read_counter += value;
-        }
-    }
-
+    Queue queue(opts.capacity);
+
+    std::atomic<size_t> produced{0};
+    std::atomic<size_t> consumed{0};
+    std::atomic<uint64_t> producedSum{0};
+    std::atomic<uint64_t> consumedSum{0};
+
+    // у каждого читателя своя гистограмма
+    std::vector<std::unique_ptr<connest::latency_histogram>> histograms;
+    for(size_t c = 0; c < opts.consumers; ++c)
+        histograms.emplace_back(new connest::latency_histogram());
+
+    std::vector<std::thread> producers;
+    std::vector<std::thread> consumers;
+
+    const std::clock_t cpuStart = std::clock();
+    const clock_type::time_point start = clock_type::now();
+    const clock_type::time_point deadline = opts.duration > 0
+            ? start + std::chrono::duration_cast<clock_type::duration>(
+                  std::chrono::duration<double>(opts.duration))
+            : clock_type::time_point::max();
+
+    for(size_t c = 0; c < opts.consumers; ++c)
+        consumers.emplace_back([&, c]() {
+            connest::latency_histogram& histogram = *histograms[c];
+            Payload item{};
+            uint64_t sum = 0;
+
+            while(queue.pop_wait(item) == connest::WaitStatus::success) {
+                histogram.record(static_cast<uint64_t>(
+                        clock_type::now().time_since_epoch().count() - item.stamp));
+                sum += item.value;
+                consumed.fetch_add(1, std::memory_order_release);
+            }
+
+            consumedSum.fetch_add(sum, std::memory_order_relaxed);
+        });
+
+    for(size_t p = 0; p < opts.producers; ++p)
+        producers.emplace_back([&, p]() {
+            // элементы делятся между писателями поровну
+            size_t quota = opts.items == 0
+                    ? std::numeric_limits<size_t>::max()
+                    : opts.items / opts.producers + (p < opts.items % opts.producers ? 1 : 0);
+
+            arrival schedule(opts, p + 1, start);
+            uint64_t sum = 0;
+            size_t sent = 0;
+
+            for(; sent < quota; ++sent) {
+                clock_type::time_point at = schedule.next();
+                if(at >= deadline)
+                    break;
+                arrival::wait(at);
+
+                uint64_t value = sent * opts.producers + p;
+                queue.push_back_wait(Payload::make(at.time_since_epoch().count(), value, opts.size));
+                sum += value;
+            }
+
+            producedSum.fetch_add(sum, std::memory_order_relaxed);
+            produced.fetch_add(sent, std::memory_order_release);
+        });
+
+    for(auto& producer : producers)
+        producer.join();
+
+    // читатели дочитывают всё записанное, затем завершаются
+    while(consumed.load(std::memory_order_acquire) < produced.load(std::memory_order_acquire))
+        std::this_thread::yield();
+
+    const clock_type::time_point stop = clock_type::now();
+    const std::clock_t cpuStop = std::clock();
+
+    queue.shutdown();
+    for(auto& consumer : consumers)
+        consumer.join();
+
+    result r;
+    r.produced     = produced.load();
+    r.consumed     = consumed.load();
+    r.produced_sum = producedSum.load();
+    r.consumed_sum = consumedSum.load();
+    r.seconds      = std::chrono::duration<double>(stop - start).count();
+    r.cpu_seconds  = static_cast<double>(cpuStop - cpuStart) / CLOCKS_PER_SEC;
+
+    for(auto& histogram : histograms)
+        merge(r.latency, histogram->snapshot());
+
+    return r;
 }
 
-void writter()
+template<typename Payload>
+result run_variant(const options& opts)
 {
-    for(size_t i = 1; i < ELEMENTS_COUNT;) {
+    if(opts.variant == "srsw")
+        return run<connest::CircularBuffer_srsw<Payload>, Payload>(opts);
+    if(opts.variant == "mrmw")
+        return run<connest::CircularBuffer_mrmw<Payload>, Payload>(opts);
+    if(opts.variant == "blocked")
+        return run<connest::CircularBuffer_mrmw_blocked<Payload>, Payload>(opts);
+    if(opts.variant == "twolock")
+        return run<connest::CircularBuffer_mrmw_twolock<Payload>, Payload>(opts);
+    if(opts.variant == "combining")
+        return run<connest::CircularBuffer_mrmw_combining<Payload>, Payload>(opts);
+
+    throw std::invalid_argument("unknown variant " + opts.variant);
+}
 
-        CrazyCopyClass value{i};
-        if(queue.try_push_back(value)) {
-            write_counter += i;
-            ++i;
-            ++amount_written;
-        }
-        assert(!value.str().empty());
+result run_payload(const options& opts)
+{
+    if(opts.payload == "heap")
+        return run_variant<heap_payload>(opts);
+
+    if(opts.payload != "trivial")
+        throw std::invalid_argument("unknown payload " + opts.payload);
+
+    switch(opts.size) {
+    case 16:   return run_variant<trivial_payload<16>>(opts);
+    case 64:   return run_variant<trivial_payload<64>>(opts);
+    case 256:  return run_variant<trivial_payload<256>>(opts);
+    case 1024: return run_variant<trivial_payload<1024>>(opts);
+    case 4096: return run_variant<trivial_payload<4096>>(opts);
+    default:
+        throw std::invalid_argument("trivial payload size must be 16, 64, 256, 1024 or 4096");
     }
-
-    std::stringstream s;
-    s << "writter end with: " << write_counter;
-    std::cout << s.str() << std::endl;
 }
 
-int main()
+void report(const options& opts, const result& r)
 {
-    std::vector<std::thread> writters;
-    std::vector<std::thread> readers;
-
-    writters.reserve(WRITER_COUNT);
-    for(int i = 0; i < WRITER_COUNT; ++i)
-        writters.emplace_back(writter);
+    const double items = r.consumed == 0 ? 1.0 : static_cast<double>(r.consumed);
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "variant:     " << opts.variant << " " << opts.producers << ":" << opts.consumers
+              << ", capacity " << opts.capacity << "\n"
+              << "payload:     " << opts.payload << " " << opts.size << " B\n"
+              << "arrival:     " << (opts.rate > 0 ? opts.pattern : "unthrottled");
+    if(opts.rate > 0)
+        std::cout << " " << opts.rate << " items/s";
+    std::cout << "\n"
+              << "items:       " << r.consumed << " in " << std::setprecision(3) << r.seconds << " s\n"
+              << std::setprecision(0)
+              << "throughput:  " << static_cast<double>(r.consumed) / r.seconds << " items/s\n"
+              << "latency ns:  min " << r.latency.min.count()
+              << "  p50 "   << r.latency.percentile(50).count()
+              << "  p90 "   << r.latency.percentile(90).count()
+              << "  p99 "   << r.latency.percentile(99).count()
+              << "  p99.9 " << r.latency.percentile(99.9).count()
+              << "  max "   << r.latency.max.count()
+              << "  mean "  << r.latency.mean().count() << "\n"
+              << std::setprecision(1)
+              << "cpu:         " << r.cpu_seconds * 1e9 / items << " ns/item, "
+              << 100.0 * r.cpu_seconds / r.seconds << "% of one core\n";
+}
 
-    readers.reserve(READER_COUNT);
-    for(int i = 0; i < READER_COUNT; ++i)
-        readers.emplace_back(reader);
+}
 
-    // не ждем читателей
-    for(auto& r : readers)
-        r.detach();
+int main(int argc, char* argv[])
+{
+    options opts;
+    try {
+        opts = parse(argc, argv);
+    }
+    catch(const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        usage(std::cerr);
+        return 2;
+    }
 
-    // ждем пока допишут писатели
-    for(auto& w : writters)
-        w.join();
+    result r;
+    try {
+        r = run_payload(opts);
+    }
+    catch(const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 2;
+    }
 
-    // чтобы читатели успели дочитать (но, и прочитать слишком много, если в алгоритме ошибка)
-    std::this_thread::sleep_for(std::chrono::seconds(3));
+    report(opts, r);
 
-    assert(read_counter  == write_counter);
-    assert(amount_readed == amount_written);
+    // все записанные элементы прочитаны ровно один раз
+    if(r.consumed != r.produced || r.consumed_sum != r.produced_sum) {
+        std::cerr << "mismatch: produced " << r.produced << " (sum " << r.produced_sum << "), "
+                  << "consumed " << r.consumed << " (sum " << r.consumed_sum << ")\n";
+        return 1;
+    }
 
     return 0;
 }
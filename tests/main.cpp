@@ -1,6 +1,17 @@
+#include "tst_circular_buffer_basic.h"
 #include "tst_circular_buffer_lockfree_mrmw.h"
 #include "tst_circular_buffer_blocked_mrmw.h"
+#include "tst_circular_buffer_combining_mrmw.h"
+#include "tst_circular_buffer_coro.h"
+#include "tst_circular_buffer_executor.h"
+#include "tst_circular_buffer_fanin_srmw.h"
 #include "tst_circular_buffer_lockfree_srsw.h"
+#include "tst_circular_buffer_partitioned_mrmw.h"
+#include "tst_circular_buffer_sharded_mrmw.h"
+#include "tst_circular_buffer_staging.h"
+#include "tst_circular_buffer_token.h"
+#include "tst_circular_buffer_twolock_mrmw.h"
+#include "tst_circular_buffer_work_stealing.h"
 
 #include <gtest/gtest.h>
 
@@ -0,0 +1,174 @@
+#ifndef STRESS_HISTORY_H
+#define STRESS_HISTORY_H
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <unordered_map>
+#include <cstdint>
+
+namespace stress {
+
+/**
+ * @brief   Момент времени для границ операции.
+ *          Монотонные часы, а не общий атомарный счетчик: счетчик
+ *          синхронизировал бы потоки и скрывал от ThreadSanitizer
+ *          недостающий порядок памяти в проверяемом буфере
+ */
+inline int64_t now() noexcept
+{
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    int64_t result = std::chrono::steady_clock::now().time_since_epoch().count();
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    return result;
+}
+
+/**
+ * @brief Операция: вызов, возврат и значение (уникальное для добавлений)
+ */
+struct operation
+{
+    int64_t invoke;
+    int64_t response;
+    uint64_t value;
+};
+
+/**
+ * @brief Журнал операций над очередью (объединение журналов потоков)
+ */
+struct history
+{
+    std::vector<operation> pushes;      // успешные добавления
+    std::vector<operation> pops;        // успешные извлечения
+    std::vector<operation> empty_pops;  // неудачные try_pop
+
+    void append(const history& other)
+    {
+        pushes    .insert(pushes    .end(), other.pushes    .begin(), other.pushes    .end());
+        pops      .insert(pops      .end(), other.pops      .begin(), other.pops      .end());
+        empty_pops.insert(empty_pops.end(), other.empty_pops.begin(), other.empty_pops.end());
+    }
+};
+
+
+/**
+  @brief    Проверка линеаризуемости журнала FIFO-очереди
+  @details
+        Для очереди с уникальными значениями журнал линеаризуем,
+        если в нем нет нарушений следующих видов (Henzinger и др.,
+        "Aspect-Oriented Linearizability Proofs"):
+          - извлечено значение, которое не добавлялось, или дважды;
+          - добавленное значение потеряно (после полного вычитывания);
+          - извлечение завершилось раньше начала добавления;
+          - порядок: add(a) завершилось до начала add(b), но
+            pop(b) завершилось до начала pop(a);
+          - пустота: try_pop вернул false, хотя некоторое значение
+            гарантированно находилось в очереди все время вызова
+            (добавлено до начала, извлечение началось после конца).
+
+        Последняя проверка отключается для буферов с несколькими
+        писателями на основе ring_side: завершенная запись невидима,
+        пока не завершены записи, захватившие позиции раньше.
+
+        Проверки порядка и пустоты - O(n log n): значения сортируются
+        по завершению добавления, для префикса хранится наибольшее
+        начало извлечения.
+  @return   пустая строка или описание первого нарушения
+ */
+inline std::string check(const history& log, bool check_empty)
+{
+    struct element
+    {
+        operation push;
+        operation pop;
+        bool popped;
+    };
+
+    std::ostringstream error;
+
+    std::unordered_map<uint64_t, size_t> index;
+    std::vector<element> elements;
+    elements.reserve(log.pushes.size());
+
+    for(const operation& push : log.pushes) {
+        if(! index.emplace(push.value, elements.size()).second) {
+            error << "value " << push.value << " added twice (test bug)";
+            return error.str();
+        }
+        elements.push_back(element{push, operation{0, 0, 0}, false});
+    }
+
+    for(const operation& pop : log.pops) {
+        auto found = index.find(pop.value);
+        if(found == index.end()) {
+            error << "popped value " << pop.value << " was never added";
+            return error.str();
+        }
+
+        element& e = elements[found->second];
+        if(e.popped) {
+            error << "value " << pop.value << " popped twice";
+            return error.str();
+        }
+        if(pop.response < e.push.invoke) {
+            error << "value " << pop.value << " popped before it was added";
+            return error.str();
+        }
+
+        e.pop = pop;
+        e.popped = true;
+    }
+
+    for(const element& e : elements)
+        if(! e.popped) {
+            error << "value " << e.push.value << " lost";
+            return error.str();
+        }
+
+    // по завершению добавления
+    std::sort(elements.begin(), elements.end(), [](const element& a, const element& b) {
+        return a.push.response < b.push.response;
+    });
+
+    // latest[i] - элемент с наибольшим началом извлечения среди первых i + 1
+    std::vector<size_t> latest(elements.size());
+    for(size_t i = 0; i < elements.size(); ++i)
+        latest[i] = (i == 0 || elements[i].pop.invoke > elements[latest[i - 1]].pop.invoke)
+                  ? i : latest[i - 1];
+
+    // элемент с наибольшим началом извлечения среди добавленных строго до moment
+    auto latest_before = [&](int64_t moment) -> const element* {
+        auto end = std::lower_bound(elements.begin(), elements.end(), moment,
+                                    [](const element& e, int64_t t) { return e.push.response < t; });
+        if(end == elements.begin())
+            return nullptr;
+        return &elements[latest[static_cast<size_t>(end - elements.begin()) - 1]];
+    };
+
+    for(const element& b : elements) {
+        const element* a = latest_before(b.push.invoke);
+        if(a && b.pop.response < a->pop.invoke) {
+            error << "FIFO violated: " << a->push.value << " added before " << b.push.value
+                  << ", but popped after it";
+            return error.str();
+        }
+    }
+
+    if(check_empty)
+        for(const operation& pop : log.empty_pops) {
+            const element* a = latest_before(pop.invoke);
+            if(a && a->pop.invoke > pop.response) {
+                error << "try_pop failed while value " << a->push.value << " was in the queue";
+                return error.str();
+            }
+        }
+
+    return std::string();
+}
+
+}
+
+#endif // STRESS_HISTORY_H
@@ -11,9 +11,20 @@ LIBS += -lgcov
 QMAKE_CXXFLAGS += -fprofile-arcs -ftest-coverage
 
 HEADERS += \
+        tst_circular_buffer_basic.h \
         tst_circular_buffer_blocked_mrmw.h \
+        tst_circular_buffer_combining_mrmw.h \
+        tst_circular_buffer_coro.h \
+        tst_circular_buffer_executor.h \
+        tst_circular_buffer_fanin_srmw.h \
         tst_circular_buffer_lockfree_mrmw.h \
-        tst_circular_buffer_lockfree_srsw.h
+        tst_circular_buffer_lockfree_srsw.h \
+        tst_circular_buffer_partitioned_mrmw.h \
+        tst_circular_buffer_sharded_mrmw.h \
+        tst_circular_buffer_staging.h \
+        tst_circular_buffer_token.h \
+        tst_circular_buffer_twolock_mrmw.h \
+        tst_circular_buffer_work_stealing.h
 
 SOURCES += \
         main.cpp
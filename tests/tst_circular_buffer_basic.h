@@ -0,0 +1,653 @@
+#ifndef TST_CIRCULAR_BUFFER_BASIC_H
+#define TST_CIRCULAR_BUFFER_BASIC_H
+
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+using namespace testing;
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+
+#include <circular_buffer/circular_buffer_fwd.h>
+#include <circular_buffer/circular_buffer_basic.h>
+#include <circular_buffer/circular_buffer_blocked_mrmw.h>
+#include <circular_buffer/circular_buffer_twolock_mrmw.h>
+#include <circular_buffer/circular_buffer_pmr.h>
+
+
+// Аллокатор, считающий выделенные элементы (для проверки rebind)
+template<typename U>
+struct counting_allocator
+{
+    using value_type = U;
+
+    size_t* allocated;
+
+    explicit counting_allocator(size_t* counter) : allocated{counter} {}
+
+    template<typename V>
+    counting_allocator(const counting_allocator<V>& other) : allocated{other.allocated} {}
+
+    U* allocate(size_t n)
+    {
+        *allocated += n;
+        return std::allocator<U>().allocate(n);
+    }
+
+    void deallocate(U* p, size_t n)
+    {
+        *allocated -= n;
+        std::allocator<U>().deallocate(p, n);
+    }
+
+    template<typename V>
+    bool operator==(const counting_allocator<V>& other) const { return allocated == other.allocated; }
+    template<typename V>
+    bool operator!=(const counting_allocator<V>& other) const { return allocated != other.allocated; }
+};
+
+
+TEST(circular_buffer_basic_tests, mpsc_park_wait)
+{
+    // Arrange
+
+    connest::basic_circular_buffer<int,
+                                   connest::multi_producer,
+                                   connest::single_consumer,
+                                   connest::park_wait> cb(4);
+
+    const int writers = 4;
+    const int per_writer = 500;
+
+    std::vector<std::thread> threads;
+    for(int w = 0; w < writers; ++w)
+        threads.emplace_back([&cb, w, per_writer]() {
+            for(int i = 0; i < per_writer; ++i)
+                cb.push_back_wait(w * per_writer + i);
+        });
+
+    // Act
+
+    std::vector<int> result;
+    for(int i = 0; i < writers * per_writer; ++i) {
+        int value{};
+        ASSERT_EQ(cb.pop_wait(value), connest::WaitStatus::success);
+        result.push_back(value);
+    }
+
+    for(auto& thread : threads)
+        thread.join();
+
+    // Assert
+
+    std::vector<int> expected(writers * per_writer);
+    std::iota(expected.begin(), expected.end(), 0);
+    std::sort(result.begin(), result.end());
+
+    ASSERT_EQ(result, expected);
+    ASSERT_TRUE(cb.empty());
+}
+
+TEST(circular_buffer_basic_tests, spmc_spin_wait)
+{
+    // Arrange
+
+    connest::basic_circular_buffer<int,
+                                   connest::single_producer,
+                                   connest::multi_consumer> cb(4);
+
+    const int readers = 3;
+    const int total = 900;
+
+    std::vector<std::vector<int>> parts(readers);
+    std::vector<std::thread> threads;
+    for(int r = 0; r < readers; ++r)
+        threads.emplace_back([&cb, &parts, r, total, readers]() {
+            for(int i = 0; i < total / readers; ++i) {
+                int value{};
+                cb.pop_wait(value);
+                parts[r].push_back(value);
+            }
+        });
+
+    // Act
+
+    for(int i = 0; i < total; ++i)
+        cb.push_back_wait(i);
+
+    for(auto& thread : threads)
+        thread.join();
+
+    // Assert
+
+    std::vector<int> result;
+    for(auto& part : parts) {
+        ASSERT_TRUE(std::is_sorted(part.begin(), part.end()));
+        result.insert(result.end(), part.begin(), part.end());
+    }
+
+    std::sort(result.begin(), result.end());
+
+    std::vector<int> expected(total);
+    std::iota(expected.begin(), expected.end(), 0);
+    ASSERT_EQ(result, expected);
+}
+
+TEST(circular_buffer_basic_tests, park_wait_for_timeout)
+{
+    // Arrange
+
+    connest::basic_circular_buffer<int,
+                                   connest::single_producer,
+                                   connest::single_consumer,
+                                   connest::park_wait> cb(1);
+    cb.try_push_back(1);
+
+    // Act
+
+    auto push_status = cb.push_back_wait_for(2, std::chrono::milliseconds(20));
+
+    int value{};
+    cb.try_pop(value);
+    auto pop_status = cb.pop_wait_for(value, std::chrono::milliseconds(20));
+
+    // Assert
+
+    ASSERT_EQ(push_status, connest::WaitStatus::timeout);
+    ASSERT_EQ(pop_status, connest::WaitStatus::timeout);
+    ASSERT_EQ(value, 1);
+}
+
+TEST(circular_buffer_basic_tests, park_shutdown_wakes_reader)
+{
+    // Arrange
+
+    connest::basic_circular_buffer<int,
+                                   connest::multi_producer,
+                                   connest::multi_consumer,
+                                   connest::park_wait> cb(2);
+
+    connest::WaitStatus status = connest::WaitStatus::success;
+    std::thread reader([&cb, &status]() {
+        int value{};
+        status = cb.pop_wait(value);
+    });
+
+    // Act
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    cb.shutdown();
+    reader.join();
+
+    // Assert
+
+    ASSERT_EQ(status, connest::WaitStatus::shutdown);
+}
+
+TEST(circular_buffer_basic_tests, inline_storage)
+{
+    // Arrange
+
+    connest::basic_circular_buffer<int,
+                                   connest::single_producer,
+                                   connest::single_consumer,
+                                   connest::spin_wait,
+                                   connest::inline_storage<int, 4>> cb(4);
+
+    // Act
+
+    for(int i = 0; i < 6; ++i)
+        cb.try_push_back(i);
+
+    // Assert
+
+    ASSERT_TRUE(cb.full());
+    ASSERT_THAT(std::vector<int>(cb.begin(), cb.end()), ElementsAre(0, 1, 2, 3));
+}
+
+TEST(circular_buffer_basic_tests, inline_storage_too_large)
+{
+    using buffer_t = connest::basic_circular_buffer<int,
+                                                    connest::single_producer,
+                                                    connest::single_consumer,
+                                                    connest::spin_wait,
+                                                    connest::inline_storage<int, 4>>;
+
+    ASSERT_THROW(buffer_t(5), std::length_error);
+}
+
+TEST(circular_buffer_basic_tests, mmap_storage)
+{
+    // Arrange
+
+    connest::basic_circular_buffer<std::string,
+                                   connest::single_producer,
+                                   connest::single_consumer,
+                                   connest::spin_wait,
+                                   connest::mmap_storage<std::string>> cb(3);
+
+    // Act
+
+    cb.try_push_back(std::string("a"));
+    cb.try_push_back(std::string("b"));
+    cb.try_push_back(std::string("c"));
+    bool pushed = cb.try_push_back(std::string("d"));
+
+    std::vector<std::string> result;
+    cb.pop_all(result);
+
+    // Assert
+
+    ASSERT_FALSE(pushed);
+    ASSERT_THAT(result, ElementsAre("a", "b", "c"));
+}
+
+TEST(circular_buffer_basic_tests, blocked_mmap_storage_resize)
+{
+    // Arrange
+
+    connest::basic_circular_buffer<int,
+                                   connest::multi_producer,
+                                   connest::multi_consumer,
+                                   connest::block_wait,
+                                   connest::mmap_storage<int>> cb(2);
+    cb.try_push_back(1);
+    cb.try_push_back(2);
+
+    // Act
+
+    bool resized = cb.resize(4);
+    cb.try_push_back(3);
+
+    std::vector<int> result;
+    int value{};
+    while(cb.try_pop(value))
+        result.push_back(value);
+
+    // Assert
+
+    ASSERT_TRUE(resized);
+    ASSERT_EQ(cb.max_size(), 4u);
+    ASSERT_THAT(result, ElementsAre(1, 2, 3));
+}
+
+TEST(circular_buffer_basic_tests, multi_consumer_clear)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw<int> cb(4);
+    cb.try_push_back(1);
+    cb.try_push_back(2);
+
+    // Act
+
+    cb.clear();
+
+    // Assert
+
+    ASSERT_TRUE(cb.empty());
+    ASSERT_TRUE(cb.try_push_back(3));
+    ASSERT_EQ(cb.size(), 1u);
+}
+
+TEST(circular_buffer_basic_tests, allocator_rebind)
+{
+    // Arrange
+
+    size_t allocated = 0;
+    counting_allocator<char> allocator(&allocated);
+
+    // Act
+
+    {
+        connest::CircularBuffer_mrmw_blocked<int, counting_allocator<char>> cb(8, allocator);
+        cb.try_push_back(1);
+        cb.resize(16);
+
+        // Assert
+
+        ASSERT_EQ(allocated, 17u);
+
+        connest::CircularBuffer_mrmw_twolock<int, counting_allocator<char>> cb2(4, allocator);
+        ASSERT_EQ(allocated, 17u + 5u);
+    }
+
+    ASSERT_EQ(allocated, 0u);
+}
+
+TEST(circular_buffer_basic_tests, mmap_huge_pages_prefault)
+{
+    // Arrange
+
+    connest::mmap_options options;
+    options.pages    = connest::huge_pages::hugetlb;
+    options.prefault = true;
+    options.lock     = true;
+
+    connest::basic_circular_buffer<int,
+                                   connest::single_producer,
+                                   connest::single_consumer,
+                                   connest::spin_wait,
+                                   connest::mmap_storage<int>> cb(1000, connest::mmap_allocator<int>(options));
+
+    // Act
+
+    for(int i = 0; i < 1000; ++i)
+        cb.try_push_back(i);
+
+    const connest::mapping_info& mapping = cb.storage().mapping();
+
+    // Assert
+
+    // без зарезервированных больших страниц - откат на THP / обычные
+    ASSERT_NE(mapping.backing, connest::page_backing::heap);
+    ASSERT_TRUE(mapping.prefaulted);
+    ASSERT_EQ(mapping.bytes % (2 * 1024 * 1024), 0u);
+    ASSERT_EQ(cb.at(999), 999);
+}
+
+TEST(circular_buffer_basic_tests, mmap_allocator_in_vector_storage)
+{
+    // Arrange
+
+    connest::mmap_options options;
+    options.pages = connest::huge_pages::transparent;
+
+    connest::CircularBuffer_mrmw_blocked<int, connest::mmap_allocator<int>> cb(4, connest::mmap_allocator<int>(options));
+
+    // Act
+
+    cb.try_push_back(1);
+    cb.resize(64);
+
+    int value{};
+    cb.try_pop(value);
+
+    // Assert
+
+    ASSERT_EQ(value, 1);
+    ASSERT_EQ(cb.get_allocator().options().pages, connest::huge_pages::transparent);
+}
+
+TEST(circular_buffer_basic_tests, stats_disabled)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw<int> cb(2);
+
+    // Act
+
+    cb.try_push_back(1);
+    connest::buffer_stats stats = cb.stats();
+
+    // Assert
+
+    ASSERT_EQ(stats.pushes, 0u);
+    ASSERT_EQ(stats.high_water, 0u);
+}
+
+TEST(circular_buffer_basic_tests, stats_counters)
+{
+    // Arrange
+
+    connest::basic_circular_buffer<int,
+                                   connest::multi_producer,
+                                   connest::multi_consumer,
+                                   connest::spin_wait,
+                                   connest::vector_storage<int>,
+                                   connest::count_stats> cb(2);
+
+    // Act
+
+    cb.try_push_back(1);
+    cb.try_push_back(2);
+    cb.try_push_back(3);
+
+    int value{};
+    cb.try_pop(value);
+    cb.try_pop(value);
+    cb.try_pop(value);
+
+    connest::buffer_stats stats = cb.stats();
+
+    // Assert
+
+    ASSERT_EQ(stats.pushes, 2u);
+    ASSERT_EQ(stats.push_full, 1u);
+    ASSERT_EQ(stats.pops, 2u);
+    ASSERT_EQ(stats.pop_empty, 1u);
+    ASSERT_EQ(stats.high_water, 2u);
+}
+
+TEST(circular_buffer_basic_tests, stats_concurrent)
+{
+    // Arrange
+
+    const size_t count = 10000;
+    connest::basic_circular_buffer<size_t,
+                                   connest::multi_producer,
+                                   connest::multi_consumer,
+                                   connest::park_wait,
+                                   connest::vector_storage<size_t>,
+                                   connest::count_stats> cb(16);
+
+    // Act
+
+    std::vector<std::thread> threads;
+    for(int i = 0; i < 2; ++i) {
+        threads.emplace_back([&cb, count]() {
+            for(size_t n = 0; n < count; ++n)
+                cb.push_back_wait(n);
+        });
+        threads.emplace_back([&cb, count]() {
+            size_t value{};
+            for(size_t n = 0; n < count; ++n)
+                cb.pop_wait(value);
+        });
+    }
+
+    for(auto& t : threads)
+        t.join();
+
+    connest::buffer_stats stats = cb.stats();
+
+    // Assert
+
+    ASSERT_EQ(stats.pushes, 2 * count);
+    ASSERT_EQ(stats.pops, 2 * count);
+    ASSERT_LE(stats.high_water, 16u);
+    ASSERT_GE(stats.wait_time, std::chrono::nanoseconds(0));
+}
+
+TEST(circular_buffer_basic_tests, blocked_stats_wait_time)
+{
+    // Arrange
+
+    connest::basic_circular_buffer<int,
+                                   connest::multi_producer,
+                                   connest::multi_consumer,
+                                   connest::block_wait,
+                                   connest::vector_storage<int>,
+                                   connest::count_stats> cb(4);
+
+    // Act
+
+    std::thread writter([&cb]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        cb.try_push_back(1);
+    });
+
+    int value{};
+    cb.pop_wait(value);
+    writter.join();
+
+    connest::buffer_stats stats = cb.stats();
+
+    // Assert
+
+    ASSERT_EQ(stats.pushes, 1u);
+    ASSERT_EQ(stats.pops, 1u);
+    ASSERT_EQ(stats.high_water, 1u);
+    ASSERT_GE(stats.waits, 1u);
+    ASSERT_GE(stats.max_wait, std::chrono::milliseconds(10));
+    ASSERT_GE(stats.wait_time, stats.max_wait);
+}
+
+TEST(circular_buffer_basic_tests, dwell_histogram_index)
+{
+    // Arrange
+
+    using histogram = connest::latency_histogram;
+
+    // Act, Assert
+
+    for(uint64_t value : {0ull, 1ull, 15ull, 16ull, 17ull, 31ull, 32ull, 1000ull,
+                          123456789ull, ~0ull}) {
+        unsigned index = histogram::index(value);
+        ASSERT_LT(index, unsigned(histogram::bucket_count));
+        ASSERT_GE(histogram::upper_bound(index), value);
+        if(index > 0) {
+            ASSERT_LT(histogram::upper_bound(index - 1), value);
+        }
+    }
+}
+
+TEST(circular_buffer_basic_tests, dwell_srsw)
+{
+    // Arrange
+
+    connest::basic_circular_buffer<int,
+                                   connest::single_producer,
+                                   connest::single_consumer,
+                                   connest::spin_wait,
+                                   connest::vector_storage<int>,
+                                   connest::dwell_stats<>> cb(8);
+
+    // Act
+
+    cb.try_push_back(1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    cb.try_push_back(2);
+
+    int value{};
+    cb.try_pop(value);
+    cb.try_pop(value);
+
+    connest::latency_snapshot first = cb.dwell_times(true);
+    connest::latency_snapshot second = cb.dwell_times();
+
+    // Assert
+
+    ASSERT_EQ(value, 2);
+    ASSERT_EQ(first.count, 2u);
+    ASSERT_GE(first.max, std::chrono::milliseconds(20));
+    ASSERT_LT(first.min, std::chrono::milliseconds(20));
+    ASSERT_GE(first.percentile(100), std::chrono::milliseconds(20));
+    ASSERT_LT(first.percentile(50), std::chrono::milliseconds(20));
+    ASSERT_EQ(second.count, 0u);
+    ASSERT_EQ(cb.stats().pops, 2u);
+}
+
+TEST(circular_buffer_basic_tests, dwell_mrmw_tsc)
+{
+    // Arrange
+
+    const size_t count = 5000;
+    connest::basic_circular_buffer<size_t,
+                                   connest::multi_producer,
+                                   connest::multi_consumer,
+                                   connest::park_wait,
+                                   connest::vector_storage<size_t>,
+                                   connest::dwell_stats<connest::tsc_clock>> cb(32);
+
+    // Act
+
+    std::vector<std::thread> threads;
+    for(int i = 0; i < 2; ++i) {
+        threads.emplace_back([&cb, count]() {
+            for(size_t n = 0; n < count; ++n)
+                cb.push_back_wait(n);
+        });
+        threads.emplace_back([&cb, count]() {
+            size_t value{};
+            for(size_t n = 0; n < count; ++n)
+                cb.pop_wait(value);
+        });
+    }
+
+    for(auto& t : threads)
+        t.join();
+
+    connest::latency_snapshot dwell = cb.dwell_times();
+
+    // Assert
+
+    ASSERT_EQ(dwell.count, 2 * count);
+    ASSERT_LE(dwell.percentile(50), dwell.percentile(99));
+    ASSERT_LE(dwell.percentile(99), dwell.max);
+    ASSERT_LE(dwell.min, dwell.mean());
+}
+
+TEST(circular_buffer_basic_tests, dwell_blocked_resize)
+{
+    // Arrange
+
+    connest::basic_circular_buffer<int,
+                                   connest::multi_producer,
+                                   connest::multi_consumer,
+                                   connest::block_wait,
+                                   connest::vector_storage<int>,
+                                   connest::dwell_stats<>> cb(2);
+
+    // Act
+
+    cb.try_push_back(1);
+    cb.try_push_back(2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    cb.resize(8);
+    cb.try_push_back(3);
+
+    std::vector<int> values;
+    cb.pop_wait_all(values);
+
+    connest::latency_snapshot dwell = cb.dwell_times();
+
+    // Assert
+
+    ASSERT_THAT(values, ElementsAre(1, 2, 3));
+    ASSERT_EQ(dwell.count, 3u);
+    // время добавления перенесено вместе с элементами
+    ASSERT_GE(dwell.percentile(60), std::chrono::milliseconds(20));
+    ASSERT_LT(dwell.min, std::chrono::milliseconds(20));
+}
+
+#ifdef CIRCULAR_BUFFER_HAS_PMR
+TEST(circular_buffer_basic_tests, pmr_arena)
+{
+    // Arrange
+
+    alignas(std::max_align_t) char arena[1024];
+    std::pmr::monotonic_buffer_resource resource(arena, sizeof(arena),
+                                                 std::pmr::null_memory_resource());
+
+    // Act
+
+    connest::pmr::CircularBuffer_srsw<int> cb(8, &resource);
+    for(int i = 0; i < 4; ++i)
+        cb.try_push_back(i);
+
+    // Assert
+
+    ASSERT_EQ(cb.get_allocator().resource(), &resource);
+    ASSERT_GE(reinterpret_cast<char*>(&cb.at(0)), arena);
+    ASSERT_LT(reinterpret_cast<char*>(&cb.at(0)), arena + sizeof(arena));
+    ASSERT_THAT(std::vector<int>(cb.begin(), cb.end()), ElementsAre(0, 1, 2, 3));
+}
+#endif
+
+#endif // TST_CIRCULAR_BUFFER_BASIC_H
@@ -3,6 +3,8 @@
 
 
 #include <thread>
+#include <vector>
+#include <atomic>
 #include <gtest/gtest.h>
 #include <gmock/gmock-matchers.h>
 
@@ -253,6 +255,128 @@ TEST(circular_buffer_blocked_tests, resize)
 
     ASSERT_EQ(cb.max_size(), 50u);
 }
+
+TEST(circular_buffer_blocked_tests, resize_wrapped_keeps_content)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_blocked<int> cb(4);
+    int value{};
+    for(int i = 1; i <= 4; ++i)
+        cb.try_push_back(i);
+    cb.try_pop(value);
+    cb.try_pop(value);
+    cb.try_push_back(5);
+    cb.try_push_back(6); // writePos < readPos
+
+    // Act
+
+    bool grow   = cb.resize(8);
+    bool shrink = cb.resize(4);
+    bool lost   = cb.resize(3);
+
+    // Assert
+
+    ASSERT_TRUE(grow);
+    ASSERT_TRUE(shrink);
+    ASSERT_FALSE(lost);
+    ASSERT_EQ(cb.max_size(), 4u);
+    ASSERT_EQ(cb.size(), 4u);
+
+    std::vector<int> values;
+    cb.pop_wait_all(values);
+    ASSERT_THAT(values, ElementsAre(3, 4, 5, 6));
+}
+
+TEST(circular_buffer_blocked_tests, resize_wakes_writer)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_blocked<int> cb(1);
+    cb.try_push_back(1); // full now
+
+    auto write = [&cb]() {
+        cb.push_back_wait(2); // wait there
+    };
+
+    // Act
+
+    auto writter = std::thread(write);
+
+    // to be sure, that writter in wait
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    cb.resize(2);
+    writter.join();
+
+    // Assert
+
+    ASSERT_TRUE(cb.full());
+    ASSERT_EQ(cb.size(), 2u);
+}
+
+TEST(circular_buffer_blocked_tests, auto_resize_grow_and_shrink)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_blocked<int> cb(4);
+
+    connest::AutoResizePolicy policy;
+    policy.min_size = 2;
+    policy.max_size = 16;
+    policy.window   = 4;
+    cb.set_auto_resize(policy);
+
+    // Act
+
+    // постоянно заполненный буфер
+    for(int i = 0; i < 64; ++i)
+        cb.try_push_back(i);
+    size_t grown = cb.max_size();
+
+    // постоянно почти пустой буфер
+    int value{};
+    while(cb.try_pop(value))
+        ;
+    for(int i = 0; i < 64; ++i) {
+        cb.try_push_back(i);
+        cb.try_pop(value);
+    }
+    size_t shrunk = cb.max_size();
+
+    // Assert
+
+    ASSERT_EQ(grown, 16u);
+    ASSERT_EQ(shrunk, 2u);
+}
+
+TEST(circular_buffer_blocked_tests, auto_resize_invalid_policy)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_blocked<int> cb(4);
+
+    connest::AutoResizePolicy sizes;
+    sizes.min_size = 16;
+    sizes.max_size = 2;
+
+    connest::AutoResizePolicy watermarks;
+    watermarks.min_size = 2;
+    watermarks.max_size = 16;
+    watermarks.low_watermark = 90;
+    watermarks.high_watermark = 50;
+
+    connest::AutoResizePolicy window;
+    window.min_size = 2;
+    window.max_size = 16;
+    window.window = 0;
+
+    // Act + Assert
+
+    ASSERT_THROW(cb.set_auto_resize(sizes), std::invalid_argument);
+    ASSERT_THROW(cb.set_auto_resize(watermarks), std::invalid_argument);
+    ASSERT_THROW(cb.set_auto_resize(window), std::invalid_argument);
+}
 TEST(circular_buffer_blocked_tests, blocked_pop_wait)
 {
     // Arrange
@@ -331,4 +455,265 @@ TEST(circular_buffer_blocked_tests, blocked_push_back_wait)
     writter.join();
 }
 
+TEST(circular_buffer_blocked_tests, mixed_waiters_no_lost_wakeup)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_blocked<int> cb(1);
+
+    const int threads = 4;
+    const int per_thread = 2000;
+
+    std::atomic<long> sum{0};
+
+    auto read = [&]() {
+        int value{};
+        for(int i = 0; i < per_thread; ++i) {
+            cb.pop_wait(value); // wait there
+            sum += value;
+        }
+    };
+
+    auto write = [&]() {
+        for(int i = 1; i <= per_thread; ++i)
+            cb.push_back_wait(i); // wait there
+    };
+
+    // Act
+
+    std::vector<std::thread> workers;
+    for(int i = 0; i < threads; ++i) {
+        workers.emplace_back(read);
+        workers.emplace_back(write);
+    }
+
+    for(auto& w : workers)
+        w.join();
+
+    // Assert
+
+    ASSERT_EQ(sum, threads * (per_thread * (per_thread + 1L) / 2));
+    ASSERT_TRUE(cb.empty());
+}
+
+TEST(circular_buffer_blocked_tests, pop_wait_n)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_blocked<int> cb(10);
+    for(int i = 1; i <= 5; ++i)
+        cb.try_push_back(i);
+
+    // Act
+
+    std::vector<int> values;
+    size_t count = cb.pop_wait_n(std::back_inserter(values), 3);
+
+    // Assert
+
+    ASSERT_EQ(count, 3u);
+    ASSERT_THAT(values, ElementsAre(1, 2, 3));
+    ASSERT_EQ(cb.size(), 2u);
+}
+
+TEST(circular_buffer_blocked_tests, pop_wait_all)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_blocked<int> cb(3);
+    cb.try_push_back(1);
+    cb.try_push_back(2);
+    cb.try_push_back(3);
+
+    // Act
+
+    std::vector<int> values{0};
+    size_t count = cb.pop_wait_all(values);
+
+    // Assert
+
+    ASSERT_EQ(count, 3u);
+    ASSERT_THAT(values, ElementsAre(0, 1, 2, 3));
+    ASSERT_TRUE(cb.empty());
+}
+
+TEST(circular_buffer_blocked_tests, push_back_wait_n_larger_than_buffer)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_blocked<int> cb(4);
+
+    std::vector<int> source(100);
+    for(size_t i = 0; i < source.size(); ++i)
+        source[i] = static_cast<int>(i);
+
+    std::vector<int> received;
+
+    auto read = [&]() {
+        while(received.size() < source.size())
+            cb.pop_wait_all(received); // wait there
+    };
+
+    // Act
+
+    auto reader = std::thread(read);
+    size_t pushed = cb.push_back_wait_n(source.begin(), source.end());
+    reader.join();
+
+    // Assert
+
+    ASSERT_EQ(pushed, source.size());
+    ASSERT_EQ(received, source);
+}
+
+TEST(circular_buffer_blocked_tests, pop_wait_for_timeout)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_blocked<int> cb(2);
+    int value{42};
+
+    // Act
+
+    auto status = cb.pop_wait_for(value, std::chrono::milliseconds(20));
+
+    // Assert
+
+    ASSERT_EQ(status, connest::WaitStatus::timeout);
+    ASSERT_EQ(value, 42);
+}
+
+TEST(circular_buffer_blocked_tests, push_back_wait_until_timeout)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_blocked<int> cb(1);
+    cb.try_push_back(1); // full now
+
+    // Act
+
+    auto deadline = std::chrono::steady_clock::now()
+                  + std::chrono::milliseconds(20);
+    auto status = cb.push_back_wait_until(2, deadline);
+
+    // Assert
+
+    ASSERT_EQ(status, connest::WaitStatus::timeout);
+    ASSERT_EQ(cb.size(), 1u);
+}
+
+TEST(circular_buffer_blocked_tests, pop_wait_for_success)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_blocked<int> cb(2);
+
+    auto write = [&cb]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        cb.try_push_back(666);
+    };
+
+    // Act
+
+    auto writter = std::thread(write);
+    int value{};
+    auto status = cb.pop_wait_for(value, std::chrono::seconds(10));
+    writter.join();
+
+    // Assert
+
+    ASSERT_EQ(status, connest::WaitStatus::success);
+    ASSERT_EQ(value, 666);
+}
+
+TEST(circular_buffer_blocked_tests, shutdown_wakes_waiters)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_blocked<int> cb(2);
+    int value{42};
+    connest::WaitStatus status{connest::WaitStatus::success};
+
+    auto read = [&]() {
+        status = cb.pop_wait(value); // wait there
+    };
+
+    // Act
+
+    auto reader = std::thread(read);
+
+    // to be sure, that reader in wait
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    cb.shutdown();
+    reader.join();
+
+    // Assert
+
+    ASSERT_EQ(status, connest::WaitStatus::shutdown);
+    ASSERT_EQ(value, 42);
+    ASSERT_EQ(cb.push_back_wait_for(1, std::chrono::milliseconds(1)),
+              connest::WaitStatus::shutdown);
+}
+
+TEST(circular_buffer_blocked_tests, pop_collect_for)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_blocked<int> cb(10);
+
+    auto write = [&cb]() {
+        for(int i = 1; i <= 3; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            cb.try_push_back(i);
+        }
+    };
+
+    // Act
+
+    auto writter = std::thread(write);
+
+    std::vector<int> full_batch;
+    size_t collected = cb.pop_collect_for(std::back_inserter(full_batch), 3,
+                                          std::chrono::seconds(10));
+    writter.join();
+
+    cb.try_push_back(4);
+    std::vector<int> partial_batch;
+    size_t partial = cb.pop_collect_for(std::back_inserter(partial_batch), 3,
+                                        std::chrono::milliseconds(20));
+
+    // Assert
+
+    ASSERT_EQ(collected, 3u);
+    ASSERT_THAT(full_batch, ElementsAre(1, 2, 3));
+    ASSERT_EQ(partial, 1u);
+    ASSERT_THAT(partial_batch, ElementsAre(4));
+}
+
+TEST(circular_buffer_blocked_tests, push_pop_n)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_blocked<int> cb(4);
+    std::vector<int> values{1, 2, 3, 4, 5};
+    std::vector<int> result;
+
+    // Act
+
+    size_t pushed = cb.try_push_back_n(values.begin(), values.size());
+    size_t popped = cb.try_pop_n(std::back_inserter(result), 2);
+    size_t wrapped = cb.try_push_back_n(values.begin() + 4, 1);
+    size_t rest = cb.try_pop_n(std::back_inserter(result), 10);
+
+    // Assert
+
+    ASSERT_EQ(pushed, 4u);
+    ASSERT_EQ(popped, 2u);
+    ASSERT_EQ(wrapped, 1u);
+    ASSERT_EQ(rest, 3u);
+    ASSERT_THAT(result, ElementsAre(1, 2, 3, 4, 5));
+    ASSERT_TRUE(cb.empty());
+}
+
 #endif // TST_CIRCULAR_BUFFER_BLOCKED_MRMW_H
@@ -0,0 +1,833 @@
+#ifndef TST_CIRCULAR_BUFFER_COMBINING_MRMW_H
+#define TST_CIRCULAR_BUFFER_COMBINING_MRMW_H
+
+
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <iterator>
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+using namespace testing;
+
+
+#include <circular_buffer/circular_buffer_fwd.h>
+#include <circular_buffer/circular_buffer_combining_mrmw.h>
+
+
+namespace combining {
+
+// Значение, запись которого в ячейку выполняется комбайнером:
+// удерживает роль комбайнера, пока не открыт шлюз, и отмечает,
+// в каком потоке и в каком порядке выполнены запросы
+struct gated_value
+{
+    int value;
+    std::atomic_bool* entered;
+    std::atomic_bool* open;
+    std::vector<std::pair<int, std::thread::id>>* log;
+
+    operator int() const
+    {
+        if(entered)
+            entered->store(true);
+
+        while(open && ! open->load())
+            std::this_thread::yield();
+
+        if(log)
+            log->emplace_back(value, std::this_thread::get_id());
+
+        return value;
+    }
+};
+
+}
+
+
+TEST(circular_buffer_combining_tests, is_empty)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_combining<int> cb(40);
+
+    // Act
+
+    bool is_empty = cb.empty();
+
+    // Assert
+
+    ASSERT_TRUE(is_empty);
+}
+
+TEST(circular_buffer_combining_tests, max_size)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_combining<int> cb(40);
+
+    // Act
+
+    size_t max_size = cb.max_size();
+
+    // Assert
+
+    ASSERT_EQ(max_size, 40u);
+}
+
+TEST(circular_buffer_combining_tests, size_and_push_back)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_combining<int> cb(40);
+    cb.try_push_back(2);
+    cb.try_push_back(3);
+
+    // Act
+
+    size_t size = cb.size();
+
+    // Assert
+
+    ASSERT_EQ(size, 2u);
+
+    int value;
+    cb.try_pop(value);
+    ASSERT_EQ(value, 2);
+
+    cb.try_pop(value);
+    ASSERT_EQ(value, 3);
+}
+
+
+TEST(circular_buffer_combining_tests, is_full)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_combining<int> cb(2);
+    cb.try_push_back(1);
+    cb.try_push_back(2);
+
+    // Act
+
+    bool full = cb.full();
+
+    // Assert
+
+    ASSERT_TRUE(full);
+    ASSERT_EQ(cb.size(), 2u);
+}
+
+TEST(circular_buffer_combining_tests, push_to_full)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_combining<int> cb(2);
+    cb.try_push_back(1);
+
+    // Act
+
+    bool to_not_full = cb.try_push_back(1);
+    bool to_full = cb.try_push_back(3);
+    bool full = cb.full();
+    size_t size = cb.size();
+
+    // Assert
+
+    ASSERT_TRUE(to_not_full);
+    ASSERT_FALSE(to_full);
+    ASSERT_TRUE(full);
+    ASSERT_EQ(size, 2u);
+}
+
+TEST(circular_buffer_combining_tests, is_full_zero_size)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_combining<int> cb(0);
+
+    // Act
+
+    bool full = cb.full();
+    bool empty = cb.empty();
+
+    // Assert
+
+    ASSERT_TRUE(full);
+    ASSERT_TRUE(empty);
+    ASSERT_EQ(cb.size(), 0u);
+}
+
+TEST(circular_buffer_combining_tests, pop_from_empty)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_combining<int> cb(0);
+
+
+    // Act
+    int value{};
+    bool success = cb.try_pop(value);
+
+    // Assert
+    ASSERT_FALSE(success);
+
+}
+
+TEST(circular_buffer_combining_tests, pop)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_combining<int> cb(10);
+    cb.try_push_back(100);
+
+    // Act
+
+    int value{};
+    cb.try_pop(value);
+
+    // Assert
+
+    ASSERT_EQ(value, 100);
+    ASSERT_TRUE(cb.empty());
+}
+
+
+TEST(circular_buffer_combining_tests, pop_push)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_combining<int> cb(3);
+    int value;
+
+    // Act
+
+    cb.try_push_back(1);
+    cb.try_push_back(2);
+    cb.try_push_back(3);
+
+
+    cb.try_pop(value); // read value = 1
+    cb.try_push_back(4);
+
+
+    // Assert
+
+    ASSERT_TRUE(cb.full());
+    ASSERT_EQ(cb.size(), 3u);
+
+    cb.try_pop(value);
+    ASSERT_EQ(value, 2);
+
+    cb.try_pop(value);
+    ASSERT_EQ(value, 3);
+
+    cb.try_pop(value);
+    ASSERT_EQ(value, 4);
+
+}
+
+TEST(circular_buffer_combining_tests, full_pop_push)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_combining<int> cb(3);
+    int value;
+
+    // Act
+
+    cb.try_push_back(1);
+    cb.try_push_back(2);
+    cb.try_push_back(3);
+
+    // now full
+
+    cb.try_pop(value); // read value = 1
+    cb.try_push_back(4);
+    cb.try_pop(value);
+    cb.try_pop(value);
+
+    // writePos < readPos
+    cb.try_push_back(5);
+    cb.try_push_back(6);
+
+
+    // Assert
+
+    ASSERT_TRUE(cb.full());
+    ASSERT_EQ(cb.size(), 3u);
+
+    cb.try_pop(value);
+    ASSERT_EQ(value, 4);
+
+    cb.try_pop(value);
+    ASSERT_EQ(value, 5);
+
+    cb.try_pop(value);
+    ASSERT_EQ(value, 6);
+
+}
+
+
+
+
+TEST(circular_buffer_combining_tests, blocked_pop_wait)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_combining<int> cb(10);
+
+    auto read = [&cb]() mutable {
+        int value{};
+
+        cb.pop_wait(value); // wait there
+
+        // Assert
+
+        ASSERT_EQ(value, 666);
+    };
+
+    auto write = [&cb]() mutable {
+        cb.try_push_back(666);
+
+    };
+
+    // Act
+
+
+
+    auto reader = std::thread(read);
+
+    // to be sure, that reader in wait
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+
+    auto writter = std::thread(write);
+
+
+    writter.join();
+    reader.join();
+}
+TEST(circular_buffer_combining_tests, blocked_push_back_wait)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_combining<int> cb(2);
+    cb.try_push_back(1);
+    cb.try_push_back(2); // full now
+
+
+    auto read = [&cb]() mutable {
+        int value{};
+        cb.try_pop(value);
+    };
+
+    auto write = [&cb]() mutable {
+
+        // Assert
+
+        cb.push_back_wait(666); // wait there
+        int value{};
+        cb.try_pop(value);
+        cb.try_pop(value);
+
+        ASSERT_EQ(value, 666);
+    };
+
+    // Act
+
+    auto writter = std::thread(write);
+
+    // to be sure, that writter in wait
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+
+    auto reader = std::thread(read);
+
+
+    reader.join();
+    writter.join();
+}
+
+TEST(circular_buffer_combining_tests, mixed_waiters_no_lost_wakeup)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_combining<int> cb(1);
+
+    const int threads = 4;
+    const int per_thread = 2000;
+
+    std::atomic<long> sum{0};
+
+    auto read = [&]() {
+        int value{};
+        for(int i = 0; i < per_thread; ++i) {
+            cb.pop_wait(value); // wait there
+            sum += value;
+        }
+    };
+
+    auto write = [&]() {
+        for(int i = 1; i <= per_thread; ++i)
+            cb.push_back_wait(i); // wait there
+    };
+
+    // Act
+
+    std::vector<std::thread> workers;
+    for(int i = 0; i < threads; ++i) {
+        workers.emplace_back(read);
+        workers.emplace_back(write);
+    }
+
+    for(auto& w : workers)
+        w.join();
+
+    // Assert
+
+    ASSERT_EQ(sum, threads * (per_thread * (per_thread + 1L) / 2));
+    ASSERT_TRUE(cb.empty());
+}
+
+TEST(circular_buffer_combining_tests, pop_wait_for_timeout)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_combining<int> cb(2);
+    int value{42};
+
+    // Act
+
+    auto status = cb.pop_wait_for(value, std::chrono::milliseconds(20));
+
+    // Assert
+
+    ASSERT_EQ(status, connest::WaitStatus::timeout);
+    ASSERT_EQ(value, 42);
+}
+
+TEST(circular_buffer_combining_tests, push_back_wait_until_timeout)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_combining<int> cb(1);
+    cb.try_push_back(1); // full now
+
+    // Act
+
+    auto deadline = std::chrono::steady_clock::now()
+                  + std::chrono::milliseconds(20);
+    auto status = cb.push_back_wait_until(2, deadline);
+
+    // Assert
+
+    ASSERT_EQ(status, connest::WaitStatus::timeout);
+    ASSERT_EQ(cb.size(), 1u);
+}
+
+TEST(circular_buffer_combining_tests, pop_wait_for_success)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_combining<int> cb(2);
+
+    auto write = [&cb]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        cb.try_push_back(666);
+    };
+
+    // Act
+
+    auto writter = std::thread(write);
+    int value{};
+    auto status = cb.pop_wait_for(value, std::chrono::seconds(10));
+    writter.join();
+
+    // Assert
+
+    ASSERT_EQ(status, connest::WaitStatus::success);
+    ASSERT_EQ(value, 666);
+}
+
+TEST(circular_buffer_combining_tests, shutdown_wakes_waiters)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_combining<int> cb(2);
+    int value{42};
+    connest::WaitStatus status{connest::WaitStatus::success};
+
+    auto read = [&]() {
+        status = cb.pop_wait(value); // wait there
+    };
+
+    // Act
+
+    auto reader = std::thread(read);
+
+    // to be sure, that reader in wait
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    cb.shutdown();
+    reader.join();
+
+    // Assert
+
+    ASSERT_EQ(status, connest::WaitStatus::shutdown);
+    ASSERT_EQ(value, 42);
+    ASSERT_EQ(cb.push_back_wait_for(1, std::chrono::milliseconds(1)),
+              connest::WaitStatus::shutdown);
+}
+
+TEST(circular_buffer_combining_tests, push_pop_n)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_combining<int> cb(4);
+    std::vector<int> values{1, 2, 3, 4, 5};
+    std::vector<int> result;
+
+    // Act
+
+    size_t pushed = cb.try_push_back_n(values.begin(), values.size());
+    size_t popped = cb.try_pop_n(std::back_inserter(result), 3);
+    size_t empty  = cb.try_pop_n(std::back_inserter(result), 0);
+
+    // Assert
+
+    ASSERT_EQ(pushed, 4u);
+    ASSERT_EQ(popped, 3u);
+    ASSERT_EQ(empty, 0u);
+    ASSERT_THAT(result, ElementsAre(1, 2, 3));
+    ASSERT_EQ(cb.size(), 1u);
+}
+
+TEST(circular_buffer_combining_tests, push_back_wait_n_pop_wait_all)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_combining<int> cb(3);
+    std::vector<int> values{1, 2, 3, 4, 5, 6, 7};
+    std::vector<int> received;
+
+    auto read = [&]() {
+        while(received.size() < values.size())
+            cb.pop_wait_all(received); // wait there
+    };
+
+    // Act
+
+    auto reader = std::thread(read);
+    size_t pushed = cb.push_back_wait_n(values.begin(), values.end());
+    reader.join();
+
+    // Assert
+
+    ASSERT_EQ(pushed, values.size());
+    ASSERT_EQ(received, values);
+    ASSERT_TRUE(cb.empty());
+}
+
+TEST(circular_buffer_combining_tests, pop_wait_n_pop_collect_for)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_combining<int> cb(10);
+
+    auto write = [&cb]() {
+        for(int i = 1; i <= 3; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            cb.try_push_back(i);
+        }
+    };
+
+    // Act
+
+    auto writter = std::thread(write);
+
+    std::vector<int> full_batch;
+    size_t collected = cb.pop_collect_for(std::back_inserter(full_batch), 3,
+                                          std::chrono::seconds(10));
+    writter.join();
+
+    cb.try_push_back(4);
+    cb.try_push_back(5);
+    std::vector<int> partial_batch;
+    size_t partial = cb.pop_wait_n(std::back_inserter(partial_batch), 1);
+    size_t timed   = cb.pop_collect_for(std::back_inserter(partial_batch), 3,
+                                        std::chrono::milliseconds(20));
+
+    // Assert
+
+    ASSERT_EQ(collected, 3u);
+    ASSERT_THAT(full_batch, ElementsAre(1, 2, 3));
+    ASSERT_EQ(partial, 1u);
+    ASSERT_EQ(timed, 1u);
+    ASSERT_THAT(partial_batch, ElementsAre(4, 5));
+}
+
+TEST(circular_buffer_combining_tests, resize_wrapped_keeps_content)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_combining<int> cb(4);
+    int value{};
+    for(int i = 1; i <= 4; ++i)
+        cb.try_push_back(i);
+    cb.try_pop(value);
+    cb.try_pop(value);
+    cb.try_push_back(5);
+    cb.try_push_back(6); // writePos < readPos
+
+    // Act
+
+    bool grow   = cb.resize(8);
+    bool shrink = cb.resize(4);
+    bool lost   = cb.resize(3);
+
+    // Assert
+
+    ASSERT_TRUE(grow);
+    ASSERT_TRUE(shrink);
+    ASSERT_FALSE(lost);
+    ASSERT_EQ(cb.max_size(), 4u);
+    ASSERT_EQ(cb.size(), 4u);
+
+    std::vector<int> values;
+    cb.pop_wait_all(values);
+    ASSERT_THAT(values, ElementsAre(3, 4, 5, 6));
+}
+
+TEST(circular_buffer_combining_tests, resize_wakes_writer)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_combining<int> cb(1);
+    cb.try_push_back(1); // full now
+
+    auto write = [&cb]() {
+        cb.push_back_wait(2); // wait there
+    };
+
+    // Act
+
+    auto writter = std::thread(write);
+
+    // to be sure, that writter in wait
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    cb.resize(2);
+    writter.join();
+
+    // Assert
+
+    ASSERT_TRUE(cb.full());
+    ASSERT_EQ(cb.size(), 2u);
+}
+
+TEST(circular_buffer_combining_tests, auto_resize_grow_and_shrink)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_combining<int> cb(4);
+
+    connest::AutoResizePolicy policy;
+    policy.min_size = 2;
+    policy.max_size = 16;
+    policy.window   = 4;
+    cb.set_auto_resize(policy);
+
+    connest::AutoResizePolicy invalid;
+    invalid.min_size = 8;
+    invalid.max_size = 4;
+
+    // Act
+
+    // постоянно заполненный буфер
+    for(int i = 0; i < 64; ++i)
+        cb.try_push_back(i);
+    size_t grown = cb.max_size();
+
+    // постоянно почти пустой буфер
+    int value{};
+    while(cb.try_pop(value))
+        ;
+    for(int i = 0; i < 64; ++i) {
+        cb.try_push_back(i);
+        cb.try_pop(value);
+    }
+    size_t shrunk = cb.max_size();
+
+    // Assert
+
+    ASSERT_EQ(grown, 16u);
+    ASSERT_EQ(shrunk, 2u);
+    ASSERT_THROW(cb.set_auto_resize(invalid), std::invalid_argument);
+}
+
+TEST(circular_buffer_combining_tests, combiner_keeps_arrival_order)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_combining<int> cb(10);
+
+    std::atomic_bool entered{false};
+    std::atomic_bool open{false};
+    std::vector<std::pair<int, std::thread::id>> log;
+
+    // первый запрос удерживает роль комбайнера
+    std::thread::id combiner;
+    auto hold = [&]() {
+        combiner = std::this_thread::get_id();
+        cb.try_push_back(combining::gated_value{0, &entered, &open, &log});
+    };
+
+    auto push = [&](int value) {
+        cb.try_push_back(combining::gated_value{value, nullptr, nullptr, &log});
+    };
+
+    // Act
+
+    auto holder = std::thread(hold);
+    while(! entered)
+        std::this_thread::yield();
+
+    // запросы публикуются по очереди, пока комбайнер занят
+    std::vector<std::thread> writters;
+    for(int i = 1; i <= 4; ++i) {
+        writters.emplace_back(push, i);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+
+    open = true;
+    holder.join();
+    for(auto& w : writters)
+        w.join();
+
+    // Assert
+
+    ASSERT_EQ(log.size(), 5u);
+    for(size_t i = 0; i < log.size(); ++i) {
+        ASSERT_EQ(log[i].first, static_cast<int>(i));
+        ASSERT_EQ(log[i].second, combiner);
+    }
+
+    std::vector<int> values;
+    cb.try_pop_n(std::back_inserter(values), 10);
+    ASSERT_THAT(values, ElementsAre(0, 1, 2, 3, 4));
+}
+
+TEST(circular_buffer_combining_tests, mixed_pass_on_full_ring)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_combining<int> cb(1);
+
+    std::atomic_bool entered{false};
+    std::atomic_bool open{false};
+
+    // запись удерживает комбайнер и заполняет кольцо
+    auto hold = [&]() {
+        cb.try_push_back(combining::gated_value{1, &entered, &open, nullptr});
+    };
+
+    connest::WaitStatus written{connest::WaitStatus::timeout};
+    connest::WaitStatus read{connest::WaitStatus::timeout};
+    bool taken{false};
+    int first{};
+    int second{};
+
+    // Act
+
+    auto holder = std::thread(hold);
+    while(! entered)
+        std::this_thread::yield();
+
+    // в одном проходе: запись в полное кольцо, чтение, чтение из пустого
+    std::thread writter([&]() { written = cb.push_back_wait(2); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::thread taker([&]() { taken = cb.try_pop(first); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::thread reader([&]() { read = cb.pop_wait(second); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    open = true;
+    holder.join();
+    taker.join();
+    writter.join();
+    reader.join();
+
+    // Assert
+
+    ASSERT_TRUE(taken);
+    ASSERT_EQ(first, 1);
+    ASSERT_EQ(written, connest::WaitStatus::success);
+    ASSERT_EQ(read, connest::WaitStatus::success);
+    ASSERT_EQ(second, 2);
+    ASSERT_TRUE(cb.empty());
+}
+
+TEST(circular_buffer_combining_tests, pass_limit_hands_over_combiner)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_combining<int> cb(8);
+
+    std::atomic_bool entered{false};
+    std::atomic_bool open{false};
+    std::atomic_bool stop{false};
+
+    const int threads = 4;
+    std::vector<std::atomic<size_t>> done(threads);
+    for(auto& d : done)
+        d = 0;
+
+    // непрерывный поток запросов: без ограничения проходов комбайнер
+    // обслуживал бы их бесконечно и не вернулся бы из своего вызова
+    auto work = [&](int id) {
+        int value{};
+        while(! stop) {
+            if(id % 2 == 0)
+                cb.try_push_back(id);
+            else
+                cb.try_pop(value);
+            ++done[id];
+        }
+    };
+
+    // Act
+
+    auto holder = std::thread([&]() {
+        cb.try_push_back(combining::gated_value{-1, &entered, &open, nullptr});
+    });
+    while(! entered)
+        std::this_thread::yield();
+
+    std::vector<std::thread> workers;
+    for(int i = 0; i < threads; ++i)
+        workers.emplace_back(work, i);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    open = true;
+    holder.join(); // комбайнер отдал роль, несмотря на новые запросы
+
+    // каждый поток продвигается после смены комбайнера
+    std::vector<size_t> before(threads);
+    for(int i = 0; i < threads; ++i)
+        before[i] = done[i];
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    stop = true;
+    for(auto& w : workers)
+        w.join();
+
+    // Assert
+
+    for(int i = 0; i < threads; ++i)
+        ASSERT_GT(done[i], before[i]);
+}
+
+#endif // TST_CIRCULAR_BUFFER_COMBINING_MRMW_H
@@ -0,0 +1,291 @@
+#ifndef TST_CIRCULAR_BUFFER_CORO_H
+#define TST_CIRCULAR_BUFFER_CORO_H
+
+
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+using namespace testing;
+
+
+#include <circular_buffer/circular_buffer_fwd.h>
+#include <circular_buffer/circular_buffer_basic.h>
+#include <circular_buffer/circular_buffer_blocked_mrmw.h>
+
+#ifdef CIRCULAR_BUFFER_HAS_COROUTINES
+
+#include <exception>
+
+namespace coro_test {
+
+/**
+ * @brief Сопрограмма без результата, выполняется сразу при вызове
+ */
+struct task
+{
+    struct promise_type
+    {
+        task get_return_object() { return task{}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+using coro_buffer = connest::basic_circular_buffer<int,
+                                                   connest::multi_producer,
+                                                   connest::multi_consumer,
+                                                   connest::coro_wait>;
+
+template<typename Buffer>
+task pop_one(Buffer& buffer, std::optional<int>& result, bool& done)
+{
+    result = co_await buffer.pop();
+    done = true;
+}
+
+template<typename Buffer>
+task push_one(Buffer& buffer, int value, connest::WaitStatus& result, bool& done)
+{
+    result = co_await buffer.push(value);
+    done = true;
+}
+
+template<typename Buffer>
+task consume(Buffer& buffer, std::atomic<long long>& sum, std::atomic<size_t>& count)
+{
+    while(std::optional<int> value = co_await buffer.pop()) {
+        sum.fetch_add(*value, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_release);
+    }
+}
+
+/**
+ * @brief   Писатели-потоки и читатели-сопрограммы: читатели
+ *          возобновляются в потоках писателей
+ */
+template<typename Buffer>
+void threads_to_coroutines(size_t producers, size_t consumers, int per_producer)
+{
+    Buffer buffer(4);
+
+    std::atomic<long long> sum{0};
+    std::atomic<size_t> count{0};
+
+    for(size_t c = 0; c < consumers; ++c)
+        consume(buffer, sum, count);
+
+    std::vector<std::thread> threads;
+    for(size_t p = 0; p < producers; ++p)
+        threads.emplace_back([&buffer, per_producer]() {
+            for(int i = 1; i <= per_producer; ++i)
+                buffer.push_back_wait(i);
+        });
+
+    for(auto& thread : threads)
+        thread.join();
+
+    const size_t total = producers * static_cast<size_t>(per_producer);
+    while(count.load(std::memory_order_acquire) < total)
+        std::this_thread::yield();
+
+    buffer.shutdown();
+
+    ASSERT_EQ(count.load(), total);
+    ASSERT_EQ(sum.load(), static_cast<long long>(producers) * per_producer * (per_producer + 1) / 2);
+}
+
+}
+
+
+TEST(circular_buffer_coro_tests, pop_suspends_until_push)
+{
+    // Arrange
+
+    coro_test::coro_buffer cb(4);
+    std::optional<int> value;
+    bool done = false;
+
+    coro_test::pop_one(cb, value, done);
+    bool suspended = ! done;
+
+    // Act
+
+    cb.try_push_back(42);
+
+    // Assert
+
+    ASSERT_TRUE(suspended);
+    ASSERT_TRUE(done);
+    ASSERT_THAT(value, Optional(42));
+    ASSERT_TRUE(cb.empty());
+}
+
+TEST(circular_buffer_coro_tests, pop_ready_does_not_suspend)
+{
+    // Arrange
+
+    coro_test::coro_buffer cb(4);
+    cb.try_push_back(7);
+
+    std::optional<int> value;
+    bool done = false;
+
+    // Act
+
+    coro_test::pop_one(cb, value, done);
+
+    // Assert
+
+    ASSERT_TRUE(done);
+    ASSERT_THAT(value, Optional(7));
+}
+
+TEST(circular_buffer_coro_tests, push_suspends_until_pop)
+{
+    // Arrange
+
+    coro_test::coro_buffer cb(1);
+    cb.try_push_back(1);
+
+    connest::WaitStatus status = connest::WaitStatus::timeout;
+    bool done = false;
+
+    coro_test::push_one(cb, 2, status, done);
+    bool suspended = ! done;
+
+    // Act
+
+    int first{}, second{};
+    bool popped = cb.try_pop(first);
+    bool resumedPush = cb.try_pop(second);
+
+    // Assert
+
+    ASSERT_TRUE(suspended);
+    ASSERT_TRUE(done);
+    ASSERT_EQ(status, connest::WaitStatus::success);
+    ASSERT_TRUE(popped);
+    ASSERT_TRUE(resumedPush);
+    ASSERT_EQ(first, 1);
+    ASSERT_EQ(second, 2);
+}
+
+TEST(circular_buffer_coro_tests, waiters_resumed_in_fifo_order)
+{
+    // Arrange
+
+    coro_test::coro_buffer cb(4);
+
+    std::optional<int> values[3];
+    bool done[3] = {false, false, false};
+
+    for(int i = 0; i < 3; ++i)
+        coro_test::pop_one(cb, values[i], done[i]);
+
+    // Act
+
+    int items[] = {10, 20, 30};
+    cb.push_back_all(std::begin(items), std::end(items));
+
+    // Assert
+
+    ASSERT_TRUE(done[0] && done[1] && done[2]);
+    ASSERT_THAT(values[0], Optional(10));
+    ASSERT_THAT(values[1], Optional(20));
+    ASSERT_THAT(values[2], Optional(30));
+}
+
+TEST(circular_buffer_coro_tests, shutdown_resumes_waiters)
+{
+    // Arrange
+
+    coro_test::coro_buffer cb(4);
+    std::optional<int> value = 0;
+    bool done = false;
+
+    coro_test::pop_one(cb, value, done);
+
+    // Act
+
+    cb.shutdown();
+
+    std::optional<int> late = 0;
+    bool lateDone = false;
+    coro_test::pop_one(cb, late, lateDone);
+
+    // Assert
+
+    ASSERT_TRUE(done);
+    ASSERT_EQ(value, std::nullopt);
+    ASSERT_TRUE(lateDone);
+    ASSERT_EQ(late, std::nullopt);
+}
+
+TEST(circular_buffer_coro_tests, blocked_pop_suspends_until_push_wait)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_blocked<int> cb(4);
+    std::optional<int> value;
+    bool done = false;
+
+    coro_test::pop_one(cb, value, done);
+    bool suspended = ! done;
+
+    // Act
+
+    connest::WaitStatus status = cb.push_back_wait(5);
+
+    // Assert
+
+    ASSERT_TRUE(suspended);
+    ASSERT_EQ(status, connest::WaitStatus::success);
+    ASSERT_TRUE(done);
+    ASSERT_THAT(value, Optional(5));
+}
+
+TEST(circular_buffer_coro_tests, blocked_push_suspends_until_pop_wait)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_blocked<int> cb(1);
+    cb.try_push_back(1);
+
+    connest::WaitStatus status = connest::WaitStatus::timeout;
+    bool done = false;
+
+    coro_test::push_one(cb, 2, status, done);
+    bool suspended = ! done;
+
+    // Act
+
+    int first{};
+    cb.pop_wait(first);
+
+    // Assert
+
+    ASSERT_TRUE(suspended);
+    ASSERT_TRUE(done);
+    ASSERT_EQ(status, connest::WaitStatus::success);
+    ASSERT_EQ(first, 1);
+    ASSERT_EQ(cb.size(), 1u);
+}
+
+TEST(circular_buffer_coro_tests, threads_to_coroutines_lockfree)
+{
+    coro_test::threads_to_coroutines<coro_test::coro_buffer>(3, 2, 20000);
+}
+
+TEST(circular_buffer_coro_tests, threads_to_coroutines_blocked)
+{
+    coro_test::threads_to_coroutines<connest::CircularBuffer_mrmw_blocked<int>>(3, 2, 20000);
+}
+
+#endif // CIRCULAR_BUFFER_HAS_COROUTINES
+
+#endif // TST_CIRCULAR_BUFFER_CORO_H
@@ -0,0 +1,253 @@
+#ifndef TST_CIRCULAR_BUFFER_EXECUTOR_H
+#define TST_CIRCULAR_BUFFER_EXECUTOR_H
+
+
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <array>
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+using namespace testing;
+
+
+#include <circular_buffer/circular_buffer_executor.h>
+
+
+TEST(circular_buffer_executor_tests, small_task_inline_and_heap)
+{
+    // Arrange
+
+    using task = connest::small_task<>;
+
+    int counter = 0;
+    std::array<char, 2 * task::capacity> large{};
+    large[0] = 10;
+
+    task small([&counter]() { counter += 1; });
+    task big([&counter, large]() { counter += large[0]; });
+
+    // Act
+
+    small();
+    big();
+
+    bool fitsCapacity = task::fits_inline<std::array<char, task::capacity>>();
+    bool fitsLarge    = task::fits_inline<decltype(large)>();
+
+    // Assert
+
+    ASSERT_EQ(sizeof(task), 64u);
+    ASSERT_TRUE(fitsCapacity);
+    ASSERT_FALSE(fitsLarge);
+    ASSERT_EQ(counter, 11);
+}
+
+TEST(circular_buffer_executor_tests, small_task_move_only)
+{
+    // Arrange
+
+    std::shared_ptr<int> owner = std::make_shared<int>(3);
+    std::weak_ptr<int> observer = owner;
+
+    int result = 0;
+    connest::small_task<> source([&result, owner]() { result = *owner; });
+    owner.reset();
+
+    // Act
+
+    connest::small_task<> target(std::move(source));
+    target();
+    bool aliveAfterRun = ! observer.expired();
+    target.reset();
+
+    // Assert
+
+    ASSERT_FALSE(static_cast<bool>(source));
+    ASSERT_FALSE(static_cast<bool>(target));
+    ASSERT_EQ(result, 3);
+    ASSERT_TRUE(aliveAfterRun);
+    ASSERT_TRUE(observer.expired());
+}
+
+TEST(circular_buffer_executor_tests, runs_all_submitted_tasks)
+{
+    // Arrange
+
+    const size_t submitters = 3;
+    const size_t perSubmitter = 20000;
+
+    std::atomic<size_t> executed{0};
+    std::atomic<size_t> sum{0};
+
+    // Act
+
+    {
+        connest::thread_pool_executor<> pool(2, 64);
+
+        std::vector<std::thread> threads;
+        for(size_t s = 0; s < submitters; ++s)
+            threads.emplace_back([&]() {
+                for(size_t i = 1; i <= perSubmitter; ++i)
+                    pool.submit([&executed, &sum, i]() {
+                        sum.fetch_add(i, std::memory_order_relaxed);
+                        executed.fetch_add(1, std::memory_order_relaxed);
+                    });
+            });
+
+        for(auto& thread : threads)
+            thread.join();
+    }
+
+    // Assert
+
+    ASSERT_EQ(executed.load(), submitters * perSubmitter);
+    ASSERT_EQ(sum.load(), submitters * perSubmitter * (perSubmitter + 1) / 2);
+}
+
+TEST(circular_buffer_executor_tests, submit_bulk_move_only)
+{
+    // Arrange
+
+    std::atomic<int> sum{0};
+
+    std::vector<connest::small_task<>> tasks;
+    for(int i = 1; i <= 100; ++i) {
+        std::unique_ptr<int> value(new int(i));
+        int* raw = value.release();
+        tasks.emplace_back([&sum, raw]() { sum += *raw; delete raw; });
+    }
+
+    size_t submitted = 0;
+
+    // Act
+
+    {
+        connest::thread_pool_executor<> pool(2, 8);
+        submitted = pool.submit_bulk(tasks.begin(), tasks.end());
+    }
+
+    // Assert
+
+    ASSERT_EQ(submitted, 100u);
+    ASSERT_EQ(sum.load(), 5050);
+    ASSERT_FALSE(static_cast<bool>(tasks.front()));
+}
+
+TEST(circular_buffer_executor_tests, shutdown_finishes_accepted_tasks)
+{
+    // Arrange
+
+    connest::thread_pool_executor<> pool(1, 16);
+
+    std::atomic_bool release{false};
+    std::atomic<int> executed{0};
+
+    pool.submit([&]() {
+        while(! release.load())
+            std::this_thread::yield();
+        ++executed;
+    });
+
+    for(int i = 0; i < 10; ++i)
+        pool.submit([&executed]() { ++executed; });
+
+    // Act
+
+    std::thread stopper([&pool]() { pool.shutdown(); });
+    release = true;
+    stopper.join();
+
+    connest::WaitStatus late = pool.submit([&executed]() { ++executed; });
+    bool lateTry = pool.try_submit([&executed]() { ++executed; });
+
+    // Assert
+
+    ASSERT_EQ(executed.load(), 11);
+    ASSERT_EQ(late, connest::WaitStatus::shutdown);
+    ASSERT_FALSE(lateTry);
+    ASSERT_EQ(pool.pending(), 0u);
+}
+
+TEST(circular_buffer_executor_tests, shutdown_races_submitters)
+{
+    // Arrange
+
+    const int submitters = 4;
+    const int rounds = 50;
+
+    bool lost = false;
+
+    // Act
+
+    for(int round = 0; round < rounds && ! lost; ++round) {
+        std::atomic<int> accepted{0};
+        std::atomic<int> executed{0};
+
+        {
+            connest::thread_pool_executor<> pool(2, 8);
+
+            std::vector<std::thread> threads;
+            for(int i = 0; i < submitters; ++i)
+                threads.emplace_back([&]() {
+                    for(;;) {
+                        if(pool.submit([&executed]() { ++executed; }) != connest::WaitStatus::success)
+                            break;
+                        ++accepted;
+                    }
+                });
+
+            while(accepted.load() < 16)
+                std::this_thread::yield();
+
+            pool.shutdown();
+
+            for(auto& thread : threads)
+                thread.join();
+        }
+
+        lost = executed.load() != accepted.load();
+    }
+
+    // Assert
+
+    ASSERT_FALSE(lost);
+}
+
+TEST(circular_buffer_executor_tests, try_submit_full_queue)
+{
+    // Arrange
+
+    connest::thread_pool_executor<> pool(1, 2);
+
+    std::atomic_bool started{false};
+    std::atomic_bool release{false};
+
+    pool.submit([&]() {
+        started = true;
+        while(! release.load())
+            std::this_thread::yield();
+    });
+
+    while(! started.load())
+        std::this_thread::yield();
+
+    // Act
+
+    bool first  = pool.try_submit([]() {});
+    bool second = pool.try_submit([]() {});
+    bool third  = pool.try_submit([]() {});
+
+    release = true;
+
+    // Assert
+
+    ASSERT_TRUE(first);
+    ASSERT_TRUE(second);
+    ASSERT_FALSE(third);
+    ASSERT_EQ(pool.thread_count(), 1u);
+}
+
+#endif // TST_CIRCULAR_BUFFER_EXECUTOR_H
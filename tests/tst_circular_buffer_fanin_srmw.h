@@ -0,0 +1,197 @@
+#ifndef TST_CIRCULAR_BUFFER_FANIN_SRMW_H
+#define TST_CIRCULAR_BUFFER_FANIN_SRMW_H
+
+
+#include <thread>
+#include <vector>
+#include <stdexcept>
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+using namespace testing;
+
+
+#include <circular_buffer/circular_buffer_fwd.h>
+#include <circular_buffer/circular_buffer_fanin_srmw.h>
+
+
+TEST(circular_buffer_fanin_srmw_tests, lane_per_thread)
+{
+    // Arrange
+
+    connest::CircularBuffer_srmw_fanin<int> buffer(16, 8);
+
+    // Act
+
+    bool local = buffer.try_push_back(1);
+    std::thread first([&buffer]() { buffer.try_push_back(2); buffer.try_push_back(3); });
+    first.join();
+    std::thread second([&buffer]() { buffer.try_push_back(4); });
+    second.join();
+
+    // Assert
+
+    ASSERT_TRUE(local);
+    // полосу завершившегося первого потока занял второй
+    ASSERT_EQ(buffer.lane_count(), 2u);
+    ASSERT_EQ(buffer.size(), 4u);
+}
+
+TEST(circular_buffer_fanin_srmw_tests, lane_full)
+{
+    // Arrange
+
+    connest::CircularBuffer_srmw_fanin<int> buffer(2, 4);
+    buffer.try_push_back(1);
+    buffer.try_push_back(2);
+
+    // Act
+
+    bool full = buffer.try_push_back(3);
+    bool other{false};
+    std::thread writer([&buffer, &other]() { other = buffer.try_push_back(4); });
+    writer.join();
+
+    // Assert
+
+    ASSERT_FALSE(full);
+    ASSERT_TRUE(other);
+    ASSERT_EQ(buffer.size(), 3u);
+}
+
+TEST(circular_buffer_fanin_srmw_tests, too_many_lanes)
+{
+    // Arrange
+
+    connest::CircularBuffer_srmw_fanin<int> buffer(4, 1);
+    buffer.try_push_back(1);
+
+    // Act
+
+    bool thrown{false};
+    std::thread writer([&buffer, &thrown]() {
+        try {
+            buffer.try_push_back(2);
+        } catch(const std::length_error&) {
+            thrown = true;
+        }
+    });
+    writer.join();
+
+    // Assert
+
+    ASSERT_TRUE(thrown);
+    ASSERT_EQ(buffer.lane_count(), 1u);
+}
+
+TEST(circular_buffer_fanin_srmw_tests, pop_all_by_occupancy)
+{
+    // Arrange
+
+    connest::CircularBuffer_srmw_fanin<int> buffer(16, 4, connest::PollOrder::occupancy);
+
+    std::vector<int> few{10, 11};
+    std::vector<int> many{20, 21, 22, 23};
+
+    buffer.push_back_all(few.begin(), few.end());
+    std::thread writer([&]() { buffer.push_back_all(many.begin(), many.end()); });
+    writer.join();
+
+    // Act
+
+    std::vector<int> limited;
+    size_t first = buffer.pop_all(limited, 3);
+
+    std::vector<int> rest;
+    size_t second = buffer.pop_all(rest);
+
+    // Assert
+
+    ASSERT_EQ(first, 5u);
+    ASSERT_THAT(limited, ElementsAre(20, 21, 22, 10, 11));
+    ASSERT_EQ(second, 1u);
+    ASSERT_THAT(rest, ElementsAre(23));
+    ASSERT_TRUE(buffer.empty());
+}
+
+TEST(circular_buffer_fanin_srmw_tests, try_pop_batch_round_robin)
+{
+    // Arrange
+
+    connest::CircularBuffer_srmw_fanin<int> buffer(16, 4, connest::PollOrder::round_robin, 2);
+
+    for(int i = 10; i < 14; ++i)
+        buffer.try_push_back(i);
+    std::thread writer([&]() { for(int i = 20; i < 24; ++i) buffer.try_push_back(i); });
+    writer.join();
+
+    // Act
+
+    std::vector<int> values;
+    int value{};
+    while(buffer.try_pop(value))
+        values.push_back(value);
+
+    // Assert
+
+    // по 2 элемента подряд из полосы, затем следующая полоса
+    ASSERT_EQ(buffer.lane_count(), 2u);
+    ASSERT_THAT(values, ElementsAre(10, 11, 20, 21, 12, 13, 22, 23));
+}
+
+TEST(circular_buffer_fanin_srmw_tests, concurrent_writers_fifo_per_thread)
+{
+    // Arrange
+
+    const size_t writers = 4;
+    const int count = 50000;
+
+    connest::CircularBuffer_srmw_fanin<int> buffer(256, writers, connest::PollOrder::round_robin, 16);
+
+    std::vector<std::thread> threads;
+    for(size_t w = 0; w < writers; ++w)
+        threads.emplace_back([&buffer, w, count]() {
+            int base = static_cast<int>(w) * count;
+            for(int i = 0; i < count;) {
+                if(buffer.try_push_back(base + i))
+                    ++i;
+                else
+                    std::this_thread::yield();
+            }
+        });
+
+    // Act
+
+    std::vector<int> last(writers, -1);
+    bool ordered = true;
+    size_t received = 0;
+    std::vector<int> batch;
+
+    while(received < writers * count) {
+        int value{};
+        if(buffer.try_pop(value))
+            batch.push_back(value);
+        else if(buffer.pop_all(batch, 32) == 0)
+            std::this_thread::yield();
+
+        for(int v : batch) {
+            size_t w = static_cast<size_t>(v / count);
+            ordered = ordered && v % count == last[w] + 1;
+            last[w] = v % count;
+        }
+
+        received += batch.size();
+        batch.clear();
+    }
+
+    for(auto& thread : threads)
+        thread.join();
+
+    // Assert
+
+    ASSERT_TRUE(ordered);
+    ASSERT_EQ(received, writers * count);
+    ASSERT_TRUE(buffer.empty());
+}
+
+#endif // TST_CIRCULAR_BUFFER_FANIN_SRMW_H
@@ -1,6 +1,8 @@
 #ifndef TST_CIRCULAR_BUFFER_LOCKFREE_MRMW_H
 #define TST_CIRCULAR_BUFFER_LOCKFREE_MRMW_H
 
+#include <vector>
+#include <iterator>
 #include <gtest/gtest.h>
 #include <gmock/gmock-matchers.h>
 
@@ -233,5 +235,57 @@ TEST(circular_buffer_lockfree_tests, full_pop_push)
     ASSERT_EQ(res3, 6);
 }
 
+TEST(circular_buffer_lockfree_tests, push_pop_n_wrap)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw<int> cb(4);
+    std::vector<int> values{1, 2, 3, 4, 5, 6};
+    std::vector<int> first, second;
+
+    // Act
+
+    size_t pushed1 = cb.try_push_back_n(values.begin(), 3);
+    size_t popped1 = cb.try_pop_n(std::back_inserter(first), 2);
+    // позиции 3, 0, 1: серия переходит через конец кольца
+    size_t pushed2 = cb.try_push_back_n(values.begin() + 3, 3);
+    size_t popped2 = cb.try_pop_n(std::back_inserter(second), 10);
+
+    // Assert
+
+    ASSERT_EQ(pushed1, 3u);
+    ASSERT_EQ(popped1, 2u);
+    ASSERT_EQ(pushed2, 3u);
+    ASSERT_EQ(popped2, 4u);
+    ASSERT_THAT(first, ElementsAre(1, 2));
+    ASSERT_THAT(second, ElementsAre(3, 4, 5, 6));
+    ASSERT_TRUE(cb.empty());
+}
+
+TEST(circular_buffer_lockfree_tests, push_pop_n_limits)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw<int> cb(3);
+    std::vector<int> values{1, 2, 3, 4, 5};
+    std::vector<int> result;
+
+    // Act
+
+    size_t pushed = cb.try_push_back_n(values.begin(), values.size());
+    size_t full   = cb.try_push_back_n(values.begin(), 1);
+    size_t popped = cb.try_pop_n(std::back_inserter(result), 2);
+    size_t none   = cb.try_pop_n(std::back_inserter(result), 0);
+
+    // Assert
+
+    ASSERT_EQ(pushed, 3u);
+    ASSERT_EQ(full, 0u);
+    ASSERT_EQ(popped, 2u);
+    ASSERT_EQ(none, 0u);
+    ASSERT_THAT(result, ElementsAre(1, 2));
+    ASSERT_EQ(cb.size(), 1u);
+}
+
 
 #endif // TST_CIRCULAR_BUFFER_LOCKFREE_MRMW_H
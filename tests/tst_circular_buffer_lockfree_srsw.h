@@ -1,6 +1,8 @@
 #ifndef TST_CIRCULAR_BUFFER_LOCKFREE_SRSW_H
 #define TST_CIRCULAR_BUFFER_LOCKFREE_SRSW_H
 
+#include <vector>
+#include <iterator>
 #include <gtest/gtest.h>
 #include <gmock/gmock-matchers.h>
 
@@ -487,5 +489,29 @@ TEST(circular_buffer_tests, pop_all_empty)
     ASSERT_EQ(v,  expected_v);
 }
 
+TEST(circular_buffer_tests, push_pop_n)
+{
+    // Arrange
+
+    connest::CircularBuffer_srsw<int> cb(4);
+    std::vector<int> values{1, 2, 3, 4, 5};
+    std::vector<int> result;
+
+    // Act
+
+    size_t pushed = cb.try_push_back_n(values.begin(), values.size());
+    size_t popped = cb.try_pop_n(std::back_inserter(result), 2);
+    size_t wrapped = cb.try_push_back_n(values.begin() + 4, 1);
+    size_t rest = cb.try_pop_n(std::back_inserter(result), 10);
+
+    // Assert
+
+    ASSERT_EQ(pushed, 4u);
+    ASSERT_EQ(popped, 2u);
+    ASSERT_EQ(wrapped, 1u);
+    ASSERT_EQ(rest, 3u);
+    ASSERT_THAT(result, ElementsAre(1, 2, 3, 4, 5));
+}
+
 
 #endif // TST_CIRCULAR_BUFFER_LOCKFREE_SRSW_H
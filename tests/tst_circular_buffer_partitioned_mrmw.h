@@ -0,0 +1,258 @@
+#ifndef TST_CIRCULAR_BUFFER_PARTITIONED_MRMW_H
+#define TST_CIRCULAR_BUFFER_PARTITIONED_MRMW_H
+
+
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+using namespace testing;
+
+
+#include <circular_buffer/circular_buffer_fwd.h>
+#include <circular_buffer/circular_buffer_partitioned_mrmw.h>
+
+
+namespace {
+
+// ключ - номер раздела (для предсказуемого размещения в тестах)
+struct identity_hash
+{
+    size_t operator()(int key) const noexcept
+    {
+        return static_cast<size_t>(key);
+    }
+};
+
+struct event
+{
+    int key;
+    int sequence;
+};
+
+}
+
+TEST(circular_buffer_partitioned_mrmw_tests, routes_by_key)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_partitioned<int, int, identity_hash> buffer(8, 4, 2);
+
+    // Act
+
+    buffer.try_push_back(0, 100);
+    buffer.try_push_back(1, 101);
+    buffer.try_push_back(4, 104);   // раздел 0
+    buffer.try_push_back(2, 102);
+
+    std::vector<int> first, second;
+    buffer.pop_all(0, first);
+    buffer.pop_all(1, second);
+
+    // Assert
+
+    ASSERT_EQ(buffer.partition_of(4), 0u);
+    // читатель 0 - разделы 0 и 2, читатель 1 - разделы 1 и 3
+    ASSERT_THAT(first, ElementsAre(100, 104, 102));
+    ASSERT_THAT(second, ElementsAre(101));
+    ASSERT_TRUE(buffer.empty());
+}
+
+TEST(circular_buffer_partitioned_mrmw_tests, partition_full)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_partitioned<int, int, identity_hash> buffer(2, 2, 1);
+    buffer.try_push_back(0, 1);
+    buffer.try_push_back(0, 2);
+
+    // Act
+
+    bool full  = buffer.try_push_back(2, 3);
+    bool other = buffer.try_push_back(1, 4);
+
+    // Assert
+
+    ASSERT_FALSE(full);
+    ASSERT_TRUE(other);
+    ASSERT_EQ(buffer.size(), 3u);
+    ASSERT_EQ(buffer.max_size(), 4u);
+}
+
+TEST(circular_buffer_partitioned_mrmw_tests, assign_hands_over_on_next_pop)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_partitioned<int, int, identity_hash> buffer(8, 2, 2);
+    buffer.try_push_back(0, 1);
+    buffer.try_push_back(0, 2);
+
+    int value{};
+    buffer.try_pop(0, value);
+
+    // Act
+
+    buffer.assign(0, 1);
+
+    bool beforeHandover = buffer.try_pop(1, value);
+    bool moving         = buffer.stats()[0].moving;
+    bool oldOwner       = buffer.try_pop(0, value);     // передает раздел
+    bool newOwner       = buffer.try_pop(1, value);
+
+    // Assert
+
+    ASSERT_FALSE(beforeHandover);
+    ASSERT_TRUE(moving);
+    ASSERT_FALSE(oldOwner);
+    ASSERT_TRUE(newOwner);
+    ASSERT_EQ(value, 2);
+    ASSERT_EQ(buffer.owner(0), 1u);
+}
+
+TEST(circular_buffer_partitioned_mrmw_tests, assign_out_of_range)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_partitioned<int, int, identity_hash> buffer(8, 2, 2);
+    buffer.try_push_back(0, 1);
+
+    // Act
+
+    bool badConsumer  = buffer.assign(0, 2);
+    bool badPartition = buffer.assign(2, 0);
+
+    int value{};
+    bool popped = buffer.try_pop(0, value);
+
+    // Assert
+
+    ASSERT_FALSE(badConsumer);
+    ASSERT_FALSE(badPartition);
+    ASSERT_TRUE(popped);
+    ASSERT_EQ(buffer.owner(0), 0u);
+    ASSERT_FALSE(buffer.stats()[0].moving);
+}
+
+TEST(circular_buffer_partitioned_mrmw_tests, rebalance_moves_hot_partition)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_partitioned<int, int, identity_hash> buffer(64, 4, 2);
+
+    // читатель 0: разделы 0 (30) и 2 (10), читатель 1: разделы 1 (2) и 3 (0)
+    for(int i = 0; i < 30; ++i)
+        buffer.try_push_back(0, i);
+    for(int i = 0; i < 10; ++i)
+        buffer.try_push_back(2, i);
+    buffer.try_push_back(1, 0);
+    buffer.try_push_back(1, 1);
+
+    // Act
+
+    size_t moved = buffer.rebalance();
+    std::vector<connest::partition_stats> stats = buffer.stats();
+
+    // Assert
+
+    // 40 : 2 -> раздел 0 читателю 1 (10 : 32) -> раздел 1 читателю 0 (12 : 30)
+    ASSERT_EQ(moved, 2u);
+    ASSERT_EQ(stats[0].consumer, 1u);
+    ASSERT_EQ(stats[1].consumer, 0u);
+    ASSERT_EQ(stats[2].consumer, 0u);
+    ASSERT_EQ(stats[0].occupancy, 30u);
+    ASSERT_EQ(stats[2].capacity, 64u);
+}
+
+TEST(circular_buffer_partitioned_mrmw_tests, rebalance_hook)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_partitioned<int, int, identity_hash, connest::count_stats> buffer(8, 3, 3);
+    buffer.try_push_back(1, 1);
+
+    // Act
+
+    size_t seenPushes{0};
+    size_t moved = buffer.rebalance([&seenPushes](const std::vector<connest::partition_stats>& stats,
+                                                  size_t consumers) {
+        seenPushes = stats[1].counters.pushes;
+        // все разделы - последнему читателю
+        return std::vector<size_t>(stats.size(), consumers - 1);
+    });
+
+    // Assert
+
+    ASSERT_EQ(seenPushes, 1u);
+    ASSERT_EQ(moved, 2u);
+}
+
+TEST(circular_buffer_partitioned_mrmw_tests, per_key_fifo_with_rebalancing)
+{
+    // Arrange
+
+    const size_t writers = 2;
+    const size_t consumers = 3;
+    const int keys = 16;
+    const int perKey = 2000;
+
+    connest::CircularBuffer_mrmw_partitioned<event, int> buffer(64, 8, consumers);
+
+    // последний обработанный номер по ключу; ключ пишет один писатель
+    std::vector<std::atomic<int>> last(keys);
+    for(auto& l : last)
+        l.store(-1);
+
+    std::atomic_bool ordered{true};
+    std::atomic<size_t> received{0};
+    const size_t total = static_cast<size_t>(keys * perKey);
+
+    std::vector<std::thread> threads;
+
+    for(size_t w = 0; w < writers; ++w)
+        threads.emplace_back([&buffer, w, keys, perKey]() {
+            for(int n = 0; n < perKey; ++n)
+                for(int key = static_cast<int>(w); key < keys; key += static_cast<int>(writers))
+                    while(! buffer.try_push_back(key, event{key, n}))
+                        std::this_thread::yield();
+        });
+
+    for(size_t c = 0; c < consumers; ++c)
+        threads.emplace_back([&, c]() {
+            event item{};
+            while(received.load() < total) {
+                if(! buffer.try_pop(c, item)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                if(last[static_cast<size_t>(item.key)].exchange(item.sequence) != item.sequence - 1)
+                    ordered = false;
+
+                ++received;
+            }
+        });
+
+    // Act
+
+    // разделы переходят между читателями во время работы
+    size_t round = 0;
+    while(received.load() < total) {
+        for(size_t p = 0; p < buffer.partition_count(); ++p)
+            buffer.assign(p, (p + round) % consumers);
+        ++round;
+        std::this_thread::yield();
+    }
+
+    for(auto& thread : threads)
+        thread.join();
+
+    // Assert
+
+    ASSERT_TRUE(ordered.load());
+    ASSERT_EQ(received.load(), total);
+    ASSERT_GT(round, 0u);
+}
+
+#endif // TST_CIRCULAR_BUFFER_PARTITIONED_MRMW_H
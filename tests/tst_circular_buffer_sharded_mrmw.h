@@ -0,0 +1,148 @@
+#ifndef TST_CIRCULAR_BUFFER_SHARDED_MRMW_H
+#define TST_CIRCULAR_BUFFER_SHARDED_MRMW_H
+
+
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+using namespace testing;
+
+
+#include <circular_buffer/circular_buffer_fwd.h>
+#include <circular_buffer/circular_buffer_sharded_mrmw.h>
+#include <circular_buffer/circular_buffer_numa.h>
+
+
+TEST(circular_buffer_sharded_tests, prefers_local_shard)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_sharded<int> cb(4, 2);
+    connest::numa::set_current_node(1);
+
+    // Act
+
+    bool pushed = cb.try_push_back(7);
+
+    // Assert
+
+    connest::numa::set_current_node(-1);
+
+    ASSERT_TRUE(pushed);
+    ASSERT_EQ(cb.shard_count(), 2u);
+    ASSERT_EQ(cb.shard(1).size(), 1u);
+    ASSERT_TRUE(cb.shard(0).empty());
+}
+
+TEST(circular_buffer_sharded_tests, spills_and_steals)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_sharded<int> cb(2, 2);
+    connest::numa::set_current_node(0);
+
+    // Act
+
+    bool pushed = cb.try_push_back(1)
+               && cb.try_push_back(2)
+               && cb.try_push_back(3)     // шард 0 заполнен - в шард 1
+               && cb.try_push_back(4);
+    bool overflow = cb.try_push_back(5);
+
+    std::vector<int> values;
+    int value{};
+    while(cb.try_pop(value))
+        values.push_back(value);
+
+    // Assert
+
+    connest::numa::set_current_node(-1);
+
+    ASSERT_TRUE(pushed);
+    ASSERT_FALSE(overflow);
+    ASSERT_EQ(cb.max_size(), 4u);
+    ASSERT_THAT(values, ElementsAre(1, 2, 3, 4));
+    ASSERT_TRUE(cb.empty());
+}
+
+TEST(circular_buffer_sharded_tests, make_on_node)
+{
+    // Arrange, Act
+
+    auto object = connest::numa::make_on_node<std::vector<int>>(0, 3u, 5);
+
+    // Assert
+
+    ASSERT_THAT(*object, ElementsAre(5, 5, 5));
+    ASSERT_GE(connest::numa::node_count(), 1u);
+}
+
+TEST(circular_buffer_sharded_tests, mmap_numa_node)
+{
+    // Arrange
+
+    connest::mmap_options options;
+    options.numa_node = 0;
+    connest::mmap_allocator<int> allocator(options);
+
+    // Act
+
+    connest::mapping_info info;
+    void* memory = allocator.map(1024 * sizeof(int), info);
+
+    // Assert
+
+    ASSERT_NE(memory, nullptr);
+    static_cast<int*>(memory)[1023] = 1;
+    allocator.unmap(memory, 1024 * sizeof(int));
+}
+
+TEST(circular_buffer_sharded_tests, concurrent_sum)
+{
+    // Arrange
+
+    const int count = 20000;
+    connest::CircularBuffer_mrmw_sharded<int> cb(64, 2);
+    std::atomic<long long> sum{0};
+    std::atomic<int> read{0};
+
+    // Act
+
+    std::vector<std::thread> threads;
+    for(int node = 0; node < 2; ++node) {
+        threads.emplace_back([&, node]() {
+            connest::numa::set_current_node(node);
+            for(int n = 1; n <= count;) {
+                if(cb.try_push_back(n))
+                    ++n;
+                else
+                    std::this_thread::yield();
+            }
+        });
+        threads.emplace_back([&, node]() {
+            connest::numa::set_current_node(node);
+            int value{};
+            while(read < 2 * count) {
+                if(cb.try_pop(value)) {
+                    sum += value;
+                    ++read;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    for(auto& t : threads)
+        t.join();
+
+    // Assert
+
+    ASSERT_EQ(sum, 2ll * count * (count + 1) / 2);
+    ASSERT_TRUE(cb.empty());
+}
+
+#endif // TST_CIRCULAR_BUFFER_SHARDED_MRMW_H
@@ -0,0 +1,274 @@
+#ifndef TST_CIRCULAR_BUFFER_STAGING_H
+#define TST_CIRCULAR_BUFFER_STAGING_H
+
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+using namespace testing;
+
+
+#include <circular_buffer/circular_buffer_fwd.h>
+#include <circular_buffer/circular_buffer_staging.h>
+
+
+TEST(circular_buffer_staging_tests, flush_when_full)
+{
+    // Arrange
+
+    using buffer_type = connest::CircularBuffer_mrmw<int>;
+    buffer_type buffer(16);
+    connest::staging_buffer<buffer_type> staging(buffer, 4, std::chrono::nanoseconds::zero());
+
+    // Act
+
+    for(int i = 1; i <= 3; ++i)
+        staging.try_push_back(i);
+    size_t beforeFull = buffer.size();
+
+    staging.try_push_back(4);
+    size_t afterFull = buffer.size();
+
+    staging.try_push_back(5);
+
+    // Assert
+
+    ASSERT_EQ(beforeFull, 0u);
+    ASSERT_EQ(afterFull, 4u);
+    ASSERT_EQ(staging.pending(), 1u);
+}
+
+TEST(circular_buffer_staging_tests, explicit_flush)
+{
+    // Arrange
+
+    using buffer_type = connest::CircularBuffer_mrmw<int>;
+    buffer_type buffer(16);
+    connest::staging_buffer<buffer_type> staging(buffer, 8, std::chrono::nanoseconds::zero());
+
+    // Act
+
+    staging.try_push_back(1);
+    staging.try_push_back(2);
+    size_t flushed = staging.flush();
+
+    std::vector<int> values;
+    buffer.pop_all(values);
+
+    // Assert
+
+    ASSERT_EQ(flushed, 2u);
+    ASSERT_EQ(staging.pending(), 0u);
+    ASSERT_THAT(values, ElementsAre(1, 2));
+}
+
+TEST(circular_buffer_staging_tests, full_buffer)
+{
+    // Arrange
+
+    using buffer_type = connest::CircularBuffer_mrmw<int>;
+    buffer_type buffer(3);
+    connest::staging_buffer<buffer_type> staging(buffer, 2, std::chrono::nanoseconds::zero());
+
+    // Act
+
+    bool results[6];
+    for(int i = 0; i < 6; ++i)
+        results[i] = staging.try_push_back(i);
+
+    std::vector<int> values;
+    buffer.pop_all(values);
+    size_t flushed = staging.flush_all();
+
+    // Assert
+
+    // 0, 1, 2 - в буфере; 3, 4 - в накопителе без места в буфере;
+    // 5 - накопитель заполнен
+    ASSERT_TRUE(results[0] && results[1] && results[2] && results[3] && results[4]);
+    ASSERT_FALSE(results[5]);
+    ASSERT_THAT(values, ElementsAre(0, 1, 2));
+    ASSERT_EQ(flushed, 2u);
+}
+
+TEST(circular_buffer_staging_tests, timer_flush)
+{
+    // Arrange
+
+    using buffer_type = connest::CircularBuffer_mrmw_blocked<int>;
+    buffer_type buffer(16);
+    connest::staging_buffer<buffer_type> staging(buffer, 64, std::chrono::milliseconds(2));
+
+    // Act
+
+    auto start = std::chrono::steady_clock::now();
+    staging.try_push_back(42);
+
+    int value{0};
+    bool popped = buffer.pop_wait_for(value, std::chrono::seconds(10)) == connest::WaitStatus::success;
+    auto latency = std::chrono::steady_clock::now() - start;
+
+    // Assert
+
+    ASSERT_TRUE(popped);
+    ASSERT_EQ(value, 42);
+    ASSERT_EQ(staging.pending(), 0u);
+    // граница max_latency плюс запас на планировщик
+    ASSERT_LT(latency, std::chrono::seconds(1));
+}
+
+TEST(circular_buffer_staging_tests, destructor_flushes)
+{
+    // Arrange
+
+    using buffer_type = connest::CircularBuffer_mrmw_blocked<int>;
+    buffer_type buffer(16);
+
+    // Act
+
+    {
+        connest::staging_buffer<buffer_type> staging(buffer, 8, std::chrono::seconds(10));
+        staging.try_push_back(1);
+        staging.try_push_back(2);
+
+        std::thread([&staging]() { staging.try_push_back(3); }).join();
+    }
+
+    std::vector<int> values;
+    while(! buffer.empty()) {
+        int value{0};
+        buffer.try_pop(value);
+        values.push_back(value);
+    }
+
+    // Assert
+
+    ASSERT_THAT(values, UnorderedElementsAre(1, 2, 3));
+}
+
+TEST(circular_buffer_staging_tests, destructor_after_shutdown)
+{
+    // Arrange
+
+    using buffer_type = connest::CircularBuffer_mrmw_blocked<int>;
+    buffer_type buffer(2);
+
+    // Act
+
+    {
+        connest::staging_buffer<buffer_type> staging(buffer, 8, std::chrono::nanoseconds(0));
+        for(int i = 1; i <= 4; ++i)
+            staging.try_push_back(i);
+
+        staging.flush();   // места хватает только на два элемента
+        buffer.shutdown(); // читателей больше не будет
+    }
+
+    // Assert
+
+    ASSERT_EQ(buffer.size(), 2u);
+}
+
+namespace {
+
+struct staging_poison {};
+
+struct staging_item
+{
+    int value = 0;
+
+    staging_item() = default;
+    staging_item(int v) : value(v) {}
+    staging_item(staging_poison) { throw std::runtime_error("staging_item"); }
+};
+
+}
+
+TEST(circular_buffer_staging_tests, throwing_element_releases_stage)
+{
+    // Arrange
+
+    using buffer_type = connest::CircularBuffer_mrmw<staging_item>;
+    buffer_type buffer(16);
+    connest::staging_buffer<buffer_type> staging(buffer, 4, std::chrono::milliseconds(1));
+
+    staging.try_push_back(1);
+
+    // Act
+
+    bool thrown = false;
+    try {
+        staging.try_push_back(staging_poison{});
+    } catch(const std::runtime_error&) {
+        thrown = true;
+    }
+
+    bool pushed = staging.try_push_back(2);
+    staging.flush_all();    // таймер тоже мог отправить элементы
+
+    // Assert
+
+    ASSERT_TRUE(thrown);
+    ASSERT_TRUE(pushed);
+    ASSERT_EQ(buffer.size(), 2u);
+    ASSERT_EQ(staging.pending(), 0u);
+}
+
+TEST(circular_buffer_staging_tests, per_thread_order)
+{
+    // Arrange
+
+    using buffer_type = connest::CircularBuffer_mrmw<int>;
+    buffer_type buffer(64);
+    connest::staging_buffer<buffer_type> staging(buffer, 8, std::chrono::microseconds(200));
+
+    const int writers = 4;
+    const int count = 5000;
+
+    auto write = [&staging](int writer) {
+        for(int i = 0; i < count; ++i) {
+            int value = writer * count + i;
+            while(! staging.try_push_back(value))
+                std::this_thread::yield();
+        }
+        staging.flush();
+    };
+
+    // Act
+
+    std::vector<std::thread> threads;
+    for(int w = 0; w < writers; ++w)
+        threads.emplace_back(write, w);
+
+    std::vector<int> last(writers, -1);
+    bool ordered = true;
+    int received = 0;
+
+    while(received < writers * count) {
+        int value{0};
+        if(! buffer.try_pop(value)) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        int writer = value / count;
+        ordered = ordered && value % count == last[writer] + 1;
+        last[writer] = value % count;
+        ++received;
+    }
+
+    for(auto& thread : threads)
+        thread.join();
+
+    // Assert
+
+    ASSERT_TRUE(ordered);
+    ASSERT_EQ(received, writers * count);
+    ASSERT_EQ(staging.pending(), 0u);
+}
+
+
+#endif // TST_CIRCULAR_BUFFER_STAGING_H
@@ -0,0 +1,309 @@
+#ifndef TST_CIRCULAR_BUFFER_STRESS_H
+#define TST_CIRCULAR_BUFFER_STRESS_H
+
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+using namespace testing;
+
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+#include <cstdlib>
+
+#include <circular_buffer/circular_buffer_fwd.h>
+#include <circular_buffer/circular_buffer_basic.h>
+#include <circular_buffer/circular_buffer_blocked_mrmw.h>
+#include <circular_buffer/circular_buffer_twolock_mrmw.h>
+#include <circular_buffer/circular_buffer_combining_mrmw.h>
+#include <circular_buffer/circular_buffer_stats.h>
+#include <circular_buffer/circular_buffer_spin.h>
+
+#include "stress_history.h"
+
+// Случайные нагрузки с журналом операций и проверкой линеаризуемости.
+// Предназначены для сборки с ThreadSanitizer (CircularBuffer_stress):
+// значение лежит в куче, поэтому недостаточный порядок памяти при
+// передаче ячейки виден как гонка данных.
+//
+// CIRCULAR_BUFFER_STRESS_ROUNDS - количество раундов на вариант (16),
+// CIRCULAR_BUFFER_STRESS_SEED   - начальное значение генератора.
+
+namespace stress {
+
+/**
+ * @brief Элемент, владеющий значением в куче (только перемещение)
+ */
+struct payload
+{
+    std::unique_ptr<uint64_t> value;
+
+    payload() = default;
+    explicit payload(uint64_t v) : value(new uint64_t(v)) {}
+};
+
+inline size_t env(const char* name, size_t fallback)
+{
+    const char* value = std::getenv(name);
+    return value ? static_cast<size_t>(std::strtoull(value, nullptr, 10)) : fallback;
+}
+
+// несколько итераций cpu_relax между операциями - разные чередования
+inline void jitter(std::mt19937& random)
+{
+    for(unsigned n = random() % 32; n != 0; --n)
+        connest::detail::cpu_relax();
+}
+
+/**
+ * @brief Один раунд: писатели и читатели со случайным выбором операций
+ * @return пустая строка или описание нарушения
+ */
+template<typename Queue>
+std::string run_round(size_t producers, size_t consumers, size_t capacity,
+                      size_t per_producer, bool check_empty, uint32_t seed)
+{
+    Queue queue(capacity);
+
+    std::vector<history> logs(producers + consumers);
+    std::atomic<size_t> popped{0};
+    const size_t total = producers * per_producer;
+
+    std::vector<std::thread> threads;
+
+    for(size_t p = 0; p < producers; ++p)
+        threads.emplace_back([&, p]() {
+            std::mt19937 random(seed + static_cast<uint32_t>(p));
+            history& log = logs[p];
+
+            for(size_t i = 0; i < per_producer; ) {
+                uint64_t value = (static_cast<uint64_t>(p) << 32) | i;
+                bool wait = random() % 4 == 0;
+
+                int64_t invoke = now();
+                bool pushed = wait ? queue.push_back_wait(payload(value)) == connest::WaitStatus::success
+                                   : queue.try_push_back(payload(value));
+                int64_t response = now();
+
+                if(pushed) {
+                    log.pushes.push_back(operation{invoke, response, value});
+                    ++i;
+                }
+                else
+                    std::this_thread::yield();
+
+                jitter(random);
+            }
+        });
+
+    for(size_t c = 0; c < consumers; ++c)
+        threads.emplace_back([&, c]() {
+            std::mt19937 random(seed + static_cast<uint32_t>(producers + c));
+            history& log = logs[producers + c];
+
+            // relaxed: счетчик не должен синхронизировать потоки
+            while(popped.load(std::memory_order_relaxed) < total) {
+                bool wait = random() % 4 == 0;
+                payload item;
+
+                int64_t invoke = now();
+                connest::WaitStatus status = wait ? queue.pop_wait(item)
+                                                  : (queue.try_pop(item) ? connest::WaitStatus::success
+                                                                         : connest::WaitStatus::timeout);
+                int64_t response = now();
+
+                if(status == connest::WaitStatus::success) {
+                    log.pops.push_back(operation{invoke, response, *item.value});
+                    popped.fetch_add(1, std::memory_order_relaxed);
+                }
+                else if(! wait) {
+                    log.empty_pops.push_back(operation{invoke, response, 0});
+                    std::this_thread::yield();
+                }
+
+                jitter(random);
+            }
+        });
+
+    // будит читателей, ждущих в pop_wait после извлечения последнего элемента
+    while(popped.load(std::memory_order_relaxed) < total)
+        std::this_thread::yield();
+    queue.shutdown();
+
+    for(auto& thread : threads)
+        thread.join();
+
+    history merged;
+    for(const history& log : logs)
+        merged.append(log);
+
+    return check(merged, check_empty);
+}
+
+/**
+ * @brief Раунды со случайными размером буфера и количеством потоков
+ */
+template<typename Queue>
+void run(bool multi_producer, bool multi_consumer, bool check_empty)
+{
+    const size_t rounds = env("CIRCULAR_BUFFER_STRESS_ROUNDS", 16);
+    const uint32_t seed = static_cast<uint32_t>(env("CIRCULAR_BUFFER_STRESS_SEED", std::random_device{}()));
+
+    std::mt19937 random(seed);
+    const size_t capacities[] = {1, 2, 3, 5, 16, 64};
+
+    for(size_t r = 0; r < rounds; ++r) {
+        size_t capacity  = capacities[random() % 6];
+        size_t producers = multi_producer ? 1 + random() % 3 : 1;
+        size_t consumers = multi_consumer ? 1 + random() % 3 : 1;
+
+        std::string error = run_round<Queue>(producers, consumers, capacity, 2000,
+                                             check_empty, static_cast<uint32_t>(random()));
+
+        ASSERT_EQ(error, "") << "seed " << seed << ", round " << r
+                             << ": capacity " << capacity
+                             << ", producers " << producers << ", consumers " << consumers;
+    }
+}
+
+}
+
+
+TEST(circular_buffer_stress_tests, checker_accepts_sequential)
+{
+    // Arrange
+
+    stress::history log;
+    log.pushes     = {{0, 1, 10}, {2, 3, 20}};
+    log.empty_pops = {{8, 9, 0}};
+    log.pops       = {{4, 5, 10}, {6, 7, 20}};
+
+    // Act
+
+    std::string error = stress::check(log, true);
+
+    // Assert
+
+    ASSERT_EQ(error, "");
+}
+
+TEST(circular_buffer_stress_tests, checker_detects_reorder)
+{
+    // Arrange
+
+    stress::history log;
+    log.pushes = {{0, 1, 10}, {2, 3, 20}};
+    log.pops   = {{6, 7, 10}, {4, 5, 20}};
+
+    // Act
+
+    std::string error = stress::check(log, true);
+
+    // Assert
+
+    ASSERT_THAT(error, HasSubstr("FIFO"));
+}
+
+TEST(circular_buffer_stress_tests, checker_detects_false_empty)
+{
+    // Arrange
+
+    stress::history log;
+    log.pushes     = {{0, 1, 10}};
+    log.empty_pops = {{2, 3, 0}};
+    log.pops       = {{4, 5, 10}};
+
+    // Act
+
+    std::string error   = stress::check(log, true);
+    std::string relaxed = stress::check(log, false);
+
+    // Assert
+
+    ASSERT_THAT(error, HasSubstr("try_pop failed"));
+    ASSERT_EQ(relaxed, "");
+}
+
+TEST(circular_buffer_stress_tests, checker_detects_loss_and_duplicate)
+{
+    // Arrange
+
+    stress::history lost;
+    lost.pushes = {{0, 1, 10}, {2, 3, 20}};
+    lost.pops   = {{4, 5, 10}};
+
+    stress::history duplicate;
+    duplicate.pushes = {{0, 1, 10}};
+    duplicate.pops   = {{2, 3, 10}, {4, 5, 10}};
+
+    // Act
+
+    std::string lostError      = stress::check(lost, true);
+    std::string duplicateError = stress::check(duplicate, true);
+
+    // Assert
+
+    ASSERT_THAT(lostError, HasSubstr("lost"));
+    ASSERT_THAT(duplicateError, HasSubstr("twice"));
+}
+
+TEST(circular_buffer_stress_tests, srsw)
+{
+    stress::run<connest::CircularBuffer_srsw<stress::payload>>(false, false, true);
+}
+
+TEST(circular_buffer_stress_tests, mpsc)
+{
+    // завершенная запись может ждать более ранних - пустота не проверяется
+    stress::run<connest::basic_circular_buffer<stress::payload,
+                                               connest::multi_producer,
+                                               connest::single_consumer>>(true, false, false);
+}
+
+TEST(circular_buffer_stress_tests, spmc)
+{
+    stress::run<connest::basic_circular_buffer<stress::payload,
+                                               connest::single_producer,
+                                               connest::multi_consumer>>(false, true, true);
+}
+
+TEST(circular_buffer_stress_tests, mrmw)
+{
+    stress::run<connest::CircularBuffer_mrmw<stress::payload>>(true, true, false);
+}
+
+TEST(circular_buffer_stress_tests, mrmw_park_wait)
+{
+    stress::run<connest::basic_circular_buffer<stress::payload,
+                                               connest::multi_producer,
+                                               connest::multi_consumer,
+                                               connest::park_wait>>(true, true, false);
+}
+
+TEST(circular_buffer_stress_tests, mrmw_dwell_stats)
+{
+    stress::run<connest::basic_circular_buffer<stress::payload,
+                                               connest::multi_producer,
+                                               connest::multi_consumer,
+                                               connest::spin_wait,
+                                               connest::vector_storage<stress::payload>,
+                                               connest::dwell_stats<>>>(true, true, false);
+}
+
+TEST(circular_buffer_stress_tests, blocked)
+{
+    stress::run<connest::CircularBuffer_mrmw_blocked<stress::payload>>(true, true, true);
+}
+
+TEST(circular_buffer_stress_tests, twolock)
+{
+    stress::run<connest::CircularBuffer_mrmw_twolock<stress::payload>>(true, true, true);
+}
+
+TEST(circular_buffer_stress_tests, combining)
+{
+    stress::run<connest::CircularBuffer_mrmw_combining<stress::payload>>(true, true, true);
+}
+
+#endif // TST_CIRCULAR_BUFFER_STRESS_H
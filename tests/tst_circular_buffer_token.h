@@ -0,0 +1,218 @@
+#ifndef TST_CIRCULAR_BUFFER_TOKEN_H
+#define TST_CIRCULAR_BUFFER_TOKEN_H
+
+
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+using namespace testing;
+
+
+#include <circular_buffer/circular_buffer_fwd.h>
+#include <circular_buffer/circular_buffer_token.h>
+
+
+TEST(circular_buffer_token_tests, producer_block)
+{
+    // Arrange
+
+    using buffer_type = connest::CircularBuffer_mrmw<int>;
+    buffer_type buffer(16);
+    connest::producer_token<buffer_type> token(buffer, 4);
+
+    // Act
+
+    for(int i = 1; i <= 3; ++i)
+        token.try_push_back(i);
+    size_t beforeBlock = buffer.size();
+
+    token.try_push_back(4);
+    size_t afterBlock = buffer.size();
+
+    token.try_push_back(5);
+    size_t flushed = token.flush();
+
+    // Assert
+
+    ASSERT_EQ(beforeBlock, 0u);
+    ASSERT_EQ(afterBlock, 4u);
+    ASSERT_EQ(flushed, 1u);
+    ASSERT_EQ(token.pending(), 0u);
+    ASSERT_EQ(buffer.size(), 5u);
+}
+
+TEST(circular_buffer_token_tests, producer_full_buffer)
+{
+    // Arrange
+
+    using buffer_type = connest::CircularBuffer_mrmw<int>;
+    buffer_type buffer(3);
+    connest::producer_token<buffer_type> token(buffer, 2);
+
+    // Act
+
+    bool results[6];
+    for(int i = 0; i < 6; ++i)
+        results[i] = token.try_push_back(i);
+
+    std::vector<int> values;
+    buffer.pop_all(values);
+    size_t flushed = token.flush();
+
+    // Assert
+
+    // 0, 1, 2 - в буфере; 3, 4 - отложенная серия, для которой нет
+    // места; 5 - серия заполнена
+    ASSERT_TRUE(results[0] && results[1] && results[2] && results[3] && results[4]);
+    ASSERT_FALSE(results[5]);
+    ASSERT_THAT(values, ElementsAre(0, 1, 2));
+    ASSERT_EQ(flushed, 2u);
+    ASSERT_EQ(token.pending(), 0u);
+}
+
+TEST(circular_buffer_token_tests, producer_destructor_flushes)
+{
+    // Arrange
+
+    using buffer_type = connest::CircularBuffer_mrmw<int>;
+    buffer_type buffer(8);
+
+    // Act
+
+    {
+        connest::producer_token<buffer_type> token(buffer, 64);
+        token.try_push_back(7);
+        token.try_push_back(8);
+    }
+
+    // Assert
+
+    ASSERT_EQ(buffer.size(), 2u);
+}
+
+TEST(circular_buffer_token_tests, producer_destructor_after_shutdown)
+{
+    // Arrange
+
+    using buffer_type = connest::CircularBuffer_mrmw<int>;
+    buffer_type buffer(2);
+
+    // Act
+
+    {
+        connest::producer_token<buffer_type> token(buffer, 64);
+        for(int i = 1; i <= 4; ++i)
+            token.try_push_back(i);
+
+        token.flush();     // места хватает только на два элемента
+        buffer.shutdown(); // читателей больше не будет
+    }
+
+    // Assert
+
+    ASSERT_EQ(buffer.size(), 2u);
+}
+
+TEST(circular_buffer_token_tests, consumer_block)
+{
+    // Arrange
+
+    using buffer_type = connest::CircularBuffer_mrmw<int>;
+    buffer_type buffer(16);
+    for(int i = 1; i <= 5; ++i)
+        buffer.try_push_back(i);
+
+    connest::consumer_token<buffer_type> token(buffer, 3);
+
+    // Act
+
+    int first{}, second{};
+    token.try_pop(first);
+    size_t cached = token.pending();
+    size_t left   = buffer.size();
+    token.try_pop(second);
+
+    std::vector<int> rest;
+    int value{};
+    while(token.try_pop(value))
+        rest.push_back(value);
+
+    // Assert
+
+    ASSERT_EQ(first, 1);
+    ASSERT_EQ(second, 2);
+    ASSERT_EQ(cached, 2u);
+    ASSERT_EQ(left, 2u);
+    ASSERT_THAT(rest, ElementsAre(3, 4, 5));
+}
+
+TEST(circular_buffer_token_tests, concurrent_tokens)
+{
+    // Arrange
+
+    const size_t writers = 3;
+    const size_t readers = 2;
+    const int count = 30000;
+
+    using buffer_type = connest::CircularBuffer_mrmw<int>;
+    buffer_type buffer(128);
+
+    std::vector<std::atomic<int>> seen(writers * count);
+    for(auto& s : seen)
+        s.store(0);
+
+    std::atomic<size_t> received{0};
+    std::atomic_bool ordered{true};
+    std::vector<std::thread> threads;
+
+    for(size_t w = 0; w < writers; ++w)
+        threads.emplace_back([&buffer, w, count]() {
+            connest::producer_token<buffer_type> token(buffer, 16);
+            int base = static_cast<int>(w) * count;
+            for(int i = 0; i < count;) {
+                if(token.try_push_back(base + i))
+                    ++i;
+                else
+                    std::this_thread::yield();
+            }
+        });
+
+    // Act
+
+    for(size_t r = 0; r < readers; ++r)
+        threads.emplace_back([&]() {
+            connest::consumer_token<buffer_type> token(buffer, 8);
+            std::vector<int> last(writers, -1);
+            int value{};
+
+            while(received.load() < writers * count) {
+                if(! token.try_pop(value)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                // порядок писателя сохраняется и для каждого читателя
+                size_t w = static_cast<size_t>(value / count);
+                if(value % count <= last[w])
+                    ordered = false;
+                last[w] = value % count;
+
+                seen[static_cast<size_t>(value)].fetch_add(1);
+                ++received;
+            }
+        });
+
+    for(auto& thread : threads)
+        thread.join();
+
+    // Assert
+
+    ASSERT_TRUE(ordered.load());
+    for(size_t i = 0; i < seen.size(); ++i)
+        ASSERT_EQ(seen[i].load(), 1) << "value " << i;
+}
+
+#endif // TST_CIRCULAR_BUFFER_TOKEN_H
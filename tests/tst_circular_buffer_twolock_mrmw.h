@@ -0,0 +1,453 @@
+#ifndef TST_CIRCULAR_BUFFER_TWOLOCK_MRMW_H
+#define TST_CIRCULAR_BUFFER_TWOLOCK_MRMW_H
+
+
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+using namespace testing;
+
+
+#include <circular_buffer/circular_buffer_fwd.h>
+#include <circular_buffer/circular_buffer_twolock_mrmw.h>
+
+
+TEST(circular_buffer_twolock_tests, is_empty)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_twolock<int> cb(40);
+
+    // Act
+
+    bool is_empty = cb.empty();
+
+    // Assert
+
+    ASSERT_TRUE(is_empty);
+}
+
+TEST(circular_buffer_twolock_tests, max_size)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_twolock<int> cb(40);
+
+    // Act
+
+    size_t max_size = cb.max_size();
+
+    // Assert
+
+    ASSERT_EQ(max_size, 40u);
+}
+
+TEST(circular_buffer_twolock_tests, size_and_push_back)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_twolock<int> cb(40);
+    cb.try_push_back(2);
+    cb.try_push_back(3);
+
+    // Act
+
+    size_t size = cb.size();
+
+    // Assert
+
+    ASSERT_EQ(size, 2u);
+
+    int value;
+    cb.try_pop(value);
+    ASSERT_EQ(value, 2);
+
+    cb.try_pop(value);
+    ASSERT_EQ(value, 3);
+}
+
+
+TEST(circular_buffer_twolock_tests, is_full)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_twolock<int> cb(2);
+    cb.try_push_back(1);
+    cb.try_push_back(2);
+
+    // Act
+
+    bool full = cb.full();
+
+    // Assert
+
+    ASSERT_TRUE(full);
+    ASSERT_EQ(cb.size(), 2u);
+}
+
+TEST(circular_buffer_twolock_tests, push_to_full)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_twolock<int> cb(2);
+    cb.try_push_back(1);
+
+    // Act
+
+    bool to_not_full = cb.try_push_back(1);
+    bool to_full = cb.try_push_back(3);
+    bool full = cb.full();
+    size_t size = cb.size();
+
+    // Assert
+
+    ASSERT_TRUE(to_not_full);
+    ASSERT_FALSE(to_full);
+    ASSERT_TRUE(full);
+    ASSERT_EQ(size, 2u);
+}
+
+TEST(circular_buffer_twolock_tests, is_full_zero_size)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_twolock<int> cb(0);
+
+    // Act
+
+    bool full = cb.full();
+    bool empty = cb.empty();
+
+    // Assert
+
+    ASSERT_TRUE(full);
+    ASSERT_TRUE(empty);
+    ASSERT_EQ(cb.size(), 0u);
+}
+
+TEST(circular_buffer_twolock_tests, pop_from_empty)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_twolock<int> cb(0);
+
+
+    // Act
+    int value{};
+    bool success = cb.try_pop(value);
+
+    // Assert
+    ASSERT_FALSE(success);
+
+}
+
+TEST(circular_buffer_twolock_tests, pop)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_twolock<int> cb(10);
+    cb.try_push_back(100);
+
+    // Act
+
+    int value{};
+    cb.try_pop(value);
+
+    // Assert
+
+    ASSERT_EQ(value, 100);
+    ASSERT_TRUE(cb.empty());
+}
+
+
+TEST(circular_buffer_twolock_tests, pop_push)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_twolock<int> cb(3);
+    int value;
+
+    // Act
+
+    cb.try_push_back(1);
+    cb.try_push_back(2);
+    cb.try_push_back(3);
+
+
+    cb.try_pop(value); // read value = 1
+    cb.try_push_back(4);
+
+
+    // Assert
+
+    ASSERT_TRUE(cb.full());
+    ASSERT_EQ(cb.size(), 3u);
+
+    cb.try_pop(value);
+    ASSERT_EQ(value, 2);
+
+    cb.try_pop(value);
+    ASSERT_EQ(value, 3);
+
+    cb.try_pop(value);
+    ASSERT_EQ(value, 4);
+
+}
+
+TEST(circular_buffer_twolock_tests, full_pop_push)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_twolock<int> cb(3);
+    int value;
+
+    // Act
+
+    cb.try_push_back(1);
+    cb.try_push_back(2);
+    cb.try_push_back(3);
+
+    // now full
+
+    cb.try_pop(value); // read value = 1
+    cb.try_push_back(4);
+    cb.try_pop(value);
+    cb.try_pop(value);
+
+    // writePos < readPos
+    cb.try_push_back(5);
+    cb.try_push_back(6);
+
+
+    // Assert
+
+    ASSERT_TRUE(cb.full());
+    ASSERT_EQ(cb.size(), 3u);
+
+    cb.try_pop(value);
+    ASSERT_EQ(value, 4);
+
+    cb.try_pop(value);
+    ASSERT_EQ(value, 5);
+
+    cb.try_pop(value);
+    ASSERT_EQ(value, 6);
+
+}
+
+
+
+
+TEST(circular_buffer_twolock_tests, blocked_pop_wait)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_twolock<int> cb(10);
+
+    auto read = [&cb]() mutable {
+        int value{};
+
+        cb.pop_wait(value); // wait there
+
+        // Assert
+
+        ASSERT_EQ(value, 666);
+    };
+
+    auto write = [&cb]() mutable {
+        cb.try_push_back(666);
+
+    };
+
+    // Act
+
+
+
+    auto reader = std::thread(read);
+
+    // to be sure, that reader in wait
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+
+    auto writter = std::thread(write);
+
+
+    writter.join();
+    reader.join();
+}
+TEST(circular_buffer_twolock_tests, blocked_push_back_wait)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_twolock<int> cb(2);
+    cb.try_push_back(1);
+    cb.try_push_back(2); // full now
+
+
+    auto read = [&cb]() mutable {
+        int value{};
+        cb.try_pop(value);
+    };
+
+    auto write = [&cb]() mutable {
+
+        // Assert
+
+        cb.push_back_wait(666); // wait there
+        int value{};
+        cb.try_pop(value);
+        cb.try_pop(value);
+
+        ASSERT_EQ(value, 666);
+    };
+
+    // Act
+
+    auto writter = std::thread(write);
+
+    // to be sure, that writter in wait
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+
+    auto reader = std::thread(read);
+
+
+    reader.join();
+    writter.join();
+}
+
+TEST(circular_buffer_twolock_tests, mixed_waiters_no_lost_wakeup)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_twolock<int> cb(1);
+
+    const int threads = 4;
+    const int per_thread = 2000;
+
+    std::atomic<long> sum{0};
+
+    auto read = [&]() {
+        int value{};
+        for(int i = 0; i < per_thread; ++i) {
+            cb.pop_wait(value); // wait there
+            sum += value;
+        }
+    };
+
+    auto write = [&]() {
+        for(int i = 1; i <= per_thread; ++i)
+            cb.push_back_wait(i); // wait there
+    };
+
+    // Act
+
+    std::vector<std::thread> workers;
+    for(int i = 0; i < threads; ++i) {
+        workers.emplace_back(read);
+        workers.emplace_back(write);
+    }
+
+    for(auto& w : workers)
+        w.join();
+
+    // Assert
+
+    ASSERT_EQ(sum, threads * (per_thread * (per_thread + 1L) / 2));
+    ASSERT_TRUE(cb.empty());
+}
+
+TEST(circular_buffer_twolock_tests, pop_wait_for_timeout)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_twolock<int> cb(2);
+    int value{42};
+
+    // Act
+
+    auto status = cb.pop_wait_for(value, std::chrono::milliseconds(20));
+
+    // Assert
+
+    ASSERT_EQ(status, connest::WaitStatus::timeout);
+    ASSERT_EQ(value, 42);
+}
+
+TEST(circular_buffer_twolock_tests, push_back_wait_until_timeout)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_twolock<int> cb(1);
+    cb.try_push_back(1); // full now
+
+    // Act
+
+    auto deadline = std::chrono::steady_clock::now()
+                  + std::chrono::milliseconds(20);
+    auto status = cb.push_back_wait_until(2, deadline);
+
+    // Assert
+
+    ASSERT_EQ(status, connest::WaitStatus::timeout);
+    ASSERT_EQ(cb.size(), 1u);
+}
+
+TEST(circular_buffer_twolock_tests, pop_wait_for_success)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_twolock<int> cb(2);
+
+    auto write = [&cb]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        cb.try_push_back(666);
+    };
+
+    // Act
+
+    auto writter = std::thread(write);
+    int value{};
+    auto status = cb.pop_wait_for(value, std::chrono::seconds(10));
+    writter.join();
+
+    // Assert
+
+    ASSERT_EQ(status, connest::WaitStatus::success);
+    ASSERT_EQ(value, 666);
+}
+
+TEST(circular_buffer_twolock_tests, shutdown_wakes_waiters)
+{
+    // Arrange
+
+    connest::CircularBuffer_mrmw_twolock<int> cb(2);
+    int value{42};
+    connest::WaitStatus status{connest::WaitStatus::success};
+
+    auto read = [&]() {
+        status = cb.pop_wait(value); // wait there
+    };
+
+    // Act
+
+    auto reader = std::thread(read);
+
+    // to be sure, that reader in wait
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    cb.shutdown();
+    reader.join();
+
+    // Assert
+
+    ASSERT_EQ(status, connest::WaitStatus::shutdown);
+    ASSERT_EQ(value, 42);
+    ASSERT_EQ(cb.push_back_wait_for(1, std::chrono::milliseconds(1)),
+              connest::WaitStatus::shutdown);
+}
+
+#endif // TST_CIRCULAR_BUFFER_TWOLOCK_MRMW_H
@@ -0,0 +1,140 @@
+#ifndef TST_CIRCULAR_BUFFER_WORK_STEALING_H
+#define TST_CIRCULAR_BUFFER_WORK_STEALING_H
+
+
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+using namespace testing;
+
+
+#include <circular_buffer/circular_buffer_fwd.h>
+#include <circular_buffer/circular_buffer_work_stealing.h>
+
+
+TEST(work_stealing_deque_tests, owner_lifo_thief_fifo)
+{
+    // Arrange
+
+    connest::WorkStealingDeque<int> deque(8);
+    for(int i = 1; i <= 4; ++i)
+        deque.push(i);
+
+    // Act
+
+    int popped{}, stolen{};
+    bool pop   = deque.try_pop(popped);
+    bool steal = deque.try_steal(stolen);
+
+    // Assert
+
+    ASSERT_TRUE(pop);
+    ASSERT_TRUE(steal);
+    ASSERT_EQ(popped, 4);
+    ASSERT_EQ(stolen, 1);
+    ASSERT_EQ(deque.size(), 2u);
+}
+
+TEST(work_stealing_deque_tests, empty)
+{
+    // Arrange
+
+    connest::WorkStealingDeque<int> deque(4);
+    deque.push(1);
+
+    // Act
+
+    int value{};
+    bool first  = deque.try_pop(value);
+    bool second = deque.try_pop(value);
+    bool steal  = deque.try_steal(value);
+
+    // Assert
+
+    ASSERT_TRUE(first);
+    ASSERT_FALSE(second);
+    ASSERT_FALSE(steal);
+    ASSERT_TRUE(deque.empty());
+}
+
+TEST(work_stealing_deque_tests, grows_when_full)
+{
+    // Arrange
+
+    connest::WorkStealingDeque<int> deque(4);
+    int skipped{};
+    deque.push(0);
+    deque.try_steal(skipped);   // top != 0: перенос с ненулевого индекса
+
+    // Act
+
+    for(int i = 1; i <= 100; ++i)
+        deque.push(i);
+
+    std::vector<int> values;
+    int value{};
+    while(deque.try_steal(value))
+        values.push_back(value);
+
+    // Assert
+
+    ASSERT_GE(deque.capacity(), 128u);
+    ASSERT_EQ(values.size(), 100u);
+    for(int i = 0; i < 100; ++i)
+        ASSERT_EQ(values[static_cast<size_t>(i)], i + 1);
+}
+
+TEST(work_stealing_deque_tests, concurrent_owner_and_thieves)
+{
+    // Arrange
+
+    const int count = 200000;
+    const size_t thieves = 3;
+
+    connest::WorkStealingDeque<int> deque(16);
+    std::vector<std::atomic<int>> taken(count);
+    for(auto& t : taken)
+        t.store(0);
+
+    std::atomic_bool done{false};
+    std::vector<std::thread> threads;
+
+    for(size_t i = 0; i < thieves; ++i)
+        threads.emplace_back([&]() {
+            int value{};
+            while(! done.load()) {
+                if(deque.try_steal(value))
+                    taken[static_cast<size_t>(value)].fetch_add(1);
+                else
+                    std::this_thread::yield();
+            }
+        });
+
+    // Act
+
+    int value{};
+    for(int i = 0; i < count; ++i) {
+        deque.push(i);
+        // владелец забирает примерно треть своих элементов
+        if(i % 3 == 0 && deque.try_pop(value))
+            taken[static_cast<size_t>(value)].fetch_add(1);
+    }
+
+    while(deque.try_pop(value))
+        taken[static_cast<size_t>(value)].fetch_add(1);
+
+    // владелец опустошил деку; ждем воров, завершающих перехват
+    done = true;
+    for(auto& thread : threads)
+        thread.join();
+
+    // Assert
+
+    for(int i = 0; i < count; ++i)
+        ASSERT_EQ(taken[static_cast<size_t>(i)].load(), 1) << "value " << i;
+}
+
+#endif // TST_CIRCULAR_BUFFER_WORK_STEALING_H